@@ -0,0 +1,264 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    asset.c
+  * @brief   Asset manager
+  *          This file contains a RAM_G asset cache. A manifest of the loaded
+  *          assets is kept in RAM_G, so after a warm MCU reset unchanged
+  *          assets are verified with CMD_MEMCRC instead of re-uploaded.
+  *          Compressed assets and bundles made with tools/ftpack.c are
+  *          streamed through CMD_INFLATE / CMD_LOADIMAGE.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include "stm32f4xx.h"
+#include "ft800.h"
+#include "asset.h"
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t count;
+	uint32_t check;				/* checksum of count + entries */
+	ASSET_Entry_t entry[ASSET_MAX];
+} ASSET_Manifest_t;
+
+static ASSET_Manifest_t manifest;
+static uint8_t changed;
+
+/*** Helpers ***********************************************************************/
+static uint32_t asset_check(void)
+{
+	const uint32_t *p = (const uint32_t*)manifest.entry;
+	uint32_t n = manifest.count * (sizeof(ASSET_Entry_t)/4);
+	uint32_t hash = 0x811C9DC5UL ^ manifest.count;
+
+	while(n--)
+	{
+		hash = (hash ^ *p++) * 0x01000193UL;
+	}
+	return hash;
+}
+
+/* CMD_MEMCRC, returns 0 if the co-processor didn't finish (cmd_memcrc timed out) */
+static uint8_t asset_memcrc(uint32_t addr, uint32_t size, uint32_t *crc)
+{
+	*crc = cmd_memcrc(addr, size);
+	return cmd_ready();
+}
+
+static void asset_remove(uint32_t i)
+{
+	manifest.entry[i] = manifest.entry[--manifest.count];
+	changed = 1;
+}
+
+/*** Manifest **********************************************************************/
+void ASSET_invalidate(void)
+{
+	manifest.count = 0;
+	changed = 1;
+}
+
+/*
+    Function: ASSET_begin
+    ARGS:     none
+
+    Description: Reads the manifest left in RAM_G by a previous run. An invalid
+                 manifest (cold start, corrupted memory) is treated as empty.
+*/
+void ASSET_begin(void)
+{
+	HOST_MEM_READ_STR(ASSET_MANIFEST_ADDR, (uint8_t*)&manifest, sizeof(manifest));
+	changed = 0;
+
+	if(manifest.magic != ASSET_MAGIC || manifest.count > ASSET_MAX || manifest.check != asset_check())
+	{
+		ASSET_invalidate();
+	}
+}
+
+/*
+    Function: ASSET_end
+    ARGS:     none
+
+    Description: Writes the manifest back to RAM_G (only the used entries).
+*/
+void ASSET_end(void)
+{
+	if(!changed) return;
+
+	manifest.magic = ASSET_MAGIC;
+	manifest.check = asset_check();
+	HOST_MEM_WR_STR(ASSET_MANIFEST_ADDR, (uint8_t*)&manifest, 12 + manifest.count*sizeof(ASSET_Entry_t));
+	changed = 0;
+}
+
+/*
+    Function: ASSET_load
+    ARGS:     asset: asset description
+
+    Description: If the manifest lists the asset with the same version and
+                 location and CMD_MEMCRC of the region still matches, nothing
+                 is transferred. Otherwise the asset is uploaded and its CRC is
+                 recorded. Returns ASSET_CACHED, ASSET_UPLOADED or ASSET_ERROR
+                 (overlaps the manifest, manifest full - nothing is uploaded -
+                 or the co-processor doesn't answer).
+*/
+uint8_t ASSET_load(const ASSET_t *asset)
+{
+	uint32_t i, crc;
+
+	if(asset->addr + asset->size > ASSET_MANIFEST_ADDR) return ASSET_ERROR;
+
+	for(i=0; i<manifest.count; ++i)
+	{
+		ASSET_Entry_t *e = &manifest.entry[i];
+
+		if(e->id == asset->id &&
+		   e->version == asset->version && e->addr == asset->addr && e->size == asset->size)
+		{
+			if(!asset_memcrc(asset->addr, asset->size, &crc)) return ASSET_ERROR;
+			if(crc == e->crc) return ASSET_CACHED;
+		}
+	}
+
+	/* the upload overwrites this id and every asset overlapping the region */
+	i = 0;
+	while(i < manifest.count)
+	{
+		ASSET_Entry_t *e = &manifest.entry[i];
+
+		if(e->id == asset->id || (e->addr < asset->addr + asset->size && asset->addr < e->addr + e->size))
+		{
+			asset_remove(i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	if(manifest.count >= ASSET_MAX) return ASSET_ERROR;
+
+	HOST_MEM_WR_STR(asset->addr, (uint8_t*)asset->data, asset->size);
+	if(!asset_memcrc(asset->addr, asset->size, &crc)) return ASSET_ERROR;
+
+	manifest.entry[manifest.count].id = asset->id;
+	manifest.entry[manifest.count].version = asset->version;
+	manifest.entry[manifest.count].addr = asset->addr;
+	manifest.entry[manifest.count].size = asset->size;
+	manifest.entry[manifest.count].crc = crc;
+	++manifest.count;
+	changed = 1;
+	return ASSET_UPLOADED;
+}
+
+/*** Streaming *********************************************************************/
+static uint8_t asset_stream(ASSET_Reader_t read, void *ctx)
+{
+	static uint8_t chunk[ASSET_CHUNK];
+	uint32_t n;
+
+	do
+	{
+		n = read(ctx, chunk, ASSET_CHUNK);
+		if(n && !cmd_stream(chunk, n)) return 0;
+	} while(n == ASSET_CHUNK);
+
+	return 1;
+}
+
+/*
+    Function: ASSET_inflate
+    ARGS:     addr: RAM_G destination
+              read: reader callback returning the zlib stream
+              ctx:  passed to read
+
+    Description: Decompresses a zlib stream into RAM_G, feeding it to the
+                 co-processor chunk by chunk. Returns 0 on FIFO timeout.
+*/
+uint8_t ASSET_inflate(uint32_t addr, ASSET_Reader_t read, void *ctx)
+{
+	cmd_inflate(addr);
+	return asset_stream(read, ctx);
+}
+
+/*
+    Function: ASSET_loadimage
+    ARGS:     addr:    RAM_G destination
+              options: CMD_LOADIMAGE options (OPT_MONO, OPT_NODL)
+              read:    reader callback returning the JPEG file
+              ctx:     passed to read
+
+    Description: Decodes a JPEG into RAM_G, feeding it to the co-processor
+                 chunk by chunk. Returns 0 on FIFO timeout.
+*/
+uint8_t ASSET_loadimage(uint32_t addr, uint32_t options, ASSET_Reader_t read, void *ctx)
+{
+	cmd_loadimage(addr, options);
+	return asset_stream(read, ctx);
+}
+
+/*** Bundles ***********************************************************************/
+const ASSET_Bundle_Entry_t* ASSET_bundle_find(const uint8_t *bundle, uint32_t id)
+{
+	const uint32_t *header = (const uint32_t*)bundle;
+	const ASSET_Bundle_Entry_t *entry = (const ASSET_Bundle_Entry_t*)(bundle + 8);
+	uint32_t i;
+
+	if(header[0] != ASSET_BUNDLE_MAGIC) return 0;
+
+	for(i=0; i<header[1]; ++i)
+	{
+		if(entry[i].id == id) return &entry[i];
+	}
+	return 0;
+}
+
+/*
+    Function: ASSET_bundle_load
+    ARGS:     bundle:  bundle in memory-mapped flash
+              id:      entry id
+              addr:    RAM_G destination
+              options: CMD_LOADIMAGE options for JPEG entries
+
+    Description: Loads one bundle entry. Compressed entries go straight from
+                 flash into the co-processor FIFO, so only the compressed size
+                 crosses the SPI bus. JPEG entries are checked with their
+                 decoded size (RGB565, L8 with OPT_MONO). Returns 0 if the
+                 entry doesn't exist, doesn't fit or the FIFO timed out.
+*/
+uint8_t ASSET_bundle_load(const uint8_t *bundle, uint32_t id, uint32_t addr, uint32_t options)
+{
+	const ASSET_Bundle_Entry_t *e = ASSET_bundle_find(bundle, id);
+	uint32_t size;
+
+	if(!e) return 0;
+	if(e->type == ASSET_JPEG && !e->raw_size) return 0;	// no decoded size: packed by an old ftpack
+
+	size = (e->type == ASSET_JPEG && (options & OPT_MONO)) ? e->raw_size/2 : e->raw_size;
+	if(addr + size > ASSET_MANIFEST_ADDR) return 0;
+
+	switch(e->type)
+	{
+		case ASSET_RAW:
+			HOST_MEM_WR_STR(addr, (uint8_t*)(bundle + e->offset), e->size);
+			return 1;
+
+		case ASSET_ZLIB:
+			cmd_inflate(addr);
+			return cmd_stream(bundle + e->offset, e->size);
+
+		case ASSET_JPEG:
+			cmd_loadimage(addr, options);
+			return cmd_stream(bundle + e->offset, e->size);
+
+		default:
+			return 0;
+	}
+}
@@ -0,0 +1,82 @@
+#ifndef ASSET_H
+#define ASSET_H
+
+/* Asset manager
+ * Keeps a manifest of the assets loaded into RAM_G at the end of RAM_G. After a
+ * warm MCU reset (FT800 kept power) each asset is verified with CMD_MEMCRC and
+ * only re-uploaded if it changed or its memory was lost.
+ */
+#define ASSET_MAX               32
+#define ASSET_MAGIC             0x54455341UL    /* "ASET" */
+#define ASSET_RAM_G_SIZE        (256UL*1024)
+#define ASSET_MANIFEST_SIZE     (12 + ASSET_MAX*20)
+#define ASSET_MANIFEST_ADDR     (RAM_G + ASSET_RAM_G_SIZE - ASSET_MANIFEST_SIZE)   /* reserved, don't load assets here */
+
+/* ASSET_load() results */
+#define ASSET_CACHED            0               /* already in RAM_G, CRC verified */
+#define ASSET_UPLOADED          1               /* (re)uploaded */
+#define ASSET_ERROR             2               /* manifest full, asset overlaps it or co-processor timeout */
+
+/* Asset description, provided by the application */
+typedef struct
+{
+	uint32_t id;				/* application defined, unique */
+	uint32_t version;			/* must change whenever data changes (e.g. build number) */
+	uint32_t addr;				/* RAM_G address, should stay the same across resets */
+	uint32_t size;				/* bytes */
+	const uint8_t *data;
+} ASSET_t;
+
+/* Manifest entry, stored in RAM_G */
+typedef struct
+{
+	uint32_t id;
+	uint32_t version;
+	uint32_t addr;
+	uint32_t size;
+	uint32_t crc;				/* CMD_MEMCRC of the region after the upload */
+} ASSET_Entry_t;
+
+/* Compressed asset streaming
+ * Data is pushed through the co-processor FIFO in ASSET_CHUNK byte pieces, the
+ * whole asset is never held in MCU RAM. Don't stream between CMD_DLSTART and
+ * CMD_SWAP while frame deduplication is enabled.
+ */
+#define ASSET_CHUNK             512             /* bytes per read, multiple of 4 */
+
+/* Reader callback: copy up to len bytes of the asset into buf, returns bytes read.
+   Must return len until the end of the asset is reached. */
+typedef uint32_t (*ASSET_Reader_t)(void *ctx, uint8_t *buf, uint32_t len);
+
+/* Bundle made with tools/ftpack.c:
+ *   header  magic "FTPK", number of entries
+ *   index   ASSET_Bundle_Entry_t for every entry
+ *   data    entries, each padded to 4 bytes
+ * All values are little-endian uint32.
+ */
+#define ASSET_BUNDLE_MAGIC      0x4B505446UL    /* "FTPK" */
+
+#define ASSET_RAW               0               /* uncompressed, written with HOST_MEM_WR_STR */
+#define ASSET_ZLIB              1               /* zlib stream for CMD_INFLATE */
+#define ASSET_JPEG              2               /* baseline JPEG for CMD_LOADIMAGE */
+
+typedef struct
+{
+	uint32_t id;
+	uint32_t type;				/* ASSET_RAW, ASSET_ZLIB or ASSET_JPEG */
+	uint32_t offset;			/* from the start of the bundle */
+	uint32_t size;				/* stored bytes */
+	uint32_t raw_size;			/* bytes after decompression (JPEG: width*height*2, RGB565) */
+} ASSET_Bundle_Entry_t;
+
+void ASSET_begin(void);						/* read the manifest from RAM_G (call once after initFT800) */
+uint8_t ASSET_load(const ASSET_t *asset);	/* verify or upload one asset */
+void ASSET_end(void);						/* write the manifest back to RAM_G if it changed */
+void ASSET_invalidate(void);				/* forget all assets (e.g. after a cold start) */
+
+uint8_t ASSET_inflate(uint32_t addr, ASSET_Reader_t read, void *ctx);							/* stream zlib data through CMD_INFLATE */
+uint8_t ASSET_loadimage(uint32_t addr, uint32_t options, ASSET_Reader_t read, void *ctx);		/* stream JPEG data through CMD_LOADIMAGE */
+const ASSET_Bundle_Entry_t* ASSET_bundle_find(const uint8_t *bundle, uint32_t id);				/* look up an entry of a memory-mapped bundle */
+uint8_t ASSET_bundle_load(const uint8_t *bundle, uint32_t id, uint32_t addr, uint32_t options);	/* load a bundle entry into RAM_G */
+
+#endif
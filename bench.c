@@ -0,0 +1,360 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    bench.c
+  * @brief   Benchmark suite
+  *          This file contains representative workloads that measure SPI
+  *          traffic and CPU time per frame. Build with FT_BENCH defined so
+  *          spi.h counts transactions and bytes.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include "stm32f4xx.h"
+#include "spi.h"
+#include "ft800.h"
+#include "bench.h"
+#include "cycles.h"
+#include "tween.h"
+#include "shadow.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_UPLOAD_CHUNK	1024
+#define BENCH_UPLOAD_SIZE	(16*1024)
+#define BENCH_TWEENS		256
+#define BENCH_CANVAS		(RAM_G + BENCH_UPLOAD_SIZE)	/* 128x32 L8 canvas */
+#define BENCH_CANVAS_W		128
+#define BENCH_CANVAS_SIZE	(BENCH_CANVAS_W*32)
+
+BENCH_Counters_t BENCH_spi;
+
+/*** Workloads *********************************************************************/
+/* demo screen of main.c */
+static void wl_start_screen(void)
+{
+	cmd(CMD_DLSTART);
+	cmd(CLEAR_COLOR_RGB(0,0,0));
+	cmd(CLEAR(1,1,1));
+	cmd_gradient(0,0,0xA1E1FF, 0,250,0x000080);
+	cmd_text(10,245, 27,0, "Designed by: Akos Pasztor");
+	cmd_text(470,250, 26,OPT_RIGHTX, "http://akospasztor.com");
+	cmd(COLOR_RGB(0xDE,0x00,0x08));
+	cmd_text(240,40, 31,OPT_CENTERX, "FT800 Demo");
+	cmd(COLOR_RGB(255,255,255));
+	cmd(TAG(1));
+	cmd_fgcolor(0x228B22);
+	cmd_button(130,150, 220,48, 28,0, "Tap to Continue");
+	cmd(DISPLAY());
+	cmd(CMD_SWAP);
+}
+
+/* text-heavy list: 16 rows with a label and a right aligned value */
+static void wl_text_list(void)
+{
+	uint8_t i;
+
+	cmd(CMD_DLSTART);
+	cmd(CLEAR_COLOR_RGB(0,0,0));
+	cmd(CLEAR(1,1,1));
+	cmd(COLOR_RGB(255,255,255));
+	for(i=0; i<16; ++i)
+	{
+		cmd_text(10, 2+i*17, 26, 0, "Temperature sensor reading");
+		cmd_text(470, 2+i*17, 26, OPT_RIGHTX, "21.5 C");
+	}
+	cmd(DISPLAY());
+	cmd(CMD_SWAP);
+}
+
+/* dashboard: sliders, buttons and a gradient background */
+static void wl_dashboard(void)
+{
+	uint8_t i;
+
+	cmd(CMD_DLSTART);
+	cmd(CLEAR_COLOR_RGB(0,0,0));
+	cmd(CLEAR(1,1,1));
+	cmd_gradient(0,0,0x202020, 0,272,0x000040);
+	cmd_fgcolor(0x0A520A);
+	cmd_bgcolor(0x303030);
+	for(i=0; i<6; ++i)
+	{
+		cmd_text(10, 20+i*40, 27, 0, "Channel");
+		cmd_slider(120, 26+i*40, 220, 12, 0, i*10, 100);
+	}
+	for(i=0; i<4; ++i)
+	{
+		cmd_button(370, 20+i*60, 100, 48, 28, 0, "Mode");
+	}
+	cmd(DISPLAY());
+	cmd(CMD_SWAP);
+}
+
+/* 16 KB bitmap upload into RAM_G */
+static void wl_bitmap_upload(void)
+{
+	static uint8_t chunk[BENCH_UPLOAD_CHUNK];
+	uint32_t addr;
+
+	for(addr=0; addr<BENCH_UPLOAD_SIZE; addr+=BENCH_UPLOAD_CHUNK)
+	{
+		memset(chunk, (uint8_t)(addr>>10), sizeof(chunk));
+		HOST_MEM_WR_STR(RAM_G + addr, chunk, sizeof(chunk));
+	}
+}
+
+/* 256 tweens advanced by one frame, 16 of them drawn as sliders */
+static void wl_tweens(void)
+{
+	static int32_t values[BENCH_TWEENS];
+	static uint32_t frame;
+	uint16_t i;
+
+	if(!TWEEN_active())
+	{
+		TWEEN_init(frame);
+		for(i=0; i<BENCH_TWEENS; ++i)
+		{
+			values[i] = 0;
+			TWEEN_start(&values[i], 100, 0, BENCH_ITERATIONS, i % (TWEEN_SMOOTH+1));
+		}
+	}
+	TWEEN_step(++frame);
+
+	cmd(CMD_DLSTART);
+	cmd(CLEAR_COLOR_RGB(0,0,0));
+	cmd(CLEAR(1,1,1));
+	for(i=0; i<16; ++i)
+	{
+		cmd_slider(20, 10+i*16, 440, 8, 0, values[i*16], 100);
+	}
+	cmd(DISPLAY());
+	cmd(CMD_SWAP);
+}
+
+/* 16x16 icon redrawn pixel by pixel into a canvas, one transaction per pixel */
+static void wl_pixel_writes(void)
+{
+	uint8_t x, y;
+
+	for(y=0; y<16; ++y)
+	{
+		for(x=0; x<16; ++x)
+		{
+			HOST_MEM_WR8(BENCH_CANVAS + y*BENCH_CANVAS_W + x, x^y);
+		}
+	}
+}
+
+/* the same icon through a RAM_G shadow, flushed once */
+static void wl_pixel_shadow(void)
+{
+	static uint8_t canvas[BENCH_CANVAS_SIZE];
+	static SHADOW_t shadow;
+	uint8_t x, y;
+
+	if(!shadow.mem && !SHADOW_init(&shadow, BENCH_CANVAS, canvas, sizeof(canvas), 0)) return;
+
+	for(y=0; y<16; ++y)
+	{
+		for(x=0; x<16; ++x)
+		{
+			SHADOW_wr8(&shadow, BENCH_CANVAS + y*BENCH_CANVAS_W + x, x^y);
+		}
+	}
+	SHADOW_flush(&shadow);
+}
+
+/* touch transform rewritten with its current value, one transaction per register */
+static uint32_t bench_transform[6];
+
+static void wl_regs_single(void)
+{
+	uint8_t i;
+
+	if(!bench_transform[0]) HOST_MEM_READ_STR(REG_TOUCH_TRANSFORM_A, (uint8_t*)bench_transform, sizeof(bench_transform));
+	for(i=0; i<6; ++i)
+	{
+		HOST_MEM_WR32(REG_TOUCH_TRANSFORM_A + i*4, bench_transform[i]);
+	}
+}
+
+/* the same registers as a batch */
+static void wl_regs_batch(void)
+{
+	HOST_MEM_Op_t ops[6];
+	uint8_t i;
+
+	if(!bench_transform[0]) HOST_MEM_READ_STR(REG_TOUCH_TRANSFORM_A, (uint8_t*)bench_transform, sizeof(bench_transform));
+	for(i=0; i<6; ++i)
+	{
+		ops[i].addr = REG_TOUCH_TRANSFORM_A + i*4;
+		ops[i].buf = (uint8_t*)&bench_transform[i];
+		ops[i].len = 4;
+		ops[i].dir = HOST_MEM_WRITE;
+	}
+	HOST_MEM_BATCH(ops, 6);
+}
+
+typedef struct
+{
+	const char *name;
+	void (*run)(void);
+} BENCH_Workload_t;
+
+static const BENCH_Workload_t workloads[BENCH_WORKLOADS] =
+{
+	{ "start_screen",  wl_start_screen  },
+	{ "text_list",     wl_text_list     },
+	{ "dashboard",     wl_dashboard     },
+	{ "bitmap_upload", wl_bitmap_upload },
+	{ "tweens",        wl_tweens        },
+	{ "pixel_writes",  wl_pixel_writes  },
+	{ "pixel_shadow",  wl_pixel_shadow  },
+	{ "regs_single",   wl_regs_single   },
+	{ "regs_batch",    wl_regs_batch    },
+};
+
+/*** Control ***********************************************************************/
+void BENCH_init(void)
+{
+	CYCLES_init();
+}
+
+/*
+    Function: BENCH_run
+    ARGS:     results: output buffer for BENCH_WORKLOADS results
+
+    Description: Runs every workload BENCH_ITERATIONS times and stores the
+                 per-iteration averages. Cycles include the wait for the
+                 co-processor, the SPI counters leave out the REG_CMD_READ
+                 polls of that wait. Frame deduplication is switched off
+                 while the workloads run, so every frame is really sent.
+                 Returns the number of results.
+*/
+uint8_t BENCH_run(BENCH_Result_t *results)
+{
+	uint8_t dedup = cmd_dedup_enabled();
+	uint8_t i, k;
+
+	cmd_dedup(0);
+	while(!cmd_ready());
+
+	for(i=0; i<BENCH_WORKLOADS; ++i)
+	{
+		uint32_t start;
+#ifdef FT_SIM
+		uint64_t host = CYCLES_host_ns();
+#endif
+
+		BENCH_spi.transactions = 0;
+		BENCH_spi.bytes = 0;
+		start = CYCLES_now();
+
+		for(k=0; k<BENCH_ITERATIONS; ++k)
+		{
+			BENCH_Counters_t spi;
+
+			workloads[i].run();
+
+			spi = BENCH_spi;			// the REG_CMD_READ polls are not workload traffic
+			while(!cmd_ready());		// include co-processor time
+			BENCH_spi = spi;
+		}
+
+		results[i].name = workloads[i].name;
+		results[i].cycles = (CYCLES_now() - start) / BENCH_ITERATIONS;
+		results[i].transactions = BENCH_spi.transactions / BENCH_ITERATIONS;
+		results[i].bytes = BENCH_spi.bytes / BENCH_ITERATIONS;
+		results[i].fps = results[i].cycles ? SystemCoreClock / results[i].cycles : 0;
+#ifdef FT_SIM
+		results[i].host_ns = (uint32_t)((CYCLES_host_ns() - host) / BENCH_ITERATIONS);
+#endif
+	}
+
+	cmd_dedup(dedup);
+	return BENCH_WORKLOADS;
+}
+
+/*
+    Function: BENCH_report
+    ARGS:     results: results of BENCH_run()
+              n:       number of results
+              out:     line output function (e.g. UART)
+
+    Description: Prints one CSV line per workload:
+                 bench,<name>,<transactions>,<bytes>,<cycles>,<fps>
+                 A host build (FT_SIM) adds the host CPU time: cycles are
+                 model time, ...,<fps>,<host_ns> is what the PC spent.
+*/
+void BENCH_report(const BENCH_Result_t *results, uint8_t n, BENCH_Output_t out)
+{
+	char line[96];
+	uint8_t i;
+
+#ifdef FT_SIM
+	out("bench,name,transactions,bytes,cycles,fps,host_ns");
+#else
+	out("bench,name,transactions,bytes,cycles,fps");
+#endif
+	for(i=0; i<n; ++i)
+	{
+		snprintf(line, sizeof(line), "bench,%s,%lu,%lu,%lu,%lu", results[i].name,
+		         (unsigned long)results[i].transactions, (unsigned long)results[i].bytes,
+		         (unsigned long)results[i].cycles, (unsigned long)results[i].fps);
+#ifdef FT_SIM
+		snprintf(line + strlen(line), sizeof(line) - strlen(line), ",%lu", (unsigned long)results[i].host_ns);
+#endif
+		out(line);
+	}
+}
+
+/*
+    Function: BENCH_compare
+    ARGS:     results:   results of BENCH_run()
+              n:         number of results
+              base:      baseline (e.g. pasted from an earlier BENCH_report)
+              nbase:     number of baseline entries
+              tolerance: allowed increase in percent
+              out:       line output function
+
+    Description: Prints a "regression" line for every workload whose SPI bytes
+                 or cycles grew by more than tolerance percent over the
+                 baseline. Returns the number of regressions.
+*/
+uint8_t BENCH_compare(const BENCH_Result_t *results, uint8_t n,
+                      const BENCH_Baseline_t *base, uint8_t nbase,
+                      uint8_t tolerance, BENCH_Output_t out)
+{
+	char line[96];
+	uint8_t i, j, regressions = 0;
+
+	for(i=0; i<n; ++i)
+	{
+		for(j=0; j<nbase; ++j)
+		{
+			if(strcmp(results[i].name, base[j].name)) continue;
+
+			if((uint64_t)results[i].bytes*100 > (uint64_t)base[j].bytes*(100+tolerance))
+			{
+				snprintf(line, sizeof(line), "regression,%s,bytes,%lu,%lu", results[i].name,
+				         (unsigned long)base[j].bytes, (unsigned long)results[i].bytes);
+				out(line);
+				++regressions;
+			}
+			if((uint64_t)results[i].cycles*100 > (uint64_t)base[j].cycles*(100+tolerance))
+			{
+				snprintf(line, sizeof(line), "regression,%s,cycles,%lu,%lu", results[i].name,
+				         (unsigned long)base[j].cycles, (unsigned long)results[i].cycles);
+				out(line);
+				++regressions;
+			}
+		}
+	}
+	return regressions;
+}
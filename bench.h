@@ -0,0 +1,49 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/* SPI counters, updated by spi.h when FT_BENCH is defined */
+typedef struct
+{
+	uint32_t transactions;		/* FT_spi_select() calls */
+	uint32_t bytes;				/* bytes exchanged with SPI_send() */
+} BENCH_Counters_t;
+
+extern BENCH_Counters_t BENCH_spi;
+
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS	10			/* runs of each workload, results are averaged */
+#endif
+
+#define BENCH_WORKLOADS		9
+
+/* Result of one workload (per iteration) */
+typedef struct
+{
+	const char *name;
+	uint32_t transactions;		/* SPI transactions */
+	uint32_t bytes;				/* SPI bytes */
+	uint32_t cycles;			/* CPU cycles until the co-processor is idle again */
+	uint32_t fps;				/* frames per second the workload could run at */
+#ifdef FT_SIM
+	uint32_t host_ns;			/* host CPU time in ns, the model included (cycles are model time) */
+#endif
+} BENCH_Result_t;
+
+/* Stored result to compare against */
+typedef struct
+{
+	const char *name;
+	uint32_t bytes;
+	uint32_t cycles;
+} BENCH_Baseline_t;
+
+typedef void (*BENCH_Output_t)(const char *line);
+
+void BENCH_init(void);																/* start the cycle counter */
+uint8_t BENCH_run(BENCH_Result_t *results);											/* run all workloads, returns number of results */
+void BENCH_report(const BENCH_Result_t *results, uint8_t n, BENCH_Output_t out);		/* print results as CSV lines */
+uint8_t BENCH_compare(const BENCH_Result_t *results, uint8_t n,
+                      const BENCH_Baseline_t *base, uint8_t nbase,
+                      uint8_t tolerance, BENCH_Output_t out);						/* flag results worse than base by more than tolerance %, returns number of regressions */
+
+#endif
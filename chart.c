@@ -0,0 +1,242 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    chart.c
+  * @brief   Chart widget
+  *          This file contains a scrolling waveform chart. Input samples are
+  *          reduced to per-column min/max envelopes, which are drawn with
+  *          one VERTEX2II word per point within a display list budget.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include "stm32f4xx.h"
+#include "ft800.h"
+#include "chart.h"
+
+#define CHART_BATCH		64		/* words per cmd_burst */
+
+/*** Decimation ********************************************************************/
+#if defined(__ARM_FEATURE_DSP)
+/*
+    SSUB16 a, b sets the GE flag of each halfword where a >= b, SEL x, y takes
+    the halfword of x where the flag is set and of y elsewhere. Both are in one
+    asm block: the difference itself is unused, so with the CMSIS intrinsics
+    the compiler may drop or move the SSUB16 away from its SEL.
+*/
+static inline uint32_t chart_sel_ge(uint32_t a, uint32_t b, uint32_t x, uint32_t y)
+{
+	uint32_t r;
+
+	__ASM("ssub16 %0, %1, %2\n\t"
+	      "sel    %0, %3, %4"
+	      : "=&r" (r) : "r" (a), "r" (b), "r" (x), "r" (y) : "cc");
+	return r;
+}
+
+/* two samples per step */
+static void chart_minmax(const int16_t *s, uint32_t n, int16_t *lo, int16_t *hi)
+{
+	uint32_t vlo, vhi;
+	const uint32_t *p;
+	int16_t l, h;
+
+	if(((uint32_t)s & 2) && n)
+	{
+		if(*s < *lo) *lo = *s;
+		if(*s > *hi) *hi = *s;
+		++s; --n;
+	}
+
+	vlo = ((uint32_t)(uint16_t)*lo << 16) | (uint16_t)*lo;
+	vhi = ((uint32_t)(uint16_t)*hi << 16) | (uint16_t)*hi;
+	p = (const uint32_t*)s;
+
+	for(; n>=2; n-=2)
+	{
+		uint32_t v = *p++;
+
+		vlo = chart_sel_ge(v, vlo, vlo, v);		// v >= lo: keep lo
+		vhi = chart_sel_ge(v, vhi, v, vhi);		// v >= hi: take v
+	}
+
+	l = (int16_t)vlo; h = (int16_t)(vlo >> 16);
+	*lo = (l < h) ? l : h;
+	l = (int16_t)vhi; h = (int16_t)(vhi >> 16);
+	*hi = (l > h) ? l : h;
+
+	if(n)
+	{
+		s = (const int16_t*)p;
+		if(*s < *lo) *lo = *s;
+		if(*s > *hi) *hi = *s;
+	}
+}
+#else
+static void chart_minmax(const int16_t *s, uint32_t n, int16_t *lo, int16_t *hi)
+{
+	int16_t l = *lo, h = *hi;
+
+	while(n--)
+	{
+		int16_t v = *s++;
+		if(v < l) l = v;
+		if(v > h) h = v;
+	}
+	*lo = l;
+	*hi = h;
+}
+#endif
+
+void CHART_clear(CHART_t *c)
+{
+	c->head = 0;
+	c->cols = 0;
+	c->fill = 0;
+	c->cur_lo = 32767;
+	c->cur_hi = -32768;
+}
+
+void CHART_init(CHART_t *c, int16_t x, int16_t y, int16_t w, int16_t h, int16_t min, int16_t max, uint16_t spp)
+{
+	c->x = x;
+	c->y = y;
+	c->w = (w > CHART_COLS) ? CHART_COLS : w;
+	c->h = h;
+	c->min = min;
+	c->max = (max > min) ? max : min+1;
+	c->spp = spp ? spp : 1;
+	c->budget = CHART_BUDGET;
+	CHART_clear(c);
+}
+
+/*
+    Function: CHART_push
+    ARGS:     c:       chart
+              samples: new samples
+              n:       number of samples
+
+    Description: Folds the samples into the envelope of the current column.
+                 Every spp samples the column is finished and appended to the
+                 ring, dropping the oldest one when the chart is full.
+*/
+void CHART_push(CHART_t *c, const int16_t *samples, uint32_t n)
+{
+	while(n)
+	{
+		uint32_t k = c->spp - c->fill;
+
+		if(k > n) k = n;
+		chart_minmax(samples, k, &c->cur_lo, &c->cur_hi);
+		samples += k;
+		n -= k;
+		c->fill += k;
+
+		if(c->fill == c->spp)
+		{
+			uint16_t i;
+
+			if(c->cols < c->w)
+			{
+				i = c->head + c->cols++;
+				if(i >= c->w) i -= c->w;
+			}
+			else
+			{
+				i = c->head;
+				if(++c->head == c->w) c->head = 0;
+			}
+			c->lo[i] = c->cur_lo;
+			c->hi[i] = c->cur_hi;
+			c->fill = 0;
+			c->cur_lo = 32767;
+			c->cur_hi = -32768;
+		}
+	}
+}
+
+/*** Drawing ***********************************************************************/
+static int16_t chart_y(const CHART_t *c, int32_t v)
+{
+	if(v < c->min) v = c->min;
+	if(v > c->max) v = c->max;
+	return c->y + c->h - 1 - (int16_t)(((v - c->min) * (c->h - 1)) / (c->max - c->min));
+}
+
+/*
+    Function: CHART_draw
+    ARGS:     c:    chart
+              mode: CHART_LINE or CHART_FILL
+
+    Description: Draws the finished columns right-aligned in the plot area.
+                 If the columns need more vertices than c->budget allows,
+                 neighbouring columns are merged. Colour and line width are
+                 taken from the current graphics state. Returns 0 on FIFO
+                 timeout.
+*/
+uint8_t CHART_draw(const CHART_t *c, uint8_t mode)
+{
+	uint32_t buf[CHART_BATCH];
+	uint32_t n = 0;
+	uint16_t per, overhead, vbudget, merge, i;
+	uint8_t flip = 0;
+
+	if(!c->cols) return 1;
+
+	per = (mode == CHART_FILL) ? 1 : 2;
+	overhead = (mode == CHART_FILL) ? 6 : 2;
+	vbudget = (c->budget > overhead + per) ? c->budget - overhead : per;
+	merge = (c->cols * per + vbudget - 1) / vbudget;
+
+	if(mode == CHART_FILL)
+	{
+		buf[n++] = SAVE_CONTEXT();
+		buf[n++] = SCISSOR_XY(c->x, c->y);
+		buf[n++] = SCISSOR_SIZE(c->w, c->h);
+		buf[n++] = BEGIN(EDGE_STRIP_B);
+	}
+	else
+	{
+		buf[n++] = BEGIN(LINE_STRIP);
+	}
+
+	for(i=0; i<c->cols; i+=merge)
+	{
+		int16_t lo = 32767, hi = -32768;
+		uint16_t k, x = c->x + c->w - c->cols + i;
+
+		for(k=i; k<i+merge && k<c->cols; ++k)
+		{
+			uint16_t r = c->head + k;
+
+			if(r >= c->w) r -= c->w;
+			if(c->lo[r] < lo) lo = c->lo[r];
+			if(c->hi[r] > hi) hi = c->hi[r];
+		}
+
+		if(mode == CHART_FILL)
+		{
+			buf[n++] = VERTEX2II(x, chart_y(c, hi), 0, 0);
+		}
+		else
+		{
+			/* alternate the vertex order so consecutive columns join at the same end */
+			buf[n++] = VERTEX2II(x, chart_y(c, flip ? hi : lo), 0, 0);
+			buf[n++] = VERTEX2II(x, chart_y(c, flip ? lo : hi), 0, 0);
+			flip ^= 1;
+		}
+
+		if(n > CHART_BATCH-2)
+		{
+			if(!cmd_burst(buf, n)) return 0;
+			n = 0;
+		}
+	}
+
+	buf[n++] = END();
+	if(mode == CHART_FILL) buf[n++] = RESTORE_CONTEXT();
+	return cmd_burst(buf, n);
+}
@@ -0,0 +1,38 @@
+#ifndef CHART_H
+#define CHART_H
+
+/* Chart widget
+ * Samples are decimated into one min/max envelope per pixel column as they
+ * arrive. The columns form a ring, so pushing new samples scrolls the trace
+ * without touching the older columns.
+ */
+
+#ifndef CHART_COLS
+#define CHART_COLS          480     /* maximum chart width in pixels */
+#endif
+#define CHART_BUDGET        1024    /* default display list words per draw */
+
+/* draw modes */
+#define CHART_LINE          0       /* LINE_STRIP through the min/max envelope */
+#define CHART_FILL          1       /* EDGE_STRIP_B below the max envelope */
+
+typedef struct
+{
+	int16_t  x, y, w, h;		/* plot area, w <= CHART_COLS, must lie within 0..511 (VERTEX2II) */
+	int16_t  min, max;			/* sample values mapped to the bottom / top edge */
+	uint16_t spp;				/* samples per column */
+	uint16_t budget;			/* display list words CHART_draw may use */
+	uint16_t head;				/* ring index of the oldest column */
+	uint16_t cols;				/* finished columns */
+	uint16_t fill;				/* samples in the column being collected */
+	int16_t  cur_lo, cur_hi;	/* envelope of the column being collected */
+	int16_t  lo[CHART_COLS];
+	int16_t  hi[CHART_COLS];
+} CHART_t;
+
+void CHART_init(CHART_t *c, int16_t x, int16_t y, int16_t w, int16_t h, int16_t min, int16_t max, uint16_t spp);	/* set up an empty chart */
+void CHART_clear(CHART_t *c);													/* drop all samples */
+void CHART_push(CHART_t *c, const int16_t *samples, uint32_t n);				/* add samples, scrolling the trace left */
+uint8_t CHART_draw(const CHART_t *c, uint8_t mode);								/* write the trace into the display list */
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef CYCLES_H
+#define CYCLES_H
+
+/* CPU cycle counter
+ * Time base of the trace recorder and the benchmark. On the target it is the
+ * DWT cycle counter. In a host build against the FT800 model (FT_SIM) it is
+ * the model's clock, so cycles are simulated host cycles including SPI and
+ * co-processor wait time. CYCLES_host_ns gives the real CPU time of the
+ * process next to it.
+ */
+
+#include "stm32f4xx.h"
+
+#ifdef FT_SIM
+#include <time.h>
+#include "ftsim.h"
+#endif
+
+/* Enables the counter. It is not cleared, so several users can share it. */
+static inline void CYCLES_init(void)
+{
+#ifndef FT_SIM
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+static inline uint32_t CYCLES_now(void)
+{
+#ifdef FT_SIM
+	FTSIM_t *s = FTSIM_of(0);
+	return s ? (uint32_t)s->now : 0;
+#else
+	return DWT->CYCCNT;
+#endif
+}
+
+#ifdef FT_SIM
+/* CPU time of the host process in ns, the model's own work included */
+static inline uint64_t CYCLES_host_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+	return (uint64_t)t.tv_sec * 1000000000ULL + (uint64_t)t.tv_nsec;
+}
+#endif
+
+#endif
@@ -0,0 +1,239 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    font.c
+  * @brief   Font metrics and text layout
+  *          This file contains a host side cache of the font width tables
+  *          and a layout engine that measures, wraps and truncates UTF-8
+  *          text before it is drawn with cmd_text.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include "stm32f4xx.h"
+#include "ft800.h"
+#include "font.h"
+
+#include <string.h>
+
+static FONT_Metrics_t fonts[FONT_HANDLES];
+
+/*** Metrics ***********************************************************************/
+/*
+    Function: FONT_load
+    ARGS:     font: font number (bitmap handle)
+              addr: address of the font's metric block (FT_Gpu_Fonts_t)
+
+    Description: Reads the width table and height of a font. Returns 0 if the
+                 metric block is invalid.
+*/
+uint8_t FONT_load(uint8_t font, uint32_t addr)
+{
+	FT_Gpu_Fonts_t table;
+
+	if(font >= FONT_HANDLES) return 0;
+
+	HOST_MEM_READ_STR(addr, (uint8_t*)&table, FT_GPU_FONT_TABLE_SIZE);
+	memcpy(fonts[font].width, table.FontWidth, FT_GPU_NUMCHAR_PERFONT);
+	fonts[font].height = (table.FontHeightInPixels < 256) ? table.FontHeightInPixels : 0;
+	return fonts[font].height ? 1 : 0;
+}
+
+void FONT_init(void)
+{
+	uint32_t table = HOST_MEM_RD32(FONT_ROM_PTR);
+	uint8_t i;
+
+	memset(fonts, 0, sizeof(fonts));
+	for(i=FONT_ROM_FIRST; i<FONT_HANDLES; ++i)
+	{
+		FONT_load(i, table + (i-FONT_ROM_FIRST)*FT_GPU_FONT_TABLE_SIZE);
+	}
+}
+
+void FONT_setfont(uint8_t font, uint32_t addr)
+{
+	cmd_setfont(font, addr);
+	FONT_load(font, addr);
+}
+
+const FONT_Metrics_t* FONT_metrics(uint8_t font)
+{
+	return (font < FONT_HANDLES && fonts[font].height) ? &fonts[font] : 0;
+}
+
+/*** Measuring *********************************************************************/
+/* next character of a UTF-8 string, multi-byte sequences become '?' */
+static uint8_t font_next(const char **s)
+{
+	const uint8_t *p = (const uint8_t*)*s;
+	uint8_t c = *p++;
+
+	if(c >= 0x80)
+	{
+		while((*p & 0xC0) == 0x80) ++p;
+		c = '?';
+	}
+	*s = (const char*)p;
+	return c;
+}
+
+uint16_t FONT_width(uint8_t font, const char *str)
+{
+	const FONT_Metrics_t *m = FONT_metrics(font);
+	uint16_t w = 0;
+
+	if(!m) return 0;
+	while(*str) w += m->width[font_next(&str)];
+	return w;
+}
+
+uint16_t FONT_height(uint8_t font)
+{
+	return (font < FONT_HANDLES) ? fonts[font].height : 0;
+}
+
+/*
+    Function: FONT_fit
+    ARGS:     font: font number
+              str:  UTF-8 string
+              w:    available width in pixels
+              used: if not NULL, receives the width of the part that fits
+
+    Description: Returns the number of bytes at the start of str that fit into
+                 w pixels, never splitting a UTF-8 sequence.
+*/
+uint16_t FONT_fit(uint8_t font, const char *str, uint16_t w, uint16_t *used)
+{
+	const FONT_Metrics_t *m = FONT_metrics(font);
+	const char *p = str;
+	uint16_t width = 0;
+
+	if(m)
+	{
+		while(*p)
+		{
+			const char *q = p;
+			uint8_t c = font_next(&q);
+
+			if(width + m->width[c] > w) break;
+			width += m->width[c];
+			p = q;
+		}
+	}
+	if(used) *used = width;
+	return (uint16_t)(p - str);
+}
+
+/*** Layout ************************************************************************/
+/*
+	Builds the next line of *s into line (plain ASCII, as drawn by the FT800)
+	and advances *s past it. With wrap the line is broken after the last space
+	that fits, a word wider than the box is broken anywhere; '\n' always ends
+	a line. Returns the width of the line.
+*/
+static uint16_t font_line(const FONT_Metrics_t *m, const char **s, uint16_t w, char *line, uint16_t *len, uint8_t wrap)
+{
+	const char *p = *s, *brk = 0;
+	uint16_t n = 0, width = 0, brk_n = 0, brk_w = 0;
+
+	while(*p)
+	{
+		const char *start = p;
+		uint8_t c = font_next(&p);
+
+		if(c == '\n') break;
+
+		if(width + m->width[c] > w || n == FONT_LINE)
+		{
+			if(!wrap) { p = start; }
+			else if(c != ' ')								// a space that doesn't fit is the break itself
+			{
+				if(brk)     { n = brk_n; width = brk_w; p = brk; }
+				else if(!n) { line[n++] = c; width += m->width[c]; }	// single character wider than the box
+				else        { p = start; }
+			}
+			if(*p == '\n') ++p;
+			break;
+		}
+
+		if(c == ' ') { brk = p; brk_n = n; brk_w = width; }
+		line[n++] = c;
+		width += m->width[c];
+	}
+
+	line[n] = 0;
+	*len = n;
+	*s = p;
+	return width;
+}
+
+/* shorten the line until "..." fits behind it */
+static void font_ellipsis(const FONT_Metrics_t *m, char *line, uint16_t n, uint16_t width, uint16_t w)
+{
+	uint16_t dots = 3 * m->width['.'];
+
+	while(n && (width + dots > w || n + 3 > FONT_LINE || line[n-1] == ' '))
+	{
+		width -= m->width[(uint8_t)line[--n]];
+	}
+	if(width + dots <= w) { memcpy(&line[n], "...", 3); n += 3; }
+	line[n] = 0;
+}
+
+/*
+    Function: FONT_box
+    ARGS:     x, y, w, h: text box
+              font:       font number (metrics loaded with FONT_init/FONT_load)
+              options:    OPT_CENTERX, OPT_RIGHTX, OPT_CENTERY, FONT_NOWRAP
+              str:        UTF-8 text
+
+    Description: Word-wraps the text into the box (or keeps it on one line
+                 with FONT_NOWRAP) and draws every line with cmd_text. If the
+                 text doesn't fit, the last line ends with an ellipsis. With
+                 OPT_CENTERY the lines are centred in the box height as a
+                 block. Layout needs no SPI reads. Returns the number of lines.
+*/
+uint16_t FONT_box(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t font, uint16_t options, const char *str)
+{
+	static char line[FONT_LINE+1];
+	const FONT_Metrics_t *m = FONT_metrics(font);
+	uint8_t wrap = (options & FONT_NOWRAP) ? 0 : 1;
+	uint16_t lines = 0, max_lines, n, width;
+	int16_t tx = x;
+
+	if(!m || w <= 0) return 0;
+
+	max_lines = wrap ? h / m->height : 1;
+	if(!max_lines) max_lines = 1;
+
+	if(options & OPT_RIGHTX)       tx = x + w;
+	else if(options & OPT_CENTERX) tx = x + w/2;
+
+	if(options & OPT_CENTERY)
+	{
+		const char *p = str;
+
+		while(*p && lines < max_lines) { font_line(m, &p, w, line, &n, wrap); ++lines; }
+		if(lines*m->height < h) y += (h - lines*m->height) / 2;
+		lines = 0;
+	}
+	options &= OPT_RIGHTX | OPT_CENTERX;
+
+	while(*str && lines < max_lines)
+	{
+		width = font_line(m, &str, w, line, &n, wrap);
+
+		if(*str && lines+1 == max_lines)
+		{
+			font_ellipsis(m, line, n, width, w);
+		}
+
+		if(line[0]) cmd_text(tx, y + lines*m->height, font, options, line);
+		++lines;
+	}
+	return lines;
+}
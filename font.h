@@ -0,0 +1,39 @@
+#ifndef FONT_H
+#define FONT_H
+
+/* Font metrics and text layout
+ * Glyph widths of the ROM fonts (16..31) and of custom fonts are read once
+ * into a host table, so text can be measured, wrapped and truncated on the
+ * MCU. UTF-8 is decoded; characters outside the font (>= 128) are shown
+ * as '?'.
+ */
+
+#define FONT_ROM_PTR        0xFFFFCUL   /* holds the address of the ROM font tables */
+#define FONT_HANDLES        32          /* bitmap handles / font numbers */
+#define FONT_ROM_FIRST      16          /* first ROM font */
+
+#ifndef FONT_LINE
+#define FONT_LINE           128         /* longest line in characters */
+#endif
+
+/* FONT_box options (besides OPT_CENTERX / OPT_RIGHTX / OPT_CENTERY of cmd_text) */
+#define FONT_NOWRAP         0x0001      /* single line, truncated with an ellipsis */
+
+typedef struct
+{
+	uint8_t width[FT_GPU_NUMCHAR_PERFONT];	/* advance of each character in pixels */
+	uint8_t height;							/* line height in pixels, 0: not loaded */
+} FONT_Metrics_t;
+
+void FONT_init(void);													/* read the metrics of the ROM fonts */
+uint8_t FONT_load(uint8_t font, uint32_t addr);							/* read the metrics of a custom font from its metric block */
+void FONT_setfont(uint8_t font, uint32_t addr);							/* cmd_setfont + FONT_load */
+const FONT_Metrics_t* FONT_metrics(uint8_t font);						/* cached metrics, NULL if not loaded */
+
+uint16_t FONT_width(uint8_t font, const char *str);						/* width of a UTF-8 string in pixels */
+uint16_t FONT_height(uint8_t font);										/* line height in pixels */
+uint16_t FONT_fit(uint8_t font, const char *str, uint16_t w, uint16_t *used);	/* bytes of str that fit into w pixels */
+
+uint16_t FONT_box(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t font, uint16_t options, const char *str);	/* draw wrapped / truncated text into a box, returns lines drawn */
+
+#endif
@@ -14,289 +14,855 @@
 **/
 
 
+#define FT_PROF_NO_SITES			// the library's own cmd() calls are not call sites
+
 #include "stm32f4xx.h"
 #include "spi.h"
 #include "ft800.h"
+#ifdef FT_PROF
+#include "prof.h"
+#endif
 
 #include <stdlib.h>
 #include <string.h>
 
+/*** Host Interface **************************************************************/
 /*
-    Function: HOST_MEM_READ_STR
-    ARGS:     addr: 24 Bit Command Address 
+	The FT_x functions take the device they talk to, devices on separate buses
+	can be used from separate threads. The HOST_MEM_x / HOST_CMD_x functions
+	below act on the device selected with FT_device(). Every transaction adds
+	its bytes (header, dummy and data) to dev->spi_bytes.
+*/
+#define FT_DEV_BUS(dev)		((dev)->bus ? (const FT_Bus_t*)(dev)->bus : &FT_default_bus)
+
+/*
+    Function: FT_read
+    ARGS:     dev:  device
+              addr: 24 Bit Command Address 
               pnt:  output buffer for read data
               len:  length of bytes to be read
 
     Description: Reads len(n) bytes of data, starting at addr into pnt(buffer)
 */
-void HOST_MEM_READ_STR(uint32_t addr, uint8_t *pnt, uint8_t len)
+void FT_read(FT_Device_t *dev, uint32_t addr, uint8_t *pnt, uint32_t len)
 {
-  FT_spi_select();
-  SPI_send(((addr>>16)&0x3F) );			// Send out bits 23:16 of addr, bits 7:6 of this byte must be 00 
-  SPI_send(((addr>>8)&0xFF));       	// Send out bits 15:8 of addr
-  SPI_send((addr&0xFF));            	// Send out bits 7:0 of addr
+  const FT_Bus_t *bus = FT_DEV_BUS(dev);
+  const uint32_t len0 = len;
+
+  FT_bus_select(bus);
+  FT_bus_send(bus, ((addr>>16)&0x3F) );			// Send out bits 23:16 of addr, bits 7:6 of this byte must be 00 
+  FT_bus_send(bus, ((addr>>8)&0xFF));       	// Send out bits 15:8 of addr
+  FT_bus_send(bus, (addr&0xFF));            	// Send out bits 7:0 of addr
 
-  SPI_send(0);                      	// Send out DUMMY (0) byte
+  FT_bus_send(bus, 0);                      	// Send out DUMMY (0) byte
 
   while(len--)                      	// While Len > 0 Read out n bytes
-    *pnt++ = SPI_send(0);
+    *pnt++ = FT_bus_send(bus, 0);
   
-  FT_spi_deselect();
+  FT_bus_deselect(bus);
+  dev->spi_bytes += 4 + len0;
 }
 
 /*
-    Function: HOST_MEM_WR_STR
-    ARGS:     addr: 24 Bit Command Address 
+    Function: FT_write
+    ARGS:     dev:  device
+              addr: 24 Bit Command Address 
               pnt:  input buffer of data to send
               len:  length of bytes to be send
 
     Description: Writes len(n) bytes of data from pnt (buffer) to addr
 */
-void HOST_MEM_WR_STR(uint32_t addr, uint8_t *pnt, uint8_t len)
+void FT_write(FT_Device_t *dev, uint32_t addr, const uint8_t *pnt, uint32_t len)
 {
-  FT_spi_select();
-  SPI_send(((addr>>16)&0x3F)|0x80);     // Send out 23:16 of addr, bits 7:6 of this byte must be 10
-  SPI_send(((addr>>8)&0xFF));           // Send out bits 15:8 of addr
-  SPI_send((addr&0xFF));                // Send out bits 7:0 of addr
+  const FT_Bus_t *bus = FT_DEV_BUS(dev);
+  const uint32_t len0 = len;
+
+  FT_bus_select(bus);
+  FT_bus_send(bus, ((addr>>16)&0x3F)|0x80);     // Send out 23:16 of addr, bits 7:6 of this byte must be 10
+  FT_bus_send(bus, ((addr>>8)&0xFF));           // Send out bits 15:8 of addr
+  FT_bus_send(bus, (addr&0xFF));                // Send out bits 7:0 of addr
 
   while(len--)                          // While Len > 0 Write *pnt (then increment pnt)
-    SPI_send(*pnt++);
+    FT_bus_send(bus, *pnt++);
   
-  FT_spi_deselect();
+  FT_bus_deselect(bus);
+  dev->spi_bytes += 3 + len0;
+}
+
+/*
+    Function: FT_batch
+    ARGS:     dev: device
+              ops: list of transfers
+              n:   number of transfers
+
+    Description: Runs the transfers in order. A transfer that continues the
+                 previous one in the list (same direction, starts where it
+                 ended) is sent in the same SPI transaction, as the FT800
+                 increments the address by itself. E.g. the six
+                 REG_TOUCH_TRANSFORM_x words from six buffers take one
+                 transaction instead of six. Transfers are never reordered:
+                 adjacent addresses that are not next to each other in the
+                 list get their own transactions. Returns 0 without any
+                 transfer if an op has a dir other than HOST_MEM_WRITE or
+                 HOST_MEM_READ.
+*/
+uint8_t FT_batch(FT_Device_t *dev, const HOST_MEM_Op_t *ops, uint32_t n)
+{
+  const FT_Bus_t *bus = FT_DEV_BUS(dev);
+
+  uint32_t i = 0;
+
+  for(i=0; i<n; ++i)
+  {
+    if(ops[i].dir != HOST_MEM_WRITE && ops[i].dir != HOST_MEM_READ) return 0;
+  }
+
+  i = 0;
+  while(i < n)
+  {
+    uint8_t  dir  = ops[i].dir;
+    uint32_t addr = ops[i].addr;
+
+    FT_bus_select(bus);
+    FT_bus_send(bus, ((addr>>16)&0x3F)|(dir == HOST_MEM_WRITE ? 0x80 : 0x00));
+    FT_bus_send(bus, ((addr>>8)&0xFF));
+    FT_bus_send(bus, (addr&0xFF));
+    if(dir == HOST_MEM_READ)
+      FT_bus_send(bus, 0);                        // Send out DUMMY (0) byte
+    dev->spi_bytes += (dir == HOST_MEM_READ) ? 4 : 3;
+
+    do
+    {
+      uint8_t *pnt = ops[i].buf;
+      uint32_t len = ops[i].len;
+
+      addr += len;
+      dev->spi_bytes += len;
+      if(dir == HOST_MEM_WRITE) { while(len--) FT_bus_send(bus, *pnt++); }
+      else                      { while(len--) *pnt++ = FT_bus_send(bus, 0); }
+      ++i;
+    } while(i < n && ops[i].dir == dir && ops[i].addr == addr);
+
+    FT_bus_deselect(bus);
+  }
+  return 1;
 }
 
 /*
-    Function: HOST_CMD_WRITE
-    ARGS:     CMD:  5 bit Command
+    Function: FT_host_cmd
+    ARGS:     dev:  device
+              CMD:  5 bit Command
              
     Description: Writes Command to FT800
 */
-void HOST_CMD_WRITE(uint8_t CMD)
+void FT_host_cmd(FT_Device_t *dev, uint8_t CMD)
 {
-  FT_spi_select();
-  SPI_send((uint8_t)(CMD|0x40));        // Send out Command, bits 7:6 must be 01
-  SPI_send(0x00);
-  SPI_send(0x00);
-  FT_spi_deselect();
+  const FT_Bus_t *bus = FT_DEV_BUS(dev);
+
+  FT_bus_select(bus);
+  FT_bus_send(bus, (uint8_t)(CMD|0x40));        // Send out Command, bits 7:6 must be 01
+  FT_bus_send(bus, 0x00);
+  FT_bus_send(bus, 0x00);
+  FT_bus_deselect(bus);
+  dev->spi_bytes += 3;
 }
 
-void HOST_CMD_ACTIVE(void)
+void FT_host_active(FT_Device_t *dev)
 {
-  FT_spi_select();
-  SPI_send(0x00);      
-  SPI_send(0x00);
-  SPI_send(0x00);
-  FT_spi_deselect();
+  const FT_Bus_t *bus = FT_DEV_BUS(dev);
+
+  FT_bus_select(bus);
+  FT_bus_send(bus, 0x00);      
+  FT_bus_send(bus, 0x00);
+  FT_bus_send(bus, 0x00);
+  FT_bus_deselect(bus);
+  dev->spi_bytes += 3;
 }
 
 /*
-    Function: HOST_MEM_WR8
-    ARGS:     addr: 24 Bit Command Address 
+    Function: FT_wr8
+    ARGS:     dev:  device
+              addr: 24 Bit Command Address 
               data: 8bit Data Byte
 
     Description: Writes 1 byte of data to addr
 */
-void HOST_MEM_WR8(uint32_t addr, uint8_t data)
+void FT_wr8(FT_Device_t *dev, uint32_t addr, uint8_t data)
 {
-  FT_spi_select();
-  SPI_send((addr>>16)|0x80);
-  SPI_send(((addr>>8)&0xFF));
-  SPI_send((addr&0xFF));
+  const FT_Bus_t *bus = FT_DEV_BUS(dev);
+
+  FT_bus_select(bus);
+  FT_bus_send(bus, (addr>>16)|0x80);
+  FT_bus_send(bus, ((addr>>8)&0xFF));
+  FT_bus_send(bus, (addr&0xFF));
 
-  SPI_send(data);
+  FT_bus_send(bus, data);
   
-  FT_spi_deselect();  
+  FT_bus_deselect(bus);  
+  dev->spi_bytes += 4;
 }
 
 /*
-    Function: HOST_MEM_WR16
-    ARGS:     addr: 24 Bit Command Address 
+    Function: FT_wr16
+    ARGS:     dev:  device
+              addr: 24 Bit Command Address 
               data: 16bit (2 bytes)
 
     Description: Writes 2 bytes of data to addr
 */
-void HOST_MEM_WR16(uint32_t addr, uint32_t data)
+void FT_wr16(FT_Device_t *dev, uint32_t addr, uint32_t data)
 {
-  FT_spi_select();
-  SPI_send((addr>>16)|0x80);
-  SPI_send(((addr>>8)&0xFF));
-  SPI_send((addr&0xFF));
+  const FT_Bus_t *bus = FT_DEV_BUS(dev);
+
+  FT_bus_select(bus);
+  FT_bus_send(bus, (addr>>16)|0x80);
+  FT_bus_send(bus, ((addr>>8)&0xFF));
+  FT_bus_send(bus, (addr&0xFF));
 
   /* Little-Endian: Least Significant Byte to: smallest address */
-  SPI_send( (uint8_t)((data&0xFF)) );    //byte 0
-  SPI_send( (uint8_t)((data>>8)) );      //byte 1
+  FT_bus_send(bus,  (uint8_t)((data&0xFF)) );    //byte 0
+  FT_bus_send(bus,  (uint8_t)((data>>8)) );      //byte 1
   
-  FT_spi_deselect();  
+  FT_bus_deselect(bus);  
+  dev->spi_bytes += 5;
 }
 
 /*
-    Function: HOST_MEM_WR32
-    ARGS:     addr: 24 Bit Command Address 
+    Function: FT_wr32
+    ARGS:     dev:  device
+              addr: 24 Bit Command Address 
               data: 32bit (4 bytes)
 
     Description: Writes 4 bytes of data to addr
 */
-void HOST_MEM_WR32(uint32_t addr, uint32_t data)
+void FT_wr32(FT_Device_t *dev, uint32_t addr, uint32_t data)
 {
-  FT_spi_select();
-  SPI_send((addr>>16)|0x80);
-  SPI_send(((addr>>8)&0xFF));
-  SPI_send((addr&0xFF));
+  const FT_Bus_t *bus = FT_DEV_BUS(dev);
 
-  SPI_send( (uint8_t)(data&0xFF) );
-  SPI_send( (uint8_t)((data>>8)&0xFF) );
-  SPI_send( (uint8_t)((data>>16)&0xFF) );
-  SPI_send( (uint8_t)((data>>24)&0xFF) );
+  FT_bus_select(bus);
+  FT_bus_send(bus, (addr>>16)|0x80);
+  FT_bus_send(bus, ((addr>>8)&0xFF));
+  FT_bus_send(bus, (addr&0xFF));
+
+  FT_bus_send(bus,  (uint8_t)(data&0xFF) );
+  FT_bus_send(bus,  (uint8_t)((data>>8)&0xFF) );
+  FT_bus_send(bus,  (uint8_t)((data>>16)&0xFF) );
+  FT_bus_send(bus,  (uint8_t)((data>>24)&0xFF) );
   
-  FT_spi_deselect();  
+  FT_bus_deselect(bus);  
+  dev->spi_bytes += 7;
 }
 
 /*
-    Function: HOST_MEM_RD8
-    ARGS:     addr: 24 Bit Command Address 
+    Function: FT_rd8
+    ARGS:     dev:  device
+              addr: 24 Bit Command Address 
 
     Description: Returns 1 byte of data from addr
 */
-uint8_t HOST_MEM_RD8(uint32_t addr)
+uint8_t FT_rd8(FT_Device_t *dev, uint32_t addr)
 {
+  const FT_Bus_t *bus = FT_DEV_BUS(dev);
+
   uint8_t data_in;
 
-  FT_spi_select();
-  SPI_send((uint8_t)((addr>>16)&0x3F));
-  SPI_send((uint8_t)((addr>>8)&0xFF));
-  SPI_send((uint8_t)(addr));
-  SPI_send(0);
+  FT_bus_select(bus);
+  FT_bus_send(bus, (uint8_t)((addr>>16)&0x3F));
+  FT_bus_send(bus, (uint8_t)((addr>>8)&0xFF));
+  FT_bus_send(bus, (uint8_t)(addr));
+  FT_bus_send(bus, 0);
 
-  data_in = SPI_send(0);
+  data_in = FT_bus_send(bus, 0);
   
-  FT_spi_deselect();
+  FT_bus_deselect(bus);
+  dev->spi_bytes += 5;
   return data_in;
 }
 
 /*
-    Function: HOST_MEM_RD16
-    ARGS:     addr: 24 Bit Command Address 
+    Function: FT_rd16
+    ARGS:     dev:  device
+              addr: 24 Bit Command Address 
 
     Description: Returns 2 byte of data from addr in a 32bit variable
 */
-uint32_t HOST_MEM_RD16(uint32_t addr)
+uint32_t FT_rd16(FT_Device_t *dev, uint32_t addr)
 {
+  const FT_Bus_t *bus = FT_DEV_BUS(dev);
+
   uint8_t data_in = 0;
   uint32_t data = 0;
   uint8_t i;
 
-  FT_spi_select();
-  SPI_send(((addr>>16)&0x3F));
-  SPI_send(((addr>>8)&0xFF));
-  SPI_send((addr&0xFF));
-  SPI_send(0);
+  FT_bus_select(bus);
+  FT_bus_send(bus, ((addr>>16)&0x3F));
+  FT_bus_send(bus, ((addr>>8)&0xFF));
+  FT_bus_send(bus, (addr&0xFF));
+  FT_bus_send(bus, 0);
 
   for(i=0;i<2;i++)
   {
-    data_in = SPI_send(0);
+    data_in = FT_bus_send(bus, 0);
     data |= ( ((uint32_t)data_in) << (8*i) );
   }
   
-  FT_spi_deselect();
+  FT_bus_deselect(bus);
+  dev->spi_bytes += 6;
   return data;
 }
 
 /*
-    Function: HOST_MEM_RD32
-    ARGS:     addr: 24 Bit Command Address 
+    Function: FT_rd32
+    ARGS:     dev:  device
+              addr: 24 Bit Command Address 
 
     Description: Returns 4 byte of data from addr in a 32bit variable
 */
-uint32_t HOST_MEM_RD32(uint32_t addr)
+uint32_t FT_rd32(FT_Device_t *dev, uint32_t addr)
 {
+  const FT_Bus_t *bus = FT_DEV_BUS(dev);
+
   uint8_t data_in = 0;
   uint32_t data = 0;
   uint8_t i;
 
-  FT_spi_select();
-  SPI_send(((addr>>16)&0x3F));
-  SPI_send(((addr>>8)&0xFF));
-  SPI_send((addr&0xFF));
-  SPI_send(0);
+  FT_bus_select(bus);
+  FT_bus_send(bus, ((addr>>16)&0x3F));
+  FT_bus_send(bus, ((addr>>8)&0xFF));
+  FT_bus_send(bus, (addr&0xFF));
+  FT_bus_send(bus, 0);
 
   for(i=0;i<4;i++)
   {
-    data_in = SPI_send(0);
+    data_in = FT_bus_send(bus, 0);
     data |= ( ((uint32_t)data_in) << (8*i) );
   }
   
-  FT_spi_deselect();
+  FT_bus_deselect(bus);
+  dev->spi_bytes += 8;
   return data;
 }
 
+/*** Current Device **************************************************************/
+void HOST_MEM_READ_STR(uint32_t addr, uint8_t *pnt, uint32_t len)	{ FT_read(FT_dev, addr, pnt, len); }
+void HOST_MEM_WR_STR(uint32_t addr, uint8_t *pnt, uint32_t len)		{ FT_write(FT_dev, addr, pnt, len); }
+uint8_t HOST_MEM_BATCH(const HOST_MEM_Op_t *ops, uint32_t n)		{ return FT_batch(FT_dev, ops, n); }
+void HOST_CMD_WRITE(uint8_t CMD)									{ FT_host_cmd(FT_dev, CMD); }
+void HOST_CMD_ACTIVE(void)											{ FT_host_active(FT_dev); }
+void HOST_MEM_WR8(uint32_t addr, uint8_t data)						{ FT_wr8(FT_dev, addr, data); }
+void HOST_MEM_WR16(uint32_t addr, uint32_t data)					{ FT_wr16(FT_dev, addr, data); }
+void HOST_MEM_WR32(uint32_t addr, uint32_t data)					{ FT_wr32(FT_dev, addr, data); }
+uint8_t HOST_MEM_RD8(uint32_t addr)									{ return FT_rd8(FT_dev, addr); }
+uint32_t HOST_MEM_RD16(uint32_t addr)								{ return FT_rd16(FT_dev, addr); }
+uint32_t HOST_MEM_RD32(uint32_t addr)								{ return FT_rd32(FT_dev, addr); }
+
+/*** Device Context **************************************************************/
+/* Frame deduplication state, see cmd_frame() */
+struct FT_Dedup
+{
+	FT_Device_t *owner;					/* device using this buffer, NULL: free */
+	uint8_t  enabled;
+	uint8_t  state;						/* off / capturing a frame / passing an oversized frame through */
+	uint8_t  args;						/* argument words still to come of the last command */
+	uint8_t  op;						/* low byte of the last command */
+	uint8_t  flags;						/* FT_cmd_args() of the last command */
+	uint8_t  string;					/* inside the string of the last command */
+	uint32_t data;						/* inline data bytes still to come, FT_DATA_STREAM: until cmd_stream */
+	uint16_t len;						/* buffered words of the current frame */
+	uint32_t hash;						/* running hash of the current frame */
+	uint16_t last_len;					/* words of the last submitted frame, 0: none */
+	uint32_t last_hash;					/* hash of the last submitted frame */
+	uint32_t skipped;					/* number of dropped duplicate frames */
+	uint32_t buf[FT_DEDUP_WORDS];
+};
+
+#define DEDUP_OFF			0
+#define DEDUP_CAPTURE		1
+#define DEDUP_PASSTHROUGH	2
+
+static FT_Device_t FT_default;
+static struct FT_Dedup FT_dedup_pool[FT_DEDUP_DEVICES];
+FT_Device_t *FT_dev = &FT_default;
+
+/* the deduplication buffer of dev or a free one (cleared), NULL: all are taken */
+static struct FT_Dedup* dedup_claim(FT_Device_t *dev)
+{
+	struct FT_Dedup *d = 0;
+	uint8_t i;
+
+	for(i=0; i<FT_DEDUP_DEVICES && !d; ++i)
+	{
+		if(FT_dedup_pool[i].owner == dev) { d = &FT_dedup_pool[i]; }
+	}
+	for(i=0; i<FT_DEDUP_DEVICES && !d; ++i)
+	{
+		if(!FT_dedup_pool[i].owner) { d = &FT_dedup_pool[i]; }
+	}
+
+	if(d)
+	{
+		memset(d, 0, sizeof(struct FT_Dedup));
+		d->owner = dev;
+	}
+	return d;
+}
+
+/*
+    Function: FT_device_init
+    ARGS:     dev: device context
+              bus: SPI bus and pins of the device (only used with FT_MULTI_DEVICE)
+
+    Description: Clears a device context. The FIFO shadow is read back from
+                 the FT800 on the first co-processor command. The first
+                 FT_DEDUP_DEVICES devices get a frame deduplication buffer,
+                 cmd_dedup() has no effect on the others. The default device
+                 only takes a buffer when it is initialized or turns
+                 deduplication on.
+*/
+void FT_device_init(FT_Device_t *dev, const struct FT_Bus *bus)
+{
+	struct FT_Dedup *d = dedup_claim(dev);
+
+	memset(dev, 0, sizeof(FT_Device_t));
+	dev->bus = bus;
+	dev->dedup = d;
+}
+
+/*
+    Function: FT_device
+    ARGS:     dev: device context, NULL selects the default device
+
+    Description: Selects the device used by all following HOST_MEM_x and cmd_x
+                 calls. Devices on separate buses can be interleaved freely
+                 between calls.
+*/
+void FT_device(FT_Device_t *dev)
+{
+	FT_dev = dev ? dev : &FT_default;
+#ifdef FT_MULTI_DEVICE
+	FT_bus = FT_dev->bus ? FT_dev->bus : &FT_default_bus;
+#endif
+}
+
 /*** CMD Functions *****************************************************************/
-uint8_t cmd_execute(uint32_t data)
+/*
+	dev->cmd_wr shadows REG_CMD_WRITE (only the host writes it) and
+	dev->cmd_free holds the free FIFO space seen at the last REG_CMD_READ
+	sample. REG_CMD_READ is only read again when the shadow runs out of space.
+*/
+static uint8_t cmd_space(FT_Device_t *dev, uint32_t bytes)
 {
-	uint32_t cmdBufferRd = 0;
-    uint32_t cmdBufferWr = 0;
-    
-    cmdBufferRd = HOST_MEM_RD32(REG_CMD_READ);
-    cmdBufferWr = HOST_MEM_RD32(REG_CMD_WRITE);
-    
-    uint32_t cmdBufferDiff = cmdBufferWr-cmdBufferRd;
-    
-    if( (4096-cmdBufferDiff) > 4)
-    {
-        HOST_MEM_WR32(RAM_CMD + cmdBufferWr, data);
-        HOST_MEM_WR32(REG_CMD_WRITE, cmdBufferWr + 4);
-        return 1;
-    }
-    return 0;
+	if(!dev->cmd_valid)
+	{
+		dev->cmd_wr = FT_rd32(dev, REG_CMD_WRITE) & (FT_CMD_FIFO_SIZE-1);
+		dev->cmd_free = 0;
+		dev->cmd_valid = 1;
+	}
+
+	if(dev->cmd_free < bytes)
+	{
+#ifdef FT_PROF
+		uint32_t cmdBufferRd = (dev == FT_dev) ? PROF_sample() : FT_rd32(dev, REG_CMD_READ);	// the profiler follows the current device
+#else
+		uint32_t cmdBufferRd = FT_rd32(dev, REG_CMD_READ);
+#endif
+		dev->cmd_free = FT_CMD_FIFO_SIZE - FT_CMD_SIZE - ((dev->cmd_wr - cmdBufferRd) & (FT_CMD_FIFO_SIZE-1));
+	}
+
+#ifdef FT_PROF
+	if(dev == FT_dev) { PROF_stall(dev->cmd_free < bytes); }
+#endif
+	return (dev->cmd_free >= bytes) ? 1 : 0;
+}
+
+void FT_cmd_resync(FT_Device_t *dev)
+{
+	dev->cmd_valid = 0;
+	if(dev->dedup)
+	{
+		dev->dedup->state = DEDUP_OFF;	// the co-processor has restarted, nothing is buffered or on screen
+		dev->dedup->args = 0;
+		dev->dedup->string = 0;
+		dev->dedup->data = 0;
+		dev->dedup->last_len = 0;
+	}
+}
+
+uint8_t FT_cmd_execute(FT_Device_t *dev, uint32_t data)
+{
+	if(!cmd_space(dev, FT_CMD_SIZE)) { return 0; }
+
+	FT_wr32(dev, RAM_CMD + dev->cmd_wr, data);
+	dev->cmd_wr = (dev->cmd_wr + FT_CMD_SIZE) & (FT_CMD_FIFO_SIZE-1);
+	dev->cmd_free -= FT_CMD_SIZE;
+	dev->cmd_total += FT_CMD_SIZE;
+	FT_wr32(dev, REG_CMD_WRITE, dev->cmd_wr);
+	return 1;
 }
 
-uint8_t cmd(uint32_t data)
+static uint8_t cmd_write(FT_Device_t *dev, uint32_t data)
 {
 	uint8_t tryCount = 255;
 	for(tryCount = 255; tryCount > 0; --tryCount)
 	{
-		if(cmd_execute(data)) { return 1; }
+		if(FT_cmd_execute(dev, data)) { return 1; }
 	}
 	return 0;
 }
 
-uint8_t cmd_ready(void)
+/*
+    Function: cmd_stream
+    ARGS:     data: bytes to append to the co-processor FIFO
+              len:  number of bytes
+
+    Description: Writes len bytes into the co-processor FIFO, waiting for free
+                 space as needed and using as few SPI transactions as the free
+                 space and the FIFO wrap allow. A trailing partial word is
+                 padded with zeros, so when data is split over several calls
+                 all but the last one should be a multiple of 4 bytes.
+                 Returns 0 if the co-processor did not free up space.
+*/
+static uint8_t cmd_copy(FT_Device_t *dev, const uint8_t *data, uint32_t len)
+{
+	uint8_t tryCount = 255;
+	uint8_t tail[FT_CMD_SIZE] = { 0, 0, 0, 0 };
+	uint32_t pad = len & (FT_CMD_SIZE-1);
+
+	len -= pad;
+	while(len)
+	{
+		uint32_t n;
+
+		if(!cmd_space(dev, FT_CMD_SIZE))
+		{
+			if(!--tryCount) { return 0; }
+			continue;
+		}
+
+		n = FT_CMD_FIFO_SIZE - dev->cmd_wr;		// bytes until RAM_CMD wraps
+		if(n > dev->cmd_free) { n = dev->cmd_free; }
+		if(n > len) { n = len; }
+
+		FT_write(dev, RAM_CMD + dev->cmd_wr, (uint8_t*)data, n);
+		dev->cmd_wr = (dev->cmd_wr + n) & (FT_CMD_FIFO_SIZE-1);
+		dev->cmd_free -= n;
+		dev->cmd_total += n;
+		FT_wr32(dev, REG_CMD_WRITE, dev->cmd_wr);
+
+		data += n;
+		len -= n;
+		tryCount = 255;
+	}
+
+	if(pad)
+	{
+		uint32_t i;
+		for(i=0; i<pad; ++i) { tail[i] = data[i]; }
+		return cmd_copy(dev, tail, FT_CMD_SIZE);
+	}
+	return 1;
+}
+
+static void cmd_stream_parsed(FT_Device_t *dev, uint32_t len);
+static uint8_t cmd_flush(FT_Device_t *dev);
+
+uint8_t FT_cmd_stream(FT_Device_t *dev, const uint8_t *data, uint32_t len)
+{
+	uint32_t mark = dev->spi_bytes;
+	uint8_t ok;
+
+	if(!cmd_flush(dev)) { return 0; }		// the command of the data goes first
+	cmd_stream_parsed(dev, len);
+	ok = cmd_copy(dev, data, len);
+	dev->stream_bytes += dev->spi_bytes - mark;
+	return ok;
+}
+
+/*
+    Function: cmd_stream_some
+    ARGS:     data: bytes to append to the co-processor FIFO
+              len:  number of bytes
+
+    Description: Non-blocking cmd_stream: writes as much of data as the FIFO
+                 can take right now (whole words, a partial last word only
+                 when all of data fits) and returns the number of bytes
+                 written. Call again with the rest later.
+*/
+uint32_t FT_cmd_stream_some(FT_Device_t *dev, const uint8_t *data, uint32_t len)
+{
+	uint32_t n = (len + FT_CMD_SIZE-1) & ~(FT_CMD_SIZE-1);
+	uint32_t mark = dev->spi_bytes;
+
+	if(!cmd_flush(dev)) { return 0; }
+	if(n > FT_CMD_FIFO_SIZE - FT_CMD_SIZE) { n = FT_CMD_FIFO_SIZE - FT_CMD_SIZE; }
+	cmd_space(dev, n);						// re-reads REG_CMD_READ only if the shadow has less
+
+	n = (dev->cmd_free < len) ? dev->cmd_free : len;
+	if(n)
+	{
+		cmd_stream_parsed(dev, n);
+		if(!cmd_copy(dev, data, n)) { n = 0; }
+	}
+	dev->stream_bytes += dev->spi_bytes - mark;
+	return n;
+}
+
+/*** Frame Deduplication ***********************************************************/
+/*
+	Words between CMD_DLSTART and CMD_SWAP are collected in the dedup buffer of
+	the device while a running hash is updated word by word. On CMD_SWAP the
+	frame is dropped if it is identical to the last submitted one, otherwise it
+	is sent as a burst. Frames longer than the buffer are passed through and
+	never deduplicated.
+
+	Only words in command position start or end a frame: the parser skips the
+	argument words, strings and MEMWRITE data of every command (FT_cmd_args),
+	so e.g. a colour argument equal to CMD_SWAP is just data. The JPEG/zlib
+	data of CMD_LOADIMAGE and CMD_INFLATE has no length, it must be sent with
+	cmd_stream(), which ends it.
+*/
+#define FT_HASH_SEED		0x811C9DC5UL
+#define FT_DATA_STREAM		0xFFFFFFFFUL
+
+static inline uint32_t cmd_hash(uint32_t hash, uint32_t data)
+{
+	hash = (hash ^ data) * 0x9E3779B1UL;	// one multiply per word, no second pass
+	return hash ^ (hash >> 15);
+}
+
+/* advances the parser by one word, returns 1 if the word is a command or display list word */
+static uint8_t cmd_parse(struct FT_Dedup *d, uint32_t data)
+{
+	if(d->data)
+	{
+		if(d->data != FT_DATA_STREAM) { d->data = (d->data > FT_CMD_SIZE) ? d->data - FT_CMD_SIZE : 0; }
+		return 0;
+	}
+
+	if(d->args)
+	{
+		if(!--d->args)
+		{
+			if(d->flags & FT_ARGS_STRING) { d->string = 1; }
+			if(d->flags & FT_ARGS_DATA) { d->data = (d->op == (CMD_MEMWRITE & 0xFF)) ? ((data + FT_CMD_SIZE-1) & ~(FT_CMD_SIZE-1)) : FT_DATA_STREAM; }
+		}
+		return 0;
+	}
+
+	if(d->string)
+	{
+		if(FT_HAS_ZERO(data)) { d->string = 0; }
+		return 0;
+	}
+
+	d->op = (uint8_t)data;
+	d->flags = FT_cmd_args(data);
+	d->args = d->flags & FT_ARGS_COUNT;
+	return 1;
+}
+
+/* cmd_stream() data: MEMWRITE data counts down, LOADIMAGE/INFLATE data ends */
+static void cmd_stream_parsed(FT_Device_t *dev, uint32_t len)
+{
+	struct FT_Dedup *d = dev->dedup;
+
+	if(!d || !d->enabled) return;
+	len = (len + FT_CMD_SIZE-1) & ~(FT_CMD_SIZE-1);
+	d->data = (d->data == FT_DATA_STREAM || d->data <= len) ? 0 : d->data - len;
+}
+
+/* one word through the frame buffer, command: cmd_parse() of the word */
+static uint8_t cmd_frame(FT_Device_t *dev, uint32_t data, uint8_t command)
+{
+	struct FT_Dedup *d = dev->dedup;
+
+	if(d->state == DEDUP_OFF)
+	{
+		if(!command || data != CMD_DLSTART) { return cmd_write(dev, data); }
+
+		d->state = DEDUP_CAPTURE;
+		d->len = 0;
+		d->hash = FT_HASH_SEED;
+	}
+
+	if(d->state == DEDUP_PASSTHROUGH)
+	{
+		if(command && data == CMD_SWAP) { d->state = DEDUP_OFF; }
+		return cmd_write(dev, data);
+	}
+
+	d->buf[d->len++] = data;
+	d->hash = cmd_hash(d->hash, data);
+
+	if(command && data == CMD_SWAP)
+	{
+		d->state = DEDUP_OFF;
+		if(d->len == d->last_len && d->hash == d->last_hash)
+		{
+			++d->skipped;
+			return 1;
+		}
+
+		d->last_len = 0;
+		if(!cmd_copy(dev, (const uint8_t*)d->buf, d->len*FT_CMD_SIZE)) { return 0; }
+		d->last_len = d->len;
+		d->last_hash = d->hash;
+		return 1;
+	}
+
+	if(d->len == FT_DEDUP_WORDS)
+	{
+		d->state = DEDUP_PASSTHROUGH;
+		d->last_len = 0;
+		return cmd_copy(dev, (const uint8_t*)d->buf, d->len*FT_CMD_SIZE);
+	}
+	return 1;
+}
+
+/*
+	Commands that return a result in their FIFO slot (CMD_MEMCRC, CMD_CALIBRATE,
+	CMD_GETMATRIX) need their slot address in RAM_CMD, and cmd_stream() data
+	must follow its command. cmd_flush() writes the part of the frame captured
+	so far and passes the rest of the frame through, it is not deduplicated.
+*/
+static uint8_t cmd_flush(FT_Device_t *dev)
 {
-    uint32_t cmdBufferRd = HOST_MEM_RD32(REG_CMD_READ);
-    uint32_t cmdBufferWr = HOST_MEM_RD32(REG_CMD_WRITE);
+	struct FT_Dedup *d = dev->dedup;
+
+	if(!d || d->state != DEDUP_CAPTURE) { return 1; }
+	d->state = DEDUP_PASSTHROUGH;
+	d->last_len = 0;
+	return cmd_copy(dev, (const uint8_t*)d->buf, d->len*FT_CMD_SIZE);
+}
+
+/*
+    Function: cmd_burst
+    ARGS:     data:  command words
+              count: number of words
+
+    Description: Writes count words into the co-processor FIFO in bursts.
+                 With frame deduplication enabled the words of a frame go
+                 into the frame buffer like cmd() words, words outside a
+                 frame are still written in bursts.
+*/
+uint8_t FT_cmd_burst(FT_Device_t *dev, const uint32_t *data, uint32_t count)
+{
+	struct FT_Dedup *d = dev->dedup;
+	uint32_t i, run = 0;
+
+	if(!d || !d->enabled) { return cmd_copy(dev, (const uint8_t*)data, count*FT_CMD_SIZE); }
+
+	for(i=0; i<count; ++i)
+	{
+		uint8_t command = cmd_parse(d, data[i]);
+
+		if(d->state == DEDUP_CAPTURE || (d->state == DEDUP_OFF && command && data[i] == CMD_DLSTART))
+		{
+			if(run && !cmd_copy(dev, (const uint8_t*)&data[i-run], run*FT_CMD_SIZE)) { return 0; }
+			run = 0;
+			if(!cmd_frame(dev, data[i], command)) { return 0; }
+		}
+		else
+		{
+			if(command && data[i] == CMD_SWAP) { d->state = DEDUP_OFF; }	// end of a passed through frame
+			++run;
+		}
+	}
+	return run ? cmd_copy(dev, (const uint8_t*)&data[count-run], run*FT_CMD_SIZE) : 1;
+}
+
+void FT_cmd_dedup(FT_Device_t *dev, uint8_t enable)
+{
+	struct FT_Dedup *d = dev->dedup;
+
+	if(!d && enable) { d = dev->dedup = dedup_claim(dev); }
+	if(!d) return;
+	if(d->state == DEDUP_CAPTURE)
+	{
+		cmd_copy(dev, (const uint8_t*)d->buf, d->len*FT_CMD_SIZE);
+	}
+
+	d->enabled = enable;
+	d->state = DEDUP_OFF;
+	d->args = 0;
+	d->string = 0;
+	d->data = 0;
+	d->last_len = 0;
+}
+
+uint8_t FT_cmd_dedup_enabled(FT_Device_t *dev)
+{
+	return (dev->dedup && dev->dedup->enabled) ? 1 : 0;
+}
+
+uint32_t FT_cmd_dedup_skipped(FT_Device_t *dev)
+{
+	return dev->dedup ? dev->dedup->skipped : 0;
+}
+
+uint8_t FT_cmd(FT_Device_t *dev, uint32_t data)
+{
+	if(dev->dedup && dev->dedup->enabled) { return cmd_frame(dev, data, cmd_parse(dev->dedup, data)); }
+	return cmd_write(dev, data);
+}
+
+uint8_t FT_cmd_ready(FT_Device_t *dev)
+{
+    uint32_t cmdBufferRd = FT_rd32(dev, REG_CMD_READ);
     
-    return (cmdBufferRd == cmdBufferWr) ? 1 : 0;
+    if(!dev->cmd_valid) { cmd_space(dev, 0); }
+    dev->cmd_free = FT_CMD_FIFO_SIZE - FT_CMD_SIZE - ((dev->cmd_wr - cmdBufferRd) & (FT_CMD_FIFO_SIZE-1));
+    
+    return (cmdBufferRd == dev->cmd_wr) ? 1 : 0;
+}
+
+/*
+    Function: FT_cmd_wait
+    ARGS:     dev:   device context
+              polls: REG_CMD_READ reads before giving up
+
+    Description: Waits until the co-processor has executed the FIFO. Returns 0
+                 on timeout (co-processor stuck or fault).
+*/
+uint8_t FT_cmd_wait(FT_Device_t *dev, uint32_t polls)
+{
+	while(!FT_cmd_ready(dev))
+	{
+		if(!polls--) { return 0; }
+	}
+	return 1;
 }
 
 /*** Track *************************************************************************/
-void cmd_track(int16_t x, int16_t y, int16_t w, int16_t h, int16_t tag)
+void FT_cmd_track(FT_Device_t *dev, int16_t x, int16_t y, int16_t w, int16_t h, int16_t tag)
 {
-    cmd(CMD_TRACK);
-    cmd( ((uint32_t)y<<16)|(x & 0xffff) );
-    cmd( ((uint32_t)h<<16)|(w & 0xffff) );
-    cmd( (uint32_t)tag );
+    FT_cmd(dev, CMD_TRACK);
+    FT_cmd(dev,  ((uint32_t)y<<16)|(x & 0xffff) );
+    FT_cmd(dev,  ((uint32_t)h<<16)|(w & 0xffff) );
+    FT_cmd(dev,  (uint32_t)tag );
 }
 
 /*** Draw Spinner ******************************************************************/
-void cmd_spinner(int16_t x, int16_t y, uint16_t style, uint16_t scale)
+void FT_cmd_spinner(FT_Device_t *dev, int16_t x, int16_t y, uint16_t style, uint16_t scale)
 {    
-    cmd(CMD_SPINNER);
-    cmd( ((uint32_t)y<<16)|(x & 0xffff) );
-    cmd( ((uint32_t)scale<<16)|style );
+    FT_cmd(dev, CMD_SPINNER);
+    FT_cmd(dev,  ((uint32_t)y<<16)|(x & 0xffff) );
+    FT_cmd(dev,  ((uint32_t)scale<<16)|style );
     
 }
 
 /*** Draw Slider *******************************************************************/
-void cmd_slider(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t options, uint16_t val, uint16_t range)
+void FT_cmd_slider(FT_Device_t *dev, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t options, uint16_t val, uint16_t range)
 {
-	cmd(CMD_SLIDER);
-	cmd( ((uint32_t)y<<16)|(x & 0xffff) );
-	cmd( ((uint32_t)h<<16)|(w & 0xffff) );
-	cmd( ((uint32_t)val<<16)|(options & 0xffff) );
-	cmd( (uint32_t)range );
+	FT_cmd(dev, CMD_SLIDER);
+	FT_cmd(dev,  ((uint32_t)y<<16)|(x & 0xffff) );
+	FT_cmd(dev,  ((uint32_t)h<<16)|(w & 0xffff) );
+	FT_cmd(dev,  ((uint32_t)val<<16)|(options & 0xffff) );
+	FT_cmd(dev,  (uint32_t)range );
 }
 
 /*** Draw Text *********************************************************************/
-void cmd_text(int16_t x, int16_t y, int16_t font, uint16_t options, const char* str)
+void FT_cmd_text(FT_Device_t *dev, int16_t x, int16_t y, int16_t font, uint16_t options, const char* str)
 {
 	/* 	
 		i: data pointer
@@ -320,18 +886,18 @@ void cmd_text(int16_t x, int16_t y, int16_t font, uint16_t options, const char*
 		data[i] |= (uint32_t)str[q] << (j*8);
 	}
 	
-	cmd(CMD_TEXT);
-	cmd( ((uint32_t)y<<16)|(x & 0xffff) );
-    cmd( ((uint32_t)options<<16)|(font & 0xffff) );
+	FT_cmd(dev, CMD_TEXT);
+	FT_cmd(dev,  ((uint32_t)y<<16)|(x & 0xffff) );
+    FT_cmd(dev,  ((uint32_t)options<<16)|(font & 0xffff) );
 	for(j=0; j<(length/4)+1; ++j)
 	{
-		cmd(data[j]);
+		FT_cmd(dev, data[j]);
 	}
 	free(data);
 }
 
 /*** Draw Button *******************************************************************/
-void cmd_button(int16_t x, int16_t y, int16_t w, int16_t h, int16_t font, uint16_t options, const char* str)
+void FT_cmd_button(FT_Device_t *dev, int16_t x, int16_t y, int16_t w, int16_t h, int16_t font, uint16_t options, const char* str)
 {	
 	/* 	
 		i: data pointer
@@ -355,19 +921,19 @@ void cmd_button(int16_t x, int16_t y, int16_t w, int16_t h, int16_t font, uint16
 		data[i] |= (uint32_t)str[q] << (j*8);
 	}
 	
-	cmd(CMD_BUTTON);
-	cmd( ((uint32_t)y<<16)|(x & 0xffff) );
-	cmd( ((uint32_t)h<<16)|(w & 0xffff) );
-    cmd( ((uint32_t)options<<16)|(font & 0xffff) );
+	FT_cmd(dev, CMD_BUTTON);
+	FT_cmd(dev,  ((uint32_t)y<<16)|(x & 0xffff) );
+	FT_cmd(dev,  ((uint32_t)h<<16)|(w & 0xffff) );
+    FT_cmd(dev,  ((uint32_t)options<<16)|(font & 0xffff) );
 	for(j=0; j<(length/4)+1; ++j)
 	{
-		cmd(data[j]);
+		FT_cmd(dev, data[j]);
 	}
 	free(data);
 }
 
 /*** Draw Keyboard *****************************************************************/
-void cmd_keys(int16_t x, int16_t y, int16_t w, int16_t h, int16_t font, uint16_t options, const char* str)
+void FT_cmd_keys(FT_Device_t *dev, int16_t x, int16_t y, int16_t w, int16_t h, int16_t font, uint16_t options, const char* str)
 {
 	/* 	
 		i: data pointer
@@ -391,76 +957,288 @@ void cmd_keys(int16_t x, int16_t y, int16_t w, int16_t h, int16_t font, uint16_t
 		data[i] |= (uint32_t)str[q] << (j*8);
 	}
 	
-	cmd(CMD_KEYS);
-	cmd( ((uint32_t)y<<16)|(x & 0xffff) );
-	cmd( ((uint32_t)h<<16)|(w & 0xffff) );
-    cmd( ((uint32_t)options<<16)|(font & 0xffff) );
+	FT_cmd(dev, CMD_KEYS);
+	FT_cmd(dev,  ((uint32_t)y<<16)|(x & 0xffff) );
+	FT_cmd(dev,  ((uint32_t)h<<16)|(w & 0xffff) );
+    FT_cmd(dev,  ((uint32_t)options<<16)|(font & 0xffff) );
 	for(j=0; j<(length/4)+1; ++j)
 	{
-		cmd(data[j]);
+		FT_cmd(dev, data[j]);
 	}
 	free(data);
 }
 
 /*** Write zero to a block of memory ***********************************************/
-void cmd_memzero(uint32_t ptr, uint32_t num)
+void FT_cmd_memzero(FT_Device_t *dev, uint32_t ptr, uint32_t num)
+{
+	FT_cmd(dev, CMD_MEMZERO);
+	FT_cmd(dev, ptr);
+	FT_cmd(dev, num);
+}
+
+/*** Compute CRC-32 of a block of memory ******************************************/
+uint32_t FT_cmd_memcrc(FT_Device_t *dev, uint32_t ptr, uint32_t num)
+{
+	uint32_t result;
+
+	if(!cmd_flush(dev)) { return 0; }	// a buffered frame goes first, the result slot is in the FIFO
+	if(!FT_cmd(dev, CMD_MEMCRC) || !FT_cmd(dev, ptr) || !FT_cmd(dev, num)) { return 0; }
+	result = dev->cmd_wr;			// the co-processor writes the CRC over this word
+	if(!FT_cmd(dev, 0)) { return 0; }
+
+	if(!FT_cmd_wait(dev, FT_CMD_TIMEOUT)) { return 0; }
+	return FT_rd32(dev, RAM_CMD + result);
+}
+
+/*** Touch screen calibration ****************************************************/
+/*
+    Function: cmd_calibrate
+    ARGS:     none
+
+    Description: Runs the interactive calibration (the user taps three dots)
+                 and waits for it. The transform is left in
+                 REG_TOUCH_TRANSFORM_A..F. Returns 0 if calibration failed.
+*/
+uint32_t FT_cmd_calibrate(FT_Device_t *dev)
+{
+	uint32_t result;
+
+	if(!cmd_flush(dev)) { return 0; }
+	FT_cmd(dev, CMD_CALIBRATE);
+	result = dev->cmd_wr;			// the co-processor writes the result over this word
+	FT_cmd(dev, 0);
+
+	while(!FT_cmd_ready(dev));
+	return FT_rd32(dev, RAM_CMD + result);
+}
+
+/*** Decompress data into memory *************************************************/
+void FT_cmd_inflate(FT_Device_t *dev, uint32_t ptr)
 {
-	cmd(CMD_MEMZERO);
-	cmd(ptr);
-	cmd(num);
+	FT_cmd(dev, CMD_INFLATE);
+	FT_cmd(dev, ptr);
+}
+
+/*** Load a JPEG image *************************************************************/
+void FT_cmd_loadimage(FT_Device_t *dev, uint32_t ptr, uint32_t options)
+{
+	FT_cmd(dev, CMD_LOADIMAGE);
+	FT_cmd(dev, ptr);
+	FT_cmd(dev, options);
+}
+
+/*** Register a custom font ********************************************************/
+void FT_cmd_setfont(FT_Device_t *dev, uint32_t font, uint32_t ptr)
+{
+	FT_cmd(dev, CMD_SETFONT);
+	FT_cmd(dev, font);
+	FT_cmd(dev, ptr);
 }
 
 /*** Set FG color ******************************************************************/
-void cmd_fgcolor(uint32_t c)
+void FT_cmd_fgcolor(FT_Device_t *dev, uint32_t c)
 {
-	cmd(CMD_FGCOLOR);
-	cmd(c);
+	FT_cmd(dev, CMD_FGCOLOR);
+	FT_cmd(dev, c);
 }
 
 /*** Set BG color ******************************************************************/
-void cmd_bgcolor(uint32_t c)
+void FT_cmd_bgcolor(FT_Device_t *dev, uint32_t c)
 {
-	cmd(CMD_BGCOLOR);
-	cmd(c);
+	FT_cmd(dev, CMD_BGCOLOR);
+	FT_cmd(dev, c);
 }
 
 /*** Set Gradient color ************************************************************/
-void cmd_gradcolor(uint32_t c)
+void FT_cmd_gradcolor(FT_Device_t *dev, uint32_t c)
 {
-	cmd(CMD_GRADCOLOR);
-	cmd(c);
+	FT_cmd(dev, CMD_GRADCOLOR);
+	FT_cmd(dev, c);
 }
 
 /*** Draw Gradient *****************************************************************/
-void cmd_gradient(int16_t x0, int16_t y0, uint32_t rgb0, int16_t x1, int16_t y1, uint32_t rgb1)
+void FT_cmd_gradient(FT_Device_t *dev, int16_t x0, int16_t y0, uint32_t rgb0, int16_t x1, int16_t y1, uint32_t rgb1)
 {
-	cmd(CMD_GRADIENT);
-	cmd( ((uint32_t)y0<<16)|(x0 & 0xffff) );
-	cmd(rgb0);
-	cmd( ((uint32_t)y1<<16)|(x1 & 0xffff) );
-	cmd(rgb1);
+	FT_cmd(dev, CMD_GRADIENT);
+	FT_cmd(dev,  ((uint32_t)y0<<16)|(x0 & 0xffff) );
+	FT_cmd(dev, rgb0);
+	FT_cmd(dev,  ((uint32_t)y1<<16)|(x1 & 0xffff) );
+	FT_cmd(dev, rgb1);
 }
 
 /*** Matrix Functions **************************************************************/
+void FT_cmd_loadidentity(FT_Device_t *dev)
+{
+	FT_cmd(dev, CMD_LOADIDENTITY);
+}
+
+void FT_cmd_setmatrix(FT_Device_t *dev)
+{
+	FT_cmd(dev, CMD_SETMATRIX);
+}
+
+void FT_cmd_rotate(FT_Device_t *dev, int32_t angle)
+{
+	FT_cmd(dev, CMD_ROTATE);
+	FT_cmd(dev, angle);
+}
+
+void FT_cmd_translate(FT_Device_t *dev, int32_t tx, int32_t ty)
+{
+	FT_cmd(dev, CMD_TRANSLATE);
+	FT_cmd(dev, tx);
+	FT_cmd(dev, ty);
+}
+
+void FT_cmd_scale(FT_Device_t *dev, int32_t sx, int32_t sy)
+{
+	FT_cmd(dev, CMD_SCALE);
+	FT_cmd(dev, sx);
+	FT_cmd(dev, sy);
+}
+
+/*
+    Function: cmd_getmatrix
+    ARGS:     m: the six coefficients a..f of the current matrix, in the
+                 format of BITMAP_TRANSFORM_A..F
+
+    Description: Reads back the current matrix and waits for it. Returns 0
+                 on timeout (max. FT_CMD_TIMEOUT polls).
+*/
+uint8_t FT_cmd_getmatrix(FT_Device_t *dev, int32_t *m)
+{
+	uint32_t result;
+	uint8_t i;
+
+	if(!cmd_flush(dev)) { return 0; }
+	FT_cmd(dev, CMD_GETMATRIX);
+	result = dev->cmd_wr;			// the co-processor writes a..f over these words
+	for(i=0; i<6; ++i) { FT_cmd(dev, 0); }
+
+	if(!FT_cmd_wait(dev, FT_CMD_TIMEOUT)) { return 0; }
+	for(i=0; i<6; ++i) { m[i] = (int32_t)FT_rd32(dev, RAM_CMD + ((result + 4*i) & (FT_CMD_FIFO_SIZE-1))); }
+	return 1;
+}
+
+/*** Current Device **************************************************************/
+uint8_t cmd(uint32_t data)									{ return FT_cmd(FT_dev, data); }
+uint8_t cmd_execute(uint32_t data)							{ return FT_cmd_execute(FT_dev, data); }
+uint8_t cmd_burst(const uint32_t *data, uint32_t count)		{ return FT_cmd_burst(FT_dev, data, count); }
+uint8_t cmd_stream(const uint8_t *data, uint32_t len)		{ return FT_cmd_stream(FT_dev, data, len); }
+uint32_t cmd_stream_some(const uint8_t *data, uint32_t len)	{ return FT_cmd_stream_some(FT_dev, data, len); }
+uint8_t cmd_ready(void)										{ return FT_cmd_ready(FT_dev); }
+uint8_t cmd_wait(uint32_t polls)							{ return FT_cmd_wait(FT_dev, polls); }
+void cmd_resync(void)										{ FT_cmd_resync(FT_dev); }
+void cmd_dedup(uint8_t enable)								{ FT_cmd_dedup(FT_dev, enable); }
+uint8_t cmd_dedup_enabled(void)								{ return FT_cmd_dedup_enabled(FT_dev); }
+uint32_t cmd_dedup_skipped(void)							{ return FT_cmd_dedup_skipped(FT_dev); }
+
+void cmd_track(int16_t x, int16_t y, int16_t w, int16_t h, int16_t tag)
+{
+	FT_cmd_track(FT_dev, x, y, w, h, tag);
+}
+
+void cmd_spinner(int16_t x, int16_t y, uint16_t style, uint16_t scale)
+{
+	FT_cmd_spinner(FT_dev, x, y, style, scale);
+}
+
+void cmd_slider(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t options, uint16_t val, uint16_t range)
+{
+	FT_cmd_slider(FT_dev, x, y, w, h, options, val, range);
+}
+
+void cmd_text(int16_t x, int16_t y, int16_t font, uint16_t options, const char* str)
+{
+	FT_cmd_text(FT_dev, x, y, font, options, str);
+}
+
+void cmd_button(int16_t x, int16_t y, int16_t w, int16_t h, int16_t font, uint16_t options, const char* str)
+{
+	FT_cmd_button(FT_dev, x, y, w, h, font, options, str);
+}
+
+void cmd_keys(int16_t x, int16_t y, int16_t w, int16_t h, int16_t font, uint16_t options, const char* str)
+{
+	FT_cmd_keys(FT_dev, x, y, w, h, font, options, str);
+}
+
+void cmd_memzero(uint32_t ptr, uint32_t num)
+{
+	FT_cmd_memzero(FT_dev, ptr, num);
+}
+
+uint32_t cmd_memcrc(uint32_t ptr, uint32_t num)
+{
+	return FT_cmd_memcrc(FT_dev, ptr, num);
+}
+
+uint32_t cmd_calibrate(void)
+{
+	return FT_cmd_calibrate(FT_dev);
+}
+
+void cmd_inflate(uint32_t ptr)
+{
+	FT_cmd_inflate(FT_dev, ptr);
+}
+
+void cmd_loadimage(uint32_t ptr, uint32_t options)
+{
+	FT_cmd_loadimage(FT_dev, ptr, options);
+}
+
+void cmd_setfont(uint32_t font, uint32_t ptr)
+{
+	FT_cmd_setfont(FT_dev, font, ptr);
+}
+
+void cmd_fgcolor(uint32_t c)
+{
+	FT_cmd_fgcolor(FT_dev, c);
+}
+
+void cmd_bgcolor(uint32_t c)
+{
+	FT_cmd_bgcolor(FT_dev, c);
+}
+
+void cmd_gradcolor(uint32_t c)
+{
+	FT_cmd_gradcolor(FT_dev, c);
+}
+
+void cmd_gradient(int16_t x0, int16_t y0, uint32_t rgb0, int16_t x1, int16_t y1, uint32_t rgb1)
+{
+	FT_cmd_gradient(FT_dev, x0, y0, rgb0, x1, y1, rgb1);
+}
+
 void cmd_loadidentity(void)
 {
-	cmd(CMD_LOADIDENTITY);
+	FT_cmd_loadidentity(FT_dev);
 }
 
 void cmd_setmatrix(void)
 {
-	cmd(CMD_SETMATRIX);
+	FT_cmd_setmatrix(FT_dev);
 }
 
 void cmd_rotate(int32_t angle)
 {
-	cmd(CMD_ROTATE);
-	cmd(angle);
+	FT_cmd_rotate(FT_dev, angle);
 }
 
 void cmd_translate(int32_t tx, int32_t ty)
 {
-	cmd(CMD_TRANSLATE);
-	cmd(tx);
-	cmd(ty);
+	FT_cmd_translate(FT_dev, tx, ty);
+}
+
+void cmd_scale(int32_t sx, int32_t sy)
+{
+	FT_cmd_scale(FT_dev, sx, sy);
+}
+
+uint8_t cmd_getmatrix(int32_t *m)
+{
+	return FT_cmd_getmatrix(FT_dev, m);
 }
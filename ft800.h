@@ -21,6 +21,9 @@
 #define FT_DL_SIZE           (8*1024)  //8KB Display List buffer size
 #define FT_CMD_FIFO_SIZE     (4*1024)  //4KB coprocessor Fifo size
 #define FT_CMD_SIZE          (4)       //4 byte per coprocessor command of EVE
+#ifndef FT_CMD_TIMEOUT
+#define FT_CMD_TIMEOUT       (100000UL)  //REG_CMD_READ polls a result command (cmd_memcrc) waits at most
+#endif
 
 #define FT800_VERSION "1.9.0"
 #define ADC_DIFFERENTIAL     1UL
@@ -325,12 +328,152 @@ typedef struct FT_Gpu_Fonts
 } FT_Gpu_Fonts_t;
 
 
+/* Argument words of a co-processor command (low 6 bits), FT_ARGS_STRING:
+   followed by a zero terminated string, FT_ARGS_DATA: followed by inline
+   data (MEMWRITE: num bytes, INFLATE: zlib stream, LOADIMAGE: JPEG file).
+   Words that are not commands are display list words. */
+#define FT_ARGS_COUNT        0x3F
+#define FT_ARGS_STRING       0x40
+#define FT_ARGS_DATA         0x80
+
+static inline uint8_t FT_cmd_args(uint32_t c)
+{
+	static const uint8_t args[] =
+	{
+		0, 0, 1, 1, 0, 0, 0, 0,			/* DLSTART SWAP INTERRUPT CRC HAMMERAUX MARCH IDCT EXECUTE */
+		0, 1, 1, 4,						/* GETPOINT BGCOLOR FGCOLOR GRADIENT */
+		2|FT_ARGS_STRING, 3|FT_ARGS_STRING, 3|FT_ARGS_STRING, 4,	/* TEXT BUTTON KEYS PROGRESS */
+		4, 4, 3|FT_ARGS_STRING, 4, 4,	/* SLIDER SCROLLBAR TOGGLE GAUGE CLOCK */
+		1, 2, 0, 3, 2, 2|FT_ARGS_DATA,	/* CALIBRATE SPINNER STOP MEMCRC REGREAD MEMWRITE */
+		3, 2, 3, 2, 1, 13, 13,			/* MEMSET MEMZERO MEMCPY APPEND SNAPSHOT TOUCH_TRANSFORM BITMAP_TRANSFORM */
+		1|FT_ARGS_DATA, 1, 2|FT_ARGS_DATA, 3,	/* INFLATE GETPTR LOADIMAGE GETPROPS */
+		0, 2, 2, 1, 0, 2, 3, 3, 3,		/* LOADIDENTITY TRANSLATE SCALE ROTATE SETMATRIX SETFONT TRACK DIAL NUMBER */
+		0, 4, 0, 0, 6, 1				/* SCREENSAVER SKETCH LOGO COLDSTART GETMATRIX GRADCOLOR */
+	};
+
+	if((c & 0xFFFFFF00UL) != 0xFFFFFF00UL || (c & 0xFF) >= sizeof(args)) return 0;
+	return args[c & 0xFF];
+}
+
+/* a command word of the FT800 (0xFFFFFF00 .. 0xFFFFFF34) */
+#define FT_IS_CMD(c)         (((c) & 0xFFFFFF00UL) == 0xFFFFFF00UL && ((c) & 0xFF) <= 0x34)
+
+/* a string word that contains the terminating zero */
+#define FT_HAS_ZERO(w)       ((((w) - 0x01010101UL) & ~(w) & 0x80808080UL) != 0)
+
+
+/* Frame deduplication buffer size */
+#ifndef FT_DEDUP_WORDS
+#define FT_DEDUP_WORDS       (FT_CMD_FIFO_SIZE/FT_CMD_SIZE)	//longest frame (in words) that can be deduplicated
+#endif
+
+#ifndef FT_DEVICES
+#ifdef FT_MULTI_DEVICE
+#define FT_DEVICES           2		//FT800s driven by the application (FT_device_init calls)
+#else
+#define FT_DEVICES           1
+#endif
+#endif
+
+#ifndef FT_DEDUP_DEVICES
+#define FT_DEDUP_DEVICES     FT_DEVICES	//devices that can use frame deduplication
+#endif
+
+
+/* One transfer of HOST_MEM_BATCH */
+#define HOST_MEM_WRITE       0
+#define HOST_MEM_READ        1
+
+typedef struct
+{
+	uint32_t addr;						/* FT800 address */
+	uint8_t *buf;						/* data to write / buffer to read into */
+	uint32_t len;						/* bytes */
+	uint8_t  dir;						/* HOST_MEM_WRITE / HOST_MEM_READ */
+} HOST_MEM_Op_t;
+
+
+/* FT800 device context */
+struct FT_Bus;
+struct FT_Dedup;
+
+typedef struct
+{
+	const struct FT_Bus *bus;			/* SPI bus and pins (see spi.h), NULL: default bus */
+	uint8_t  cmd_valid;					/* FIFO shadow is in sync with the FT800 */
+	uint32_t cmd_wr;					/* shadow of REG_CMD_WRITE */
+	uint32_t cmd_free;					/* free FIFO bytes at the last REG_CMD_READ sample */
+	uint32_t cmd_total;					/* bytes written to the FIFO, wraps */
+	uint32_t spi_bytes;					/* SPI bytes exchanged with the device (all transactions), wraps */
+	uint32_t stream_bytes;				/* part of spi_bytes spent in cmd_stream / cmd_stream_some, wraps */
+	struct FT_Dedup *dedup;				/* frame deduplication state (private), NULL: none */
+} FT_Device_t;
+
+extern FT_Device_t *FT_dev;				/* current device of the HOST_MEM_x and cmd_x functions */
+
+
 /* FT800 FUNCTIONS *****************************************************************/
+void FT_device_init(FT_Device_t *dev, const struct FT_Bus *bus);	/* clear a device context */
+void FT_device(FT_Device_t *dev);								/* select device for all following calls (NULL: default device) */
+
+/*
+	Device API: the same functions with an explicit device context. They keep
+	no state outside dev, so two devices can be driven from two threads or
+	interrupt levels. HOST_MEM_x and cmd_x below call them with FT_dev.
+*/
+void FT_host_active(FT_Device_t *dev);												/* HOST_CMD_ACTIVE */
+void FT_host_cmd(FT_Device_t *dev, uint8_t CMD);									/* HOST_CMD_WRITE */
+void FT_read(FT_Device_t *dev, uint32_t addr, uint8_t *pnt, uint32_t len);			/* HOST_MEM_READ_STR */
+void FT_write(FT_Device_t *dev, uint32_t addr, const uint8_t *pnt, uint32_t len);	/* HOST_MEM_WR_STR */
+uint8_t FT_batch(FT_Device_t *dev, const HOST_MEM_Op_t *ops, uint32_t n);			/* HOST_MEM_BATCH */
+void FT_wr8(FT_Device_t *dev, uint32_t addr, uint8_t data);		/* HOST_MEM_WR8 */
+void FT_wr16(FT_Device_t *dev, uint32_t addr, uint32_t data);	/* HOST_MEM_WR16 */
+void FT_wr32(FT_Device_t *dev, uint32_t addr, uint32_t data);	/* HOST_MEM_WR32 */
+uint8_t FT_rd8(FT_Device_t *dev, uint32_t addr);				/* HOST_MEM_RD8 */
+uint32_t FT_rd16(FT_Device_t *dev, uint32_t addr);				/* HOST_MEM_RD16 */
+uint32_t FT_rd32(FT_Device_t *dev, uint32_t addr);				/* HOST_MEM_RD32 */
+
+uint8_t FT_cmd_ready(FT_Device_t *dev);										/* cmd_ready */
+uint8_t FT_cmd_wait(FT_Device_t *dev, uint32_t polls);						/* cmd_wait */
+uint8_t FT_cmd(FT_Device_t *dev, uint32_t data);							/* cmd */
+uint8_t FT_cmd_execute(FT_Device_t *dev, uint32_t data);					/* cmd_execute */
+uint8_t FT_cmd_burst(FT_Device_t *dev, const uint32_t *data, uint32_t count);	/* cmd_burst */
+uint8_t FT_cmd_stream(FT_Device_t *dev, const uint8_t *data, uint32_t len);		/* cmd_stream */
+uint32_t FT_cmd_stream_some(FT_Device_t *dev, const uint8_t *data, uint32_t len);	/* cmd_stream_some */
+void FT_cmd_resync(FT_Device_t *dev);										/* cmd_resync */
+void FT_cmd_dedup(FT_Device_t *dev, uint8_t enable);						/* cmd_dedup */
+uint8_t FT_cmd_dedup_enabled(FT_Device_t *dev);								/* cmd_dedup_enabled */
+uint32_t FT_cmd_dedup_skipped(FT_Device_t *dev);							/* cmd_dedup_skipped */
+
+void FT_cmd_track(FT_Device_t *dev, int16_t x, int16_t y, int16_t w, int16_t h, int16_t tag);
+void FT_cmd_spinner(FT_Device_t *dev, int16_t x, int16_t y, uint16_t style, uint16_t scale);
+void FT_cmd_slider(FT_Device_t *dev, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t options, uint16_t val, uint16_t range);
+void FT_cmd_text(FT_Device_t *dev, int16_t x, int16_t y, int16_t font, uint16_t options, const char* str);
+void FT_cmd_button(FT_Device_t *dev, int16_t x, int16_t y, int16_t w, int16_t h, int16_t font, uint16_t options, const char* str);
+void FT_cmd_keys(FT_Device_t *dev, int16_t x, int16_t y, int16_t w, int16_t h, int16_t font, uint16_t options, const char* str);
+void FT_cmd_memzero(FT_Device_t *dev, uint32_t ptr, uint32_t num);
+uint32_t FT_cmd_memcrc(FT_Device_t *dev, uint32_t ptr, uint32_t num);
+uint32_t FT_cmd_calibrate(FT_Device_t *dev);
+void FT_cmd_inflate(FT_Device_t *dev, uint32_t ptr);
+void FT_cmd_loadimage(FT_Device_t *dev, uint32_t ptr, uint32_t options);
+void FT_cmd_setfont(FT_Device_t *dev, uint32_t font, uint32_t ptr);
+void FT_cmd_fgcolor(FT_Device_t *dev, uint32_t c);
+void FT_cmd_bgcolor(FT_Device_t *dev, uint32_t c);
+void FT_cmd_gradcolor(FT_Device_t *dev, uint32_t c);
+void FT_cmd_gradient(FT_Device_t *dev, int16_t x0, int16_t y0, uint32_t rgb0, int16_t x1, int16_t y1, uint32_t rgb1);
+void FT_cmd_loadidentity(FT_Device_t *dev);
+void FT_cmd_setmatrix(FT_Device_t *dev);
+void FT_cmd_rotate(FT_Device_t *dev, int32_t angle);
+void FT_cmd_translate(FT_Device_t *dev, int32_t tx, int32_t ty);
+void FT_cmd_scale(FT_Device_t *dev, int32_t sx, int32_t sy);
+uint8_t FT_cmd_getmatrix(FT_Device_t *dev, int32_t *m);
+
 void HOST_CMD_ACTIVE(void);			/* send host command activate (wake-up command */
 void HOST_CMD_WRITE(uint8_t CMD);	/* send host command */
 
-void HOST_MEM_READ_STR(uint32_t addr, uint8_t *pnt, uint8_t len);	/* read len bytes of data from memory */
-void HOST_MEM_WR_STR(uint32_t addr, uint8_t *pnt, uint8_t len);		/* write len bytes of data into memory */
+void HOST_MEM_READ_STR(uint32_t addr, uint8_t *pnt, uint32_t len);	/* read len bytes of data from memory */
+void HOST_MEM_WR_STR(uint32_t addr, uint8_t *pnt, uint32_t len);		/* write len bytes of data into memory */
+uint8_t HOST_MEM_BATCH(const HOST_MEM_Op_t *ops, uint32_t n);	/* run n reads/writes in order, consecutive address-adjacent ones share one transaction (returns 0: unknown dir, nothing sent) */
 
 void HOST_MEM_WR8(uint32_t addr, uint8_t data);		/* write  8bit (1byte)  data to memory */
 void HOST_MEM_WR16(uint32_t addr, uint32_t data);	/* write 16bit (2bytes) data to memory */
@@ -341,8 +484,17 @@ uint32_t HOST_MEM_RD32(uint32_t addr);				/* read  32bit (4bytes) data from memo
 
 /*** CO-PROCESSOR ******************************************************************/
 uint8_t cmd_ready(void);				/* check if co-processor is ready */
+uint8_t cmd_wait(uint32_t polls);		/* wait until co-processor is ready (returns 0: timeout after polls reads) */
 uint8_t cmd(uint32_t data);				/* command function (tries to execute command max. 255 times) */
 uint8_t cmd_execute(uint32_t data);		/* execute function (returns 0: when failed to execute command, ie. co-p. is busy) */
+uint8_t cmd_burst(const uint32_t *data, uint32_t count);	/* write several command words in bursts */
+uint8_t cmd_stream(const uint8_t *data, uint32_t len);		/* write data bytes (e.g. for cmd_inflate) into the FIFO with flow control */
+uint32_t cmd_stream_some(const uint8_t *data, uint32_t len);	/* write as many data bytes as fit now, returns bytes written (doesn't wait) */
+void cmd_resync(void);					/* re-read REG_CMD_WRITE after the co-processor has been reset */
+
+void cmd_dedup(uint8_t enable);			/* drop frames identical to the previous one (CMD_DLSTART..CMD_SWAP) */
+uint8_t cmd_dedup_enabled(void);		/* frame deduplication is on */
+uint32_t cmd_dedup_skipped(void);		/* number of frames dropped by deduplication */
 
 void cmd_track(int16_t x, int16_t y, int16_t w, int16_t h, int16_t tag);										/* set touch engine for tracking */
 void cmd_spinner(int16_t x, int16_t y, uint16_t style, uint16_t scale);											/* draw spinner */
@@ -353,6 +505,11 @@ void cmd_button(int16_t x, int16_t y, int16_t w, int16_t h, int16_t font, uint16
 void cmd_keys(int16_t x, int16_t y, int16_t w, int16_t h, int16_t font, uint16_t options, const char* str);		/* draw keyboard */
 
 void cmd_memzero(uint32_t ptr, uint32_t num);	/* write zero to a block of memory */
+uint32_t cmd_memcrc(uint32_t ptr, uint32_t num);	/* compute CRC-32 of a block of memory (waits for the result, max. FT_CMD_TIMEOUT polls) */
+uint32_t cmd_calibrate(void);					/* interactive touch calibration (waits for the result) */
+void cmd_inflate(uint32_t ptr);							/* decompress the following cmd_stream data into memory */
+void cmd_loadimage(uint32_t ptr, uint32_t options);		/* decode the following cmd_stream JPEG data into memory */
+void cmd_setfont(uint32_t font, uint32_t ptr);			/* use the font metric block at ptr for bitmap handle font */
 
 void cmd_fgcolor(uint32_t c);			/* set widget foreground color */
 void cmd_bgcolor(uint32_t c);			/* set widget background color */
@@ -363,5 +520,42 @@ void cmd_loadidentity(void);				/* set current matrix to the identity matrix */
 void cmd_setmatrix(void);					/* write current matrix to the display list */
 void cmd_rotate(int32_t angle);				/* apply rotation to the current matrix */
 void cmd_translate(int32_t tx, int32_t ty);	/* apply translation to the current matrix */
+void cmd_scale(int32_t sx, int32_t sy);		/* apply scaling to the current matrix */
+uint8_t cmd_getmatrix(int32_t *m);			/* read back the current matrix a..f (waits for the result, max. FT_CMD_TIMEOUT polls) */
+
+/*** PROFILER **********************************************************************/
+/* With FT_PROF defined every cmd_x call records its call site (see prof.h) */
+#if defined(FT_PROF) && !defined(FT_PROF_NO_SITES)
+#include "prof.h"
+
+#define FT_PROF_SITE(call)	(PROF_site(__FILE__, __LINE__), (call))
+
+#define cmd(data)			(PROF_site(0, 0), (cmd)(data))
+#define cmd_burst(...)		FT_PROF_SITE((cmd_burst)(__VA_ARGS__))
+#define cmd_stream(...)		FT_PROF_SITE((cmd_stream)(__VA_ARGS__))
+#define cmd_stream_some(...)	FT_PROF_SITE((cmd_stream_some)(__VA_ARGS__))
+#define cmd_track(...)		FT_PROF_SITE((cmd_track)(__VA_ARGS__))
+#define cmd_spinner(...)	FT_PROF_SITE((cmd_spinner)(__VA_ARGS__))
+#define cmd_slider(...)		FT_PROF_SITE((cmd_slider)(__VA_ARGS__))
+#define cmd_text(...)		FT_PROF_SITE((cmd_text)(__VA_ARGS__))
+#define cmd_button(...)		FT_PROF_SITE((cmd_button)(__VA_ARGS__))
+#define cmd_keys(...)		FT_PROF_SITE((cmd_keys)(__VA_ARGS__))
+#define cmd_memzero(...)	FT_PROF_SITE((cmd_memzero)(__VA_ARGS__))
+#define cmd_memcrc(...)		FT_PROF_SITE((cmd_memcrc)(__VA_ARGS__))
+#define cmd_calibrate()		FT_PROF_SITE((cmd_calibrate)())
+#define cmd_inflate(...)	FT_PROF_SITE((cmd_inflate)(__VA_ARGS__))
+#define cmd_loadimage(...)	FT_PROF_SITE((cmd_loadimage)(__VA_ARGS__))
+#define cmd_setfont(...)	FT_PROF_SITE((cmd_setfont)(__VA_ARGS__))
+#define cmd_fgcolor(...)	FT_PROF_SITE((cmd_fgcolor)(__VA_ARGS__))
+#define cmd_bgcolor(...)	FT_PROF_SITE((cmd_bgcolor)(__VA_ARGS__))
+#define cmd_gradcolor(...)	FT_PROF_SITE((cmd_gradcolor)(__VA_ARGS__))
+#define cmd_gradient(...)	FT_PROF_SITE((cmd_gradient)(__VA_ARGS__))
+#define cmd_loadidentity()	FT_PROF_SITE((cmd_loadidentity)())
+#define cmd_setmatrix()		FT_PROF_SITE((cmd_setmatrix)())
+#define cmd_rotate(...)		FT_PROF_SITE((cmd_rotate)(__VA_ARGS__))
+#define cmd_translate(...)	FT_PROF_SITE((cmd_translate)(__VA_ARGS__))
+#define cmd_scale(...)		FT_PROF_SITE((cmd_scale)(__VA_ARGS__))
+#define cmd_getmatrix(...)	FT_PROF_SITE((cmd_getmatrix)(__VA_ARGS__))
+#endif
 
 #endif 
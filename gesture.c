@@ -0,0 +1,153 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    gesture.c
+  * @brief   Gesture recognizer
+  *          This file contains a hardware independent state machine that
+  *          filters touch samples and recognizes taps, long presses, drags
+  *          and swipes. It only needs stdint.h, so it builds on a PC too.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "gesture.h"
+
+#define G_IDLE		0
+#define G_PRESSED	1
+#define G_DRAGGING	2
+#define G_LONG		3
+
+static int32_t g_abs(int32_t v)
+{
+	return (v < 0) ? -v : v;
+}
+
+static uint8_t g_release(GESTURE_t *g)
+{
+	uint8_t state = g->state;
+
+	g->state = G_IDLE;
+	g->lost = 0;
+	g->down = 0;
+
+	if(state == G_PRESSED && g->t - g->t0 <= GESTURE_TAP_MS) return GESTURE_TAP;
+	if(state == G_DRAGGING && (g_abs(g->vx) >= GESTURE_SWIPE || g_abs(g->vy) >= GESTURE_SWIPE)) return GESTURE_SWIPE_END;
+	return GESTURE_UP;
+}
+
+static void g_press(GESTURE_t *g, int16_t x, int16_t y, uint32_t ms)
+{
+	g->state = G_PRESSED;
+	g->lost = 0;
+	g->fx = (int32_t)x << 4;
+	g->fy = (int32_t)y << 4;
+	g->x = g->x0 = x;
+	g->y = g->y0 = y;
+	g->dx = g->dy = 0;
+	g->vx = g->vy = 0;
+	g->t0 = g->t = ms;
+}
+
+/* touched sample of a running gesture; while the GESTURE_DOWN of a new touch
+   is still to be reported only the position is updated, the drag and long
+   press checks see the sample with the next call */
+static uint8_t g_move(GESTURE_t *g, int16_t x, int16_t y, uint32_t ms)
+{
+	int16_t px = g->x, py = g->y;
+	uint32_t dt = ms - g->t;
+
+	g->lost = 0;
+	g->fx += (((int32_t)x << 4) - g->fx) >> GESTURE_SMOOTH;
+	g->fy += (((int32_t)y << 4) - g->fy) >> GESTURE_SMOOTH;
+	g->x = (int16_t)((g->fx + 8) >> 4);
+	g->y = (int16_t)((g->fy + 8) >> 4);
+	g->t = ms;
+
+	if(dt)
+	{
+		g->vx = (g->vx + (int32_t)(g->x - px) * 1000 / (int32_t)dt) / 2;
+		g->vy = (g->vy + (int32_t)(g->y - py) * 1000 / (int32_t)dt) / 2;
+	}
+	if(g->down) return GESTURE_NONE;
+
+	if(g->state != G_DRAGGING &&
+	   (g_abs(g->x - g->x0) > GESTURE_SLOP || g_abs(g->y - g->y0) > GESTURE_SLOP))
+	{
+		g->state = G_DRAGGING;
+		px = g->x0;
+		py = g->y0;
+	}
+
+	if(g->state == G_DRAGGING)
+	{
+		g->dx = g->x - px;
+		g->dy = g->y - py;
+		return (g->dx || g->dy) ? GESTURE_DRAG : GESTURE_NONE;
+	}
+
+	if(g->state == G_PRESSED && ms - g->t0 >= GESTURE_LONG_MS)
+	{
+		g->state = G_LONG;
+		return GESTURE_LONG;
+	}
+	return GESTURE_NONE;
+}
+
+void GESTURE_init(GESTURE_t *g)
+{
+	memset(g, 0, sizeof(GESTURE_t));
+}
+
+/*
+    Function: GESTURE_update
+    ARGS:     g:       recognizer state
+              touched: 1 if the screen is touched
+              x, y:    touch position (ignored when not touched)
+              ms:      sample time in milliseconds
+
+    Description: Call for every touch sample (e.g. once per frame). Positions
+                 are smoothed, short dropouts are bridged and the velocity is
+                 averaged over the last samples. Returns one GESTURE_x event.
+                 A touch that arrives GESTURE_RELEASE_MS or more after the
+                 last touched sample is a new one even if the release wasn't
+                 confirmed yet: the old gesture ends with this call, its
+                 GESTURE_DOWN is returned by the next one.
+*/
+uint8_t GESTURE_update(GESTURE_t *g, uint8_t touched, int16_t x, int16_t y, uint32_t ms)
+{
+	uint8_t ev = GESTURE_NONE;
+
+	if(!touched)
+	{
+		if(g->state == G_IDLE) return GESTURE_NONE;
+
+		if(!g->lost) g->lost = 1;
+		else if(ms - g->t >= GESTURE_RELEASE_MS) return g_release(g);
+	}
+	else if(g->state == G_IDLE)
+	{
+		g_press(g, x, y, ms);
+		return GESTURE_DOWN;
+	}
+	else if(g->lost && ms - g->t >= GESTURE_RELEASE_MS)
+	{
+		ev = g_release(g);
+		g_press(g, x, y, ms);
+		g->down = 1;
+		return ev;
+	}
+	else ev = g_move(g, x, y, ms);
+
+	if(g->down)
+	{
+		g->down = 0;
+		return GESTURE_DOWN;
+	}
+	return ev;
+}
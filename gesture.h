@@ -0,0 +1,55 @@
+#ifndef GESTURE_H
+#define GESTURE_H
+
+/* Gesture recognizer
+ * Turns a stream of touch samples (pressed, x, y, time in ms) into tap,
+ * long press, drag and swipe events. It doesn't touch the FT800, so
+ * recorded sample streams can be replayed on a PC (tools/gesture_replay.c).
+ */
+
+#ifndef GESTURE_SLOP
+#define GESTURE_SLOP        8       /* pixels a press may wander and still be a tap */
+#endif
+#ifndef GESTURE_TAP_MS
+#define GESTURE_TAP_MS      300     /* longest tap */
+#endif
+#ifndef GESTURE_LONG_MS
+#define GESTURE_LONG_MS     700     /* long press */
+#endif
+#ifndef GESTURE_RELEASE_MS
+#define GESTURE_RELEASE_MS  40      /* touch dropouts shorter than this are ignored */
+#endif
+#ifndef GESTURE_SWIPE
+#define GESTURE_SWIPE       400     /* release speed (pixels/s) that makes a drag a swipe */
+#endif
+#ifndef GESTURE_SMOOTH
+#define GESTURE_SMOOTH      1       /* position filter: new = old + (sample-old) >> GESTURE_SMOOTH */
+#endif
+
+/* events */
+#define GESTURE_NONE        0
+#define GESTURE_DOWN        1       /* touch started at x0,y0 */
+#define GESTURE_TAP         2       /* short press released in place */
+#define GESTURE_LONG        3       /* press held in place for GESTURE_LONG_MS (once) */
+#define GESTURE_DRAG        4       /* finger moved, dx,dy since the last event */
+#define GESTURE_SWIPE_END   5       /* drag released at speed, see vx,vy */
+#define GESTURE_UP          6       /* any other release */
+
+typedef struct
+{
+	uint8_t  state;				/* idle / pressed / dragging / long press */
+	uint8_t  lost;				/* touch lost, release not confirmed yet */
+	uint8_t  down;				/* GESTURE_DOWN of a new touch still to be reported */
+	int32_t  fx, fy;			/* filtered position, 1/16 pixels */
+	int16_t  x, y;				/* filtered position */
+	int16_t  x0, y0;			/* where the touch started */
+	int16_t  dx, dy;			/* movement reported with GESTURE_DRAG */
+	int32_t  vx, vy;			/* velocity in pixels/s */
+	uint32_t t0;				/* time of GESTURE_DOWN */
+	uint32_t t;					/* time of the last touched sample */
+} GESTURE_t;
+
+void GESTURE_init(GESTURE_t *g);														/* reset to idle */
+uint8_t GESTURE_update(GESTURE_t *g, uint8_t touched, int16_t x, int16_t y, uint32_t ms);	/* feed one sample, returns an event */
+
+#endif
@@ -0,0 +1,176 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    link.c
+  * @brief   SPI link training
+  *          This file contains the SPI clock selection. Every available
+  *          rate is verified with a RAM_G test pattern, checked both by a
+  *          host readback and by CMD_MEMCRC, and with a REG_ID readback.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include "stm32f4xx.h"
+#include "spi.h"
+#include "ft800.h"
+#include "link.h"
+
+/* fastest first, the last one is the SPI_init() rate */
+static const uint16_t rates[] =
+{
+	SPI_BaudRatePrescaler_2,
+	SPI_BaudRatePrescaler_4,
+	SPI_BaudRatePrescaler_8,
+	SPI_BaudRatePrescaler_16,
+	SPI_BaudRatePrescaler_32,
+};
+#define LINK_RATES	(sizeof(rates)/sizeof(rates[0]))
+
+static uint8_t pattern[LINK_SIZE];
+static uint8_t saved[LINK_SIZE];
+static uint8_t rate = LINK_RATES-1;
+static uint32_t errors;
+
+/*** Helpers ***********************************************************************/
+uint32_t LINK_crc(const uint8_t *data, uint32_t len)
+{
+	uint32_t crc = 0xFFFFFFFFUL;
+	uint8_t k;
+
+	while(len--)
+	{
+		crc ^= *data++;
+		for(k=0; k<8; ++k)
+		{
+			crc = (crc >> 1) ^ (0xEDB88320UL & -(crc & 1));
+		}
+	}
+	return ~crc;
+}
+
+/* solid bytes, alternating bits, walking ones and pseudo random data */
+static void link_pattern(void)
+{
+	uint32_t lfsr = 0xACE1UL;
+	uint32_t i;
+
+	for(i=0; i<LINK_SIZE; ++i)
+	{
+		switch((i >> 5) & 3)
+		{
+			case 0:  pattern[i] = (i & 1) ? 0xFF : 0x00; break;
+			case 1:  pattern[i] = (i & 1) ? 0xAA : 0x55; break;
+			case 2:  pattern[i] = 1 << (i & 7);          break;
+			default:
+				lfsr = (lfsr >> 1) ^ (0xB400UL & -(lfsr & 1));
+				pattern[i] = (uint8_t)lfsr;
+				break;
+		}
+	}
+}
+
+static uint8_t link_test(void)
+{
+	static uint8_t buf[LINK_SIZE];
+	uint32_t crc = LINK_crc(pattern, LINK_SIZE);
+
+	if(HOST_MEM_RD8(REG_ID) != 0x7C) return 0;
+
+	HOST_MEM_WR_STR(LINK_ADDR, pattern, LINK_SIZE);
+	HOST_MEM_READ_STR(LINK_ADDR, buf, LINK_SIZE);
+	if(LINK_crc(buf, LINK_SIZE) != crc) return 0;			// MISO (and MOSI)
+
+	return (cmd_memcrc(LINK_ADDR, LINK_SIZE) == crc) ? 1 : 0;	// MOSI, 0 on a timeout
+}
+
+/* back to the slowest rate, restart the co-processor with an empty FIFO;
+   cmd_resync also drops the last frame of the deduplication, the restarted
+   co-processor shows nothing, so the next frame is sent even if unchanged */
+static void link_recover(void)
+{
+	rate = LINK_RATES-1;
+	SPI_setprescaler(rates[rate]);
+
+	HOST_MEM_WR8(REG_CPURESET, 1);
+	HOST_MEM_WR16(REG_CMD_READ, 0);
+	HOST_MEM_WR16(REG_CMD_WRITE, 0);
+	HOST_MEM_WR8(REG_CPURESET, 0);
+	cmd_resync();
+}
+
+/*** Training **********************************************************************/
+/*
+    Function: LINK_train
+    ARGS:     none
+
+    Description: Call after initFT800() instead of SPI_speedup(). Starting at
+                 the slowest rate, every faster rate is tested until one
+                 fails or exceeds LINK_MAX_HZ. If a rate failed, the clock is
+                 set LINK_MARGIN rates below the fastest passing rate,
+                 otherwise the fastest rate within LINK_MAX_HZ is used. The
+                 test area is restored afterwards.
+                 Returns 0 if the link doesn't work even at the slowest rate.
+*/
+uint8_t LINK_train(void)
+{
+	int8_t i, best = -1;
+	uint8_t failed = 0;
+
+	rate = LINK_RATES-1;
+	SPI_setprescaler(rates[rate]);
+	link_pattern();
+	HOST_MEM_READ_STR(LINK_ADDR, saved, LINK_SIZE);
+
+	for(i=LINK_RATES-1; i>=0; --i)
+	{
+		if(SPI_bus_hz(FT_BUS, rates[i]) > LINK_MAX_HZ) break;	// out of spec, passing or not
+		SPI_setprescaler(rates[i]);
+		if(!link_test())
+		{
+			link_recover();
+			failed = 1;
+			break;
+		}
+		best = i;
+	}
+	if(best < 0) return 0;
+
+	if(failed) best += LINK_MARGIN;						// the limit of this board, stay clear of it
+	if(best > (int8_t)(LINK_RATES-1)) best = LINK_RATES-1;
+	rate = best;
+	SPI_setprescaler(rates[rate]);
+
+	HOST_MEM_WR_STR(LINK_ADDR, saved, LINK_SIZE);
+	return 1;
+}
+
+/*
+    Function: LINK_check
+    ARGS:     none
+
+    Description: Cheap periodic check (one REG_ID read). On a mismatch the
+                 co-processor is restarted and the link is trained again;
+                 the application has to redraw its screen afterwards.
+                 Returns 1 if the link is up.
+*/
+uint8_t LINK_check(void)
+{
+	if(HOST_MEM_RD8(REG_ID) == 0x7C) return 1;
+
+	++errors;
+	link_recover();
+	return LINK_train();
+}
+
+uint16_t LINK_prescaler(void)
+{
+	return rates[rate];
+}
+
+uint32_t LINK_errors(void)
+{
+	return errors;
+}
@@ -0,0 +1,31 @@
+#ifndef LINK_H
+#define LINK_H
+
+/* SPI link training
+ * Steps the SPI clock from the slowest to the fastest prescaler, checking
+ * every rate with a test pattern (host readback and CMD_MEMCRC) and REG_ID,
+ * then settles LINK_MARGIN rates below the fastest one that passed if a
+ * faster one failed, or at the fastest one otherwise. Rates above
+ * LINK_MAX_HZ are never used, even if the link test would pass.
+ */
+
+#ifndef LINK_ADDR
+#define LINK_ADDR           RAM_G   /* test area, its contents are saved and restored */
+#endif
+#ifndef LINK_SIZE
+#define LINK_SIZE           256     /* test pattern bytes */
+#endif
+#ifndef LINK_MARGIN
+#define LINK_MARGIN         1       /* rates to step back from the fastest passing one after a failure */
+#endif
+#ifndef LINK_MAX_HZ
+#define LINK_MAX_HZ         30000000UL  /* FT800 SPI clock limit, faster rates are not tried */
+#endif
+
+uint8_t LINK_train(void);				/* select the fastest reliable SPI clock, returns 0 if even the slowest fails */
+uint8_t LINK_check(void);				/* verify REG_ID, recover and retrain after an error, returns 0 if the link is down */
+uint16_t LINK_prescaler(void);			/* selected SPI_BaudRatePrescaler_x */
+uint32_t LINK_errors(void);				/* communication errors seen by LINK_check */
+uint32_t LINK_crc(const uint8_t *data, uint32_t len);	/* CRC-32 as computed by CMD_MEMCRC */
+
+#endif
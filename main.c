@@ -1,6 +1,7 @@
 #include "stm32f4xx.h"
 #include "spi.h"
 #include "ft800.h"
+#include "link.h"
 
 /* Delaying function */
 void sysDms(uint32_t millisec)
@@ -12,10 +13,28 @@ void sysDms(uint32_t millisec)
 uint8_t initFT800(void)
 {   
 	uint8_t dev_id = 0;                  // Variable for holding the read device id    
-	GPIO_ResetBits(GPIOE, GPIO_Pin_8);   // Set the PDN pin low 
+
+	/* Warm start: the FT800 kept power during an MCU reset, so its registers
+	   and RAM_G (assets, see asset.c) are still valid. The display has to be
+	   running with the configuration below, otherwise it is a cold start. */
+	if(HOST_MEM_RD8(REG_ID) == 0x7C &&
+	   HOST_MEM_RD16(REG_HSIZE) == 480 && HOST_MEM_RD16(REG_VSIZE) == 272 && HOST_MEM_RD8(REG_PCLK) == 0x05)
+	{
+		if(HOST_MEM_RD16(REG_CMD_READ) == 0xFFF)	// co-processor fault: restart it with an empty FIFO, RAM_G is kept
+		{
+			HOST_MEM_WR8(REG_CPURESET, 1);
+			HOST_MEM_WR16(REG_CMD_READ, 0);
+			HOST_MEM_WR16(REG_CMD_WRITE, 0);
+			HOST_MEM_WR8(REG_CPURESET, 0);
+		}
+		cmd_resync();
+		return 0;
+	}
+
+	FT_pdn_low();                        // Set the PDN pin low 
 
 	sysDms(50);                          // Delay 50 ms for stability
-	GPIO_SetBits(GPIOE, GPIO_Pin_8); 	 // Set the PDN pin high
+	FT_pdn_high();                       // Set the PDN pin high
 	sysDms(50);                          // Delay 50 ms for stability
 
 	//WAKE
@@ -73,6 +92,7 @@ uint8_t initFT800(void)
 
 	HOST_MEM_WR8(REG_PCLK, 0x05);                     // After this display is visible on the LCD
 
+	cmd_resync();                                     // The co-processor starts with an empty FIFO
 	return 0;
 }
 
@@ -115,13 +135,28 @@ void lcd_start_screen(uint8_t button)
 	cmd(CMD_SWAP);	
 }
 
+/* Train the link, power-cycling the FT800 through PDN while even the slowest
+   rate fails: the warm start of initFT800() would keep a hung chip as it is */
+static void link_up(void)
+{
+	while(!LINK_train())
+	{
+		FT_pdn_low();
+		sysDms(50);
+		FT_pdn_high();
+		sysDms(50);
+		while(initFT800());
+	}
+}
+
 /*** Main **************************************************************************/
 int main(void)
 {
 	SPI_init();
 	while(initFT800());
 	sysDms(500);
-	SPI_speedup();
+	link_up();                            // Fastest SPI clock that passes the link test
+	cmd_dedup(1);                         // Don't resend unchanged frames
 
 	clrscr();
 
@@ -129,6 +164,10 @@ int main(void)
 
 	while(1)
 	{
+		if(!LINK_check())                 // Retrain after communication errors
+		{
+			link_up();                    // Link down: restart the FT800, train again
+		}
 
 		uint32_t tag = HOST_MEM_RD32(REG_TOUCH_TAG);
 		
@@ -0,0 +1,216 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    matrix.c
+  * @brief   Bitmap transform matrix
+  *          This file contains a 16.16 fixed-point affine matrix library.
+  *          Rotation, scaling and translation are composed on the MCU and
+  *          the final BITMAP_TRANSFORM_A..F words are written directly.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include "stm32f4xx.h"
+#include "ft800.h"
+#include "matrix.h"
+
+/* sin() of the first quarter turn in 16.16, 128 steps */
+static const int32_t sin_table[129] =
+{
+	     0,    804,   1608,   2412,   3216,   4019,   4821,   5623,
+	  6424,   7224,   8022,   8820,   9616,  10411,  11204,  11996,
+	 12785,  13573,  14359,  15143,  15924,  16703,  17479,  18253,
+	 19024,  19792,  20557,  21320,  22078,  22834,  23586,  24335,
+	 25080,  25821,  26558,  27291,  28020,  28745,  29466,  30182,
+	 30893,  31600,  32303,  33000,  33692,  34380,  35062,  35738,
+	 36410,  37076,  37736,  38391,  39040,  39683,  40320,  40951,
+	 41576,  42194,  42806,  43412,  44011,  44604,  45190,  45769,
+	 46341,  46906,  47464,  48015,  48559,  49095,  49624,  50146,
+	 50660,  51166,  51665,  52156,  52639,  53114,  53581,  54040,
+	 54491,  54934,  55368,  55794,  56212,  56621,  57022,  57414,
+	 57798,  58172,  58538,  58896,  59244,  59583,  59914,  60235,
+	 60547,  60851,  61145,  61429,  61705,  61971,  62228,  62476,
+	 62714,  62943,  63162,  63372,  63572,  63763,  63944,  64115,
+	 64277,  64429,  64571,  64704,  64827,  64940,  65043,  65137,
+	 65220,  65294,  65358,  65413,  65457,  65492,  65516,  65531,
+	 65536,
+};
+
+/*** Helpers ***********************************************************************/
+static inline int32_t fx_mul(int32_t x, int32_t y)
+{
+	return (int32_t)(((int64_t)x * y) >> 16);
+}
+
+static inline int32_t fx_div(int32_t x, int32_t y)
+{
+	return (int32_t)(((int64_t)x << 16) / y);
+}
+
+/* sine of 0..16384 (a quarter turn), linear interpolation between table entries */
+static int32_t sin_quarter(uint32_t a)
+{
+	uint32_t i = a >> 7;
+	int32_t frac = a & 127;
+
+	if(i >= 128) return sin_table[128];
+	return sin_table[i] + (((sin_table[i+1] - sin_table[i]) * frac) >> 7);
+}
+
+/* 8.8 transform coefficient, clamped to the 17 bit field. Truncated like
+   CMD_SETMATRIX does, so the words are the ones the co-processor would write */
+static inline int32_t fx_coef(int32_t v)
+{
+	v >>= 8;
+	if(v >  65535) v =  65535;
+	if(v < -65536) v = -65536;
+	return v;
+}
+
+/*** Trigonometry ******************************************************************/
+int32_t MATRIX_sin(int32_t angle)
+{
+	uint32_t a = (uint32_t)angle & 0xFFFF;
+	uint32_t q = a & 0x3FFF;
+
+	switch(a >> 14)
+	{
+		case 0:  return  sin_quarter(q);
+		case 1:  return  sin_quarter(16384 - q);
+		case 2:  return -sin_quarter(q);
+		default: return -sin_quarter(16384 - q);
+	}
+}
+
+int32_t MATRIX_cos(int32_t angle)
+{
+	return MATRIX_sin(angle + 16384);
+}
+
+/*** Composition *******************************************************************/
+/*
+    The matrix maps screen pixels to bitmap pixels, so it is the inverse of the
+    transform that is applied to the bitmap. Every operation pre-multiplies
+    with the inverse of its own transform, which is what the co-processor does
+    for CMD_TRANSLATE, CMD_SCALE and CMD_ROTATE.
+*/
+void MATRIX_identity(MATRIX_t *m)
+{
+	m->a = MATRIX_ONE; m->b = 0;          m->c = 0;
+	m->d = 0;          m->e = MATRIX_ONE; m->f = 0;
+}
+
+void MATRIX_translate(MATRIX_t *m, int32_t tx, int32_t ty)
+{
+	m->c -= tx;
+	m->f -= ty;
+}
+
+void MATRIX_scale(MATRIX_t *m, int32_t sx, int32_t sy)
+{
+	if(!sx || !sy) return;
+
+	m->a = fx_div(m->a, sx);
+	m->b = fx_div(m->b, sx);
+	m->c = fx_div(m->c, sx);
+	m->d = fx_div(m->d, sy);
+	m->e = fx_div(m->e, sy);
+	m->f = fx_div(m->f, sy);
+}
+
+void MATRIX_rotate(MATRIX_t *m, int32_t angle)
+{
+	int32_t s = MATRIX_sin(angle);
+	int32_t c = MATRIX_cos(angle);
+	MATRIX_t r = *m;
+
+	m->a = fx_mul(c, r.a) + fx_mul(s, r.d);
+	m->b = fx_mul(c, r.b) + fx_mul(s, r.e);
+	m->c = fx_mul(c, r.c) + fx_mul(s, r.f);
+	m->d = fx_mul(c, r.d) - fx_mul(s, r.a);
+	m->e = fx_mul(c, r.e) - fx_mul(s, r.b);
+	m->f = fx_mul(c, r.f) - fx_mul(s, r.c);
+}
+
+void MATRIX_rotate_around(MATRIX_t *m, int32_t angle, int32_t cx, int32_t cy)
+{
+	MATRIX_translate(m, cx, cy);
+	MATRIX_rotate(m, angle);
+	MATRIX_translate(m, -cx, -cy);
+}
+
+/*** Output ************************************************************************/
+uint8_t MATRIX_emit(uint32_t *dl, const MATRIX_t *m)
+{
+	dl[0] = BITMAP_TRANSFORM_A(fx_coef(m->a));
+	dl[1] = BITMAP_TRANSFORM_B(fx_coef(m->b));
+	dl[2] = BITMAP_TRANSFORM_C(m->c >> 8);
+	dl[3] = BITMAP_TRANSFORM_D(fx_coef(m->d));
+	dl[4] = BITMAP_TRANSFORM_E(fx_coef(m->e));
+	dl[5] = BITMAP_TRANSFORM_F(m->f >> 8);
+	return 6;
+}
+
+/*
+    Function: MATRIX_set
+    ARGS:     m: matrix
+
+    Description: Writes the matrix into the display list with one cmd_burst,
+                 replacing the CMD_LOADIDENTITY, transform and CMD_SETMATRIX
+                 commands. Returns 0 on FIFO timeout.
+*/
+uint8_t MATRIX_set(const MATRIX_t *m)
+{
+	uint32_t dl[6];
+
+	MATRIX_emit(dl, m);
+	return cmd_burst(dl, 6);
+}
+
+/*
+    Function: MATRIX_sprites
+    ARGS:     m:  n matrices
+              xy: n x,y screen positions
+              n:  number of sprites
+
+    Description: Draws n bitmaps of the current bitmap handle, each with its
+                 own transform. Transform words equal to the previous sprite's
+                 are left out, and the words are sent in cmd_burst batches of
+                 MATRIX_BATCH sprites. Call between BEGIN(BITMAPS) and END();
+                 the last transform stays in effect afterwards.
+                 Returns 0 on FIFO timeout.
+*/
+uint8_t MATRIX_sprites(const MATRIX_t *m, const int16_t *xy, uint32_t n)
+{
+	uint32_t buf[MATRIX_BATCH*7];
+	uint32_t last[6];
+	uint32_t i, k, count = 0;
+	uint8_t valid = 0;
+
+	for(i=0; i<n; ++i)
+	{
+		uint32_t words[6];
+
+		MATRIX_emit(words, &m[i]);
+		for(k=0; k<6; ++k)
+		{
+			if(!valid || words[k] != last[k])
+			{
+				buf[count++] = words[k];
+				last[k] = words[k];
+			}
+		}
+		valid = 1;
+		buf[count++] = VERTEX2F(xy[2*i]*16, xy[2*i+1]*16);
+
+		if(count > (MATRIX_BATCH-1)*7)
+		{
+			if(!cmd_burst(buf, count)) return 0;
+			count = 0;
+		}
+	}
+	return count ? cmd_burst(buf, count) : 1;
+}
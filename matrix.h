@@ -0,0 +1,33 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+/* Host side bitmap transform
+ * A MATRIX_t holds the BITMAP_TRANSFORM_A..F matrix (screen -> bitmap
+ * coordinates) in 16.16 fixed point. The operations compose like the
+ * co-processor matrix commands, but the result is written straight into
+ * the display list, without CMD_LOADIDENTITY/.../CMD_SETMATRIX.
+ */
+
+#define MATRIX_ONE          65536L          /* 1.0 in 16.16 */
+#define MATRIX_BATCH        16              /* sprites per cmd_burst in MATRIX_sprites */
+
+typedef struct
+{
+	int32_t a, b, c;			/* bitmap x = a*x + b*y + c */
+	int32_t d, e, f;			/* bitmap y = d*x + e*y + f */
+} MATRIX_t;
+
+int32_t MATRIX_sin(int32_t angle);										/* sine in 16.16, angle in 1/65536 turns */
+int32_t MATRIX_cos(int32_t angle);										/* cosine in 16.16, angle in 1/65536 turns */
+
+void MATRIX_identity(MATRIX_t *m);										/* same as cmd_loadidentity */
+void MATRIX_translate(MATRIX_t *m, int32_t tx, int32_t ty);				/* same as cmd_translate (16.16 pixels) */
+void MATRIX_scale(MATRIX_t *m, int32_t sx, int32_t sy);					/* same as cmd_scale (16.16 factors) */
+void MATRIX_rotate(MATRIX_t *m, int32_t angle);							/* same as cmd_rotate (clockwise, 1/65536 turns) */
+void MATRIX_rotate_around(MATRIX_t *m, int32_t angle, int32_t cx, int32_t cy);	/* rotate around a point (16.16 pixels) */
+
+uint8_t MATRIX_emit(uint32_t *dl, const MATRIX_t *m);					/* build the 6 BITMAP_TRANSFORM words, returns 6 */
+uint8_t MATRIX_set(const MATRIX_t *m);									/* same as cmd_setmatrix */
+uint8_t MATRIX_sprites(const MATRIX_t *m, const int16_t *xy, uint32_t n);	/* draw n transformed bitmaps at x,y pairs */
+
+#endif
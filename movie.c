@@ -0,0 +1,176 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    movie.c
+  * @brief   MJPEG playback
+  *          This file contains a JPEG sequence player. Frames are decoded
+  *          with CMD_LOADIMAGE into ping-pong RAM_G buffers and swapped on
+  *          REG_FRAMES boundaries, never into the buffer on screen.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include "stm32f4xx.h"
+#include "ft800.h"
+#include "movie.h"
+
+/* push JPEG data into the FIFO as far as it fits, returns 1 when all of it is in */
+static uint8_t movie_feed(MOVIE_t *m)
+{
+	uint32_t n;
+
+	if(m->left)
+	{
+		n = cmd_stream_some(m->data, m->left);
+		m->data += n;
+		m->left -= n;
+	}
+	return m->left ? 0 : 1;
+}
+
+/* start decoding a source frame into the back buffer (not on screen, not drawn) */
+static uint8_t movie_load(MOVIE_t *m, uint32_t frame)
+{
+	const uint8_t *data;
+	uint32_t len;
+
+	m->state = MOVIE_IDLE;
+	if(!m->source(m->ctx, frame, &data, &len))
+	{
+		if(!m->loop || frame == 0) return 0;
+
+		frame = 0;
+		if(!m->source(m->ctx, frame, &data, &len)) return 0;
+	}
+
+	cmd_loadimage(m->buf[m->front ^ 1], m->options | OPT_NODL);
+	m->data = data;
+	m->left = len;
+	movie_feed(m);
+
+	m->next = frame;
+	m->state = MOVIE_DECODING;
+	return 1;
+}
+
+/*
+    Function: MOVIE_start
+    ARGS:     m: player with the configuration fields filled in
+
+    Description: Decodes frame 0 (blocking), then starts decoding frame 1 in
+                 the background. Returns 0 if the sequence is empty.
+*/
+uint8_t MOVIE_start(MOVIE_t *m)
+{
+	m->front = 1;
+	m->show = 1;
+	m->shown = 0;
+	m->dropped = 0;
+	if(!m->interval) m->interval = 1;
+
+	if(!movie_load(m, 0)) return 0;
+	while(!movie_feed(m) || !cmd_ready());
+
+	/* nothing shows the buffers yet, frame 0 can be used right away */
+	m->front = 0;
+	m->show = 0;
+	m->shown = 1;
+	m->start = HOST_MEM_RD32(REG_FRAMES);
+	m->due = m->start + m->interval;
+
+	movie_load(m, 1);
+	return 1;
+}
+
+/*
+    Function: MOVIE_service
+    ARGS:     m: player
+
+    Description: Feeds the JPEG data of the frame being decoded. When the
+                 next frame is due and decoded, hands it to MOVIE_draw() and
+                 returns 1: the display list has to be rebuilt. Decoding of
+                 the frame after it starts into the old buffer only once
+                 that display list has been swapped in (REG_DLSWAP done). If
+                 playback fell behind by whole intervals, those source frames
+                 are dropped to stay in sync. Never waits for the co-processor.
+*/
+uint8_t MOVIE_service(MOVIE_t *m)
+{
+	uint32_t now, late;
+
+	if(m->state == MOVIE_SWAPPING)
+	{
+		if(!m->drawn || !cmd_ready() || HOST_MEM_RD8(REG_DLSWAP) != DLSWAP_DONE) return 0;
+
+		m->front = m->show;				// the old buffer is off screen now
+		movie_load(m, m->after);
+		return 0;
+	}
+
+	if(m->state != MOVIE_DECODING) return 0;
+	if(!movie_feed(m)) return 0;
+
+	now = HOST_MEM_RD32(REG_FRAMES);
+	if((int32_t)(now - m->due) < 0) return 0;
+	if(!cmd_ready()) return 0;			// still decoding, this frame will be late
+
+	m->show = m->front ^ 1;
+	m->drawn = 0;
+	m->state = MOVIE_SWAPPING;
+	++m->shown;
+
+	late = (now - m->due) / m->interval;
+	m->dropped += late;
+	m->due += (late + 1) * m->interval;
+	m->after = m->next + 1 + late;
+	return 1;
+}
+
+/*** Draw Movie Frame **************************************************************/
+void MOVIE_draw(MOVIE_t *m, int16_t x, int16_t y)
+{
+	uint8_t mono = (m->options & OPT_MONO) ? 1 : 0;
+
+	cmd(BITMAP_HANDLE(m->handle));
+	cmd(BITMAP_SOURCE(m->buf[m->show]));
+	cmd(BITMAP_LAYOUT(mono ? L8 : RGB565, mono ? m->width : m->width*2, m->height));
+	cmd(BITMAP_SIZE(NEAREST, BORDER, BORDER, m->width, m->height));
+	cmd(BEGIN(BITMAPS));
+	cmd(VERTEX2F(x*16, y*16));
+	cmd(END());
+	m->drawn = 1;
+}
+
+/*** Statistics ********************************************************************/
+uint32_t MOVIE_fps(const MOVIE_t *m)
+{
+	uint32_t elapsed = HOST_MEM_RD32(REG_FRAMES) - m->start;
+
+	if(!elapsed) return 0;
+	return (m->shown * m->refresh * 100UL) / elapsed;
+}
+
+/*
+    Function: MOVIE_busy
+    ARGS:     m: player
+
+    Description: Returns 1 while the JPEG data of a CMD_LOADIMAGE is only
+                 partly in the FIFO. Until it is all in, anything else
+                 written to the FIFO would be decoded as JPEG data: the
+                 application may only add commands (display lists, other
+                 co-processor commands) while this returns 0. A display
+                 list for a frame handed over by MOVIE_service can always
+                 be written right away.
+*/
+uint8_t MOVIE_busy(const MOVIE_t *m)
+{
+	return (m->state == MOVIE_DECODING && m->left) ? 1 : 0;
+}
+
+uint8_t MOVIE_done(const MOVIE_t *m)
+{
+	return (m->shown && m->state == MOVIE_IDLE) ? 1 : 0;
+}
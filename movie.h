@@ -0,0 +1,65 @@
+#ifndef MOVIE_H
+#define MOVIE_H
+
+/* MJPEG playback
+ * JPEG frames are decoded with CMD_LOADIMAGE into two RAM_G buffers: while
+ * one is displayed the co-processor decodes the next frame into the other.
+ * A buffer is only decoded into once the swap to the other one has reached
+ * the screen. JPEG data is fed to the FIFO as space frees up, MOVIE_service
+ * never waits for the co-processor. Playback is paced against REG_FRAMES.
+ *
+ * The FIFO is shared: while MOVIE_busy() returns 1 a JPEG is only partly
+ * streamed and nothing else may be written to the FIFO, or it would be
+ * decoded as image data. Build other display lists and send co-processor
+ * commands only when MOVIE_busy() is 0 (it always is when MOVIE_service
+ * returns 1).
+ */
+
+/* MOVIE_t.state */
+#define MOVIE_IDLE          0           /* nothing to decode (end of the sequence) */
+#define MOVIE_DECODING      1           /* next frame is streamed / decoded into the back buffer */
+#define MOVIE_SWAPPING      2           /* it was handed to MOVIE_draw, waiting until the swap shows it */
+
+/* Frame source: set *data / *len to JPEG frame number 'frame' (memory-mapped),
+   return 0 when the sequence has no such frame. */
+typedef uint8_t (*MOVIE_Source_t)(void *ctx, uint32_t frame, const uint8_t **data, uint32_t *len);
+
+typedef struct
+{
+	/* configuration, set before MOVIE_start() */
+	uint32_t buf[2];			/* RAM_G addresses of the ping-pong buffers (width*height*2 bytes each) */
+	uint16_t width;
+	uint16_t height;
+	uint8_t  handle;			/* bitmap handle used by MOVIE_draw() */
+	uint8_t  interval;			/* display frames per movie frame (e.g. 4 = 15 fps at 60 Hz) */
+	uint8_t  refresh;			/* display refresh rate in Hz, for the statistics */
+	uint8_t  loop;				/* restart at frame 0 at the end */
+	uint32_t options;			/* CMD_LOADIMAGE options (OPT_MONO), OPT_NODL is always added */
+	MOVIE_Source_t source;
+	void *ctx;
+
+	/* state */
+	uint8_t  state;				/* MOVIE_IDLE / MOVIE_DECODING / MOVIE_SWAPPING */
+	uint8_t  front;				/* buffer on screen */
+	uint8_t  show;				/* buffer MOVIE_draw uses (differs from front while swapping) */
+	uint8_t  drawn;				/* MOVIE_draw has been called for show */
+	uint32_t next;				/* source frame being decoded */
+	uint32_t after;				/* source frame to decode once the swap is done */
+	const uint8_t *data;		/* JPEG data not yet in the FIFO */
+	uint32_t left;
+	uint32_t due;				/* REG_FRAMES value when it should be shown */
+	uint32_t start;				/* REG_FRAMES at MOVIE_start() */
+
+	/* statistics */
+	uint32_t shown;				/* frames displayed */
+	uint32_t dropped;			/* frames skipped to keep up */
+} MOVIE_t;
+
+uint8_t MOVIE_start(MOVIE_t *m);					/* show frame 0 and start decoding frame 1 */
+uint8_t MOVIE_service(MOVIE_t *m);					/* call every loop, returns 1 when a new frame should be drawn */
+void MOVIE_draw(MOVIE_t *m, int16_t x, int16_t y);	/* draw the current frame into the display list (then CMD_SWAP) */
+uint32_t MOVIE_fps(const MOVIE_t *m);				/* achieved frame rate * 100 */
+uint8_t MOVIE_busy(const MOVIE_t *m);				/* JPEG data partly in the FIFO, nothing else may be written to it */
+uint8_t MOVIE_done(const MOVIE_t *m);				/* end of the sequence reached */
+
+#endif
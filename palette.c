@@ -0,0 +1,390 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    palette.c
+  * @brief   Palette quantizer
+  *          This file contains a median-cut colour quantizer that turns
+  *          RGB565 images into 8bit PALETTED bitmaps (RAM_PAL + index data).
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "ft800.h"
+#include "palette.h"
+
+#define PAL_LEVELS      (1<<PAL_HIST_BITS)
+#define PAL_MASK        (PAL_LEVELS-1)
+
+/* histogram bin of an RGB565 pixel */
+#define PAL_BIN(p)      ( ((uint32_t)((p)>>(16-PAL_HIST_BITS)) << (2*PAL_HIST_BITS)) | \
+                          ((uint32_t)(((p)>>(11-PAL_HIST_BITS))&PAL_MASK) << PAL_HIST_BITS) | \
+                          ((uint32_t)(((p)>>(5-PAL_HIST_BITS))&PAL_MASK)) )
+
+/* 8bit channels of an RGB565 pixel */
+#define PAL_R8(p)       ( (((p)>>8)&0xF8) | ((p)>>13) )
+#define PAL_G8(p)       ( (((p)>>3)&0xFC) | (((p)>>9)&0x03) )
+#define PAL_B8(p)       ( (((p)<<3)&0xF8) | (((p)>>2)&0x07) )
+#define PAL_ARGB(p)     ( 0xFF000000UL | ((uint32_t)PAL_R8(p)<<16) | ((uint32_t)PAL_G8(p)<<8) | PAL_B8(p) )
+
+typedef struct
+{
+	uint8_t lo[3];			/* lowest occupied level per channel (R,G,B) */
+	uint8_t hi[3];			/* highest occupied level per channel */
+	uint32_t count;			/* pixels inside the box */
+} PAL_Box_t;
+
+static uint32_t hist[PAL_HIST_SIZE];		/* pixel count per bin */
+static uint32_t hsum[PAL_HIST_SIZE][3];		/* sum of the 8bit R,G,B values per bin */
+static uint16_t exact[PAL_COLORS];			/* distinct colours seen, sorted */
+static uint16_t exact_n;					/* PAL_COLORS+1: too many for an exact palette */
+static uint8_t  lut[PAL_HIST_SIZE];			/* bin -> nearest palette index */
+static uint32_t pal[PAL_COLORS];			/* palette of the last PAL_build() */
+static uint16_t pal_colors;
+static PAL_Box_t boxes[PAL_COLORS];
+
+/*** Helpers ***********************************************************************/
+static uint32_t pal_bin(uint8_t r, uint8_t g, uint8_t b)
+{
+	return ((uint32_t)r << (2*PAL_HIST_BITS)) | ((uint32_t)g << PAL_HIST_BITS) | b;
+}
+
+/* position of colour p in exact[] (or where it would be inserted) */
+static uint16_t pal_find(uint16_t p)
+{
+	uint16_t lo = 0, hi = (exact_n > PAL_COLORS) ? PAL_COLORS : exact_n;
+
+	while(lo < hi)
+	{
+		uint16_t mid = (lo + hi) / 2;
+		if(exact[mid] < p) lo = mid + 1; else hi = mid;
+	}
+	return lo;
+}
+
+/* shrink a box to the occupied bins inside it and recount its pixels */
+static void pal_shrink(PAL_Box_t *box)
+{
+	uint8_t lo[3] = { PAL_MASK, PAL_MASK, PAL_MASK };
+	uint8_t hi[3] = { 0, 0, 0 };
+	uint8_t r, g, b;
+	uint32_t count = 0;
+
+	for(r=box->lo[0]; r<=box->hi[0]; ++r)
+	for(g=box->lo[1]; g<=box->hi[1]; ++g)
+	for(b=box->lo[2]; b<=box->hi[2]; ++b)
+	{
+		uint32_t c = hist[pal_bin(r,g,b)];
+		if(!c) continue;
+
+		count += c;
+		if(r < lo[0]) lo[0] = r;
+		if(r > hi[0]) hi[0] = r;
+		if(g < lo[1]) lo[1] = g;
+		if(g > hi[1]) hi[1] = g;
+		if(b < lo[2]) lo[2] = b;
+		if(b > hi[2]) hi[2] = b;
+	}
+
+	memcpy(box->lo, lo, 3);
+	memcpy(box->hi, hi, 3);
+	box->count = count;
+}
+
+/* split a box along its longest axis at the pixel median, returns 0 if it can't be split */
+static uint8_t pal_split(PAL_Box_t *box, PAL_Box_t *upper)
+{
+	uint32_t slice[PAL_LEVELS];
+	uint32_t sum = 0;
+	uint8_t axis = 0, i, cut;
+	uint8_t r, g, b;
+
+	for(i=1; i<3; ++i)
+	{
+		if((box->hi[i]-box->lo[i]) > (box->hi[axis]-box->lo[axis])) { axis = i; }
+	}
+	if(box->hi[axis] == box->lo[axis]) return 0;
+
+	memset(slice, 0, sizeof(slice));
+	for(r=box->lo[0]; r<=box->hi[0]; ++r)
+	for(g=box->lo[1]; g<=box->hi[1]; ++g)
+	for(b=box->lo[2]; b<=box->hi[2]; ++b)
+	{
+		slice[ (axis == 0) ? r : ((axis == 1) ? g : b) ] += hist[pal_bin(r,g,b)];
+	}
+
+	/* last slice of the lower half; the upper half is never empty */
+	for(cut=box->lo[axis]; cut<box->hi[axis]-1; ++cut)
+	{
+		sum += slice[cut];
+		if(sum >= box->count/2) break;
+	}
+
+	*upper = *box;
+	box->hi[axis] = cut;
+	upper->lo[axis] = cut+1;
+	pal_shrink(box);
+	pal_shrink(upper);
+	return 1;
+}
+
+/* median cut into at most PAL_COLORS boxes, palette entry = mean of the pixels of a box */
+static uint16_t pal_cut(void)
+{
+	uint16_t n = 1, i, j;
+	uint32_t bin;
+
+	boxes[0].lo[0] = boxes[0].lo[1] = boxes[0].lo[2] = 0;
+	boxes[0].hi[0] = boxes[0].hi[1] = boxes[0].hi[2] = PAL_MASK;
+	pal_shrink(&boxes[0]);
+	if(!boxes[0].count) return 0;
+
+	/* split the box with the most pixels*extent until the palette is full */
+	while(n < PAL_COLORS)
+	{
+		uint32_t best_score = 0;
+		uint16_t best = 0;
+
+		for(i=0; i<n; ++i)
+		{
+			uint8_t ext = 0;
+			for(j=0; j<3; ++j)
+			{
+				if(boxes[i].hi[j]-boxes[i].lo[j] > ext) { ext = boxes[i].hi[j]-boxes[i].lo[j]; }
+			}
+			if(ext && boxes[i].count*ext > best_score)
+			{
+				best_score = boxes[i].count*ext;
+				best = i;
+			}
+		}
+		if(!best_score) break;
+		if(!pal_split(&boxes[best], &boxes[n])) break;
+		++n;
+	}
+
+	for(i=0; i<n; ++i)
+	{
+		uint32_t sum[3] = { 0, 0, 0 };
+		uint8_t r, g, b;
+
+		for(r=boxes[i].lo[0]; r<=boxes[i].hi[0]; ++r)
+		for(g=boxes[i].lo[1]; g<=boxes[i].hi[1]; ++g)
+		for(b=boxes[i].lo[2]; b<=boxes[i].hi[2]; ++b)
+		{
+			bin = pal_bin(r,g,b);
+			sum[0] += hsum[bin][0];
+			sum[1] += hsum[bin][1];
+			sum[2] += hsum[bin][2];
+		}
+
+		pal[i] = 0xFF000000UL |
+		         (((sum[0] + boxes[i].count/2)/boxes[i].count) << 16) |
+		         (((sum[1] + boxes[i].count/2)/boxes[i].count) << 8) |
+		          ((sum[2] + boxes[i].count/2)/boxes[i].count);
+	}
+	return n;
+}
+
+/*
+    Function: PAL_reset
+    ARGS:     none
+
+    Description: Clears the colour histogram. Call it before collecting the
+                 pixels of the images that will share one palette.
+*/
+void PAL_reset(void)
+{
+	memset(hist, 0, sizeof(hist));
+	memset(hsum, 0, sizeof(hsum));
+	exact_n = 0;
+}
+
+/*
+    Function: PAL_histogram
+    ARGS:     src: RGB565 pixels
+              n:   number of pixels
+
+    Description: Adds n pixels to the colour histogram. Several images can be
+                 added before PAL_build() since the FT800 has only one RAM_PAL.
+                 Up to PAL_COLORS distinct colours are also kept as they are,
+                 so such images get an exact palette.
+*/
+void PAL_histogram(const uint16_t *src, uint32_t n)
+{
+	uint16_t last = 0, i;
+	uint8_t  known = 0;
+
+	while(n--)
+	{
+		uint16_t p = *src++;
+		uint32_t bin = PAL_BIN(p);
+
+		++hist[bin];
+		hsum[bin][0] += PAL_R8(p);
+		hsum[bin][1] += PAL_G8(p);
+		hsum[bin][2] += PAL_B8(p);
+
+		if(exact_n > PAL_COLORS || (known && p == last)) continue;
+		last = p;
+		known = 1;
+		i = pal_find(p);
+		if(i < exact_n && exact[i] == p) continue;
+		if(exact_n == PAL_COLORS) { exact_n = PAL_COLORS+1; continue; }
+		memmove(&exact[i+1], &exact[i], (exact_n-i)*sizeof(uint16_t));
+		exact[i] = p;
+		++exact_n;
+	}
+}
+
+/*
+    Function: PAL_build
+    ARGS:     palette: output buffer for PAL_COLORS ARGB8888 entries
+
+    Description: Median-cuts the histogram into at most PAL_COLORS boxes, writes
+                 the mean colours of their pixels into palette and prepares the
+                 bin->index table used by PAL_map(). With at most PAL_COLORS
+                 distinct colours the palette is these colours instead.
+                 Returns the number of colours used.
+*/
+uint16_t PAL_build(uint32_t *palette)
+{
+	uint16_t n, i;
+	uint32_t bin;
+
+	if(exact_n <= PAL_COLORS)
+	{
+		for(i=0; i<exact_n; ++i) { pal[i] = PAL_ARGB(exact[i]); }
+		n = exact_n;
+	}
+	else
+	{
+		n = pal_cut();
+	}
+	pal_colors = n;
+
+	/* nearest palette colour to the mean of each occupied bin, so pixels map with one lookup */
+	for(bin=0; bin<PAL_HIST_SIZE; ++bin)
+	{
+		int32_t r, g, b;
+		uint32_t best_d = 0xFFFFFFFFUL;
+
+		if(!hist[bin]) continue;
+
+		r = (int32_t)(hsum[bin][0] / hist[bin]);
+		g = (int32_t)(hsum[bin][1] / hist[bin]);
+		b = (int32_t)(hsum[bin][2] / hist[bin]);
+
+		for(i=0; i<n; ++i)
+		{
+			int32_t dr = r - (int32_t)((pal[i]>>16)&0xFF);
+			int32_t dg = g - (int32_t)((pal[i]>>8)&0xFF);
+			int32_t db = b - (int32_t)(pal[i]&0xFF);
+			uint32_t d = (uint32_t)(dr*dr + dg*dg + db*db);
+
+			if(d < best_d)
+			{
+				best_d = d;
+				lut[bin] = (uint8_t)i;
+			}
+		}
+	}
+
+	if(palette) { memcpy(palette, pal, n*sizeof(uint32_t)); }
+	return n;
+}
+
+/*
+    Function: PAL_map
+    ARGS:     src:    RGB565 pixels (must have been added with PAL_histogram)
+              n:      number of pixels
+              index:  output buffer for n palette indices
+              report: quality/size report, can be NULL
+
+    Description: Converts the pixels into indices of the last built palette.
+                 With an exact palette every pixel maps to its own colour.
+*/
+void PAL_map(const uint16_t *src, uint32_t n, uint8_t *index, PAL_Report_t *report)
+{
+	uint64_t err = 0;
+	uint32_t max_err = 0;
+	uint32_t i;
+
+	for(i=0; i<n; ++i)
+	{
+		uint16_t p = src[i];
+		uint8_t idx = lut[PAL_BIN(p)];
+
+		if(exact_n <= PAL_COLORS)
+		{
+			uint16_t k = pal_find(p);
+			if(k < exact_n && exact[k] == p) idx = (uint8_t)k;
+		}
+
+		index[i] = idx;
+
+		if(report)
+		{
+			int32_t dr = PAL_R8(p) - (int32_t)((pal[idx]>>16)&0xFF);
+			int32_t dg = PAL_G8(p) - (int32_t)((pal[idx]>>8)&0xFF);
+			int32_t db = PAL_B8(p) - (int32_t)(pal[idx]&0xFF);
+			uint32_t d = (uint32_t)(dr*dr + dg*dg + db*db);
+
+			err += d;
+			if(d > max_err) max_err = d;
+		}
+	}
+
+	if(report)
+	{
+		report->raw_size = n*2;
+		report->pal_size = n + pal_colors*4;
+		report->colors = pal_colors;
+		report->mse = n ? (uint32_t)(err/n) : 0;
+		report->max_err = max_err;
+	}
+}
+
+/*
+    Function: PAL_quantize
+    ARGS:     src:     RGB565 pixels
+              n:       number of pixels
+              palette: output buffer for PAL_COLORS ARGB8888 entries
+              index:   output buffer for n palette indices
+              report:  quality/size report, can be NULL
+
+    Description: Quantizes a single image with its own palette. Returns the
+                 number of colours used.
+*/
+uint16_t PAL_quantize(const uint16_t *src, uint32_t n, uint32_t *palette, uint8_t *index, PAL_Report_t *report)
+{
+	uint16_t colors;
+
+	PAL_reset();
+	PAL_histogram(src, n);
+	colors = PAL_build(palette);
+	PAL_map(src, n, index, report);
+
+	return colors;
+}
+
+/*** Upload ************************************************************************/
+void PAL_load(uint32_t addr, const uint32_t *palette, uint16_t colors, const uint8_t *index, uint32_t size)
+{
+	HOST_MEM_WR_STR(RAM_PAL, (uint8_t*)palette, (uint32_t)colors*4);
+	HOST_MEM_WR_STR(addr, (uint8_t*)index, size);
+}
+
+/*** Bitmap Handle *****************************************************************/
+void PAL_bitmap(uint8_t handle, uint32_t addr, uint16_t width, uint16_t height)
+{
+	cmd(BITMAP_HANDLE(handle));
+	cmd(BITMAP_SOURCE(addr));
+	cmd(BITMAP_LAYOUT(PALETTED, width, height));
+	cmd(BITMAP_SIZE(NEAREST, BORDER, BORDER, width, height));
+}
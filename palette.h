@@ -0,0 +1,28 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+/* Palette quantizer for PALETTED bitmaps */
+#define PAL_COLORS      256                     /* entries in RAM_PAL */
+#define PAL_HIST_BITS   4                       /* histogram resolution per colour channel */
+#define PAL_HIST_SIZE   (1UL<<(3*PAL_HIST_BITS))
+
+/* Quality/size report of one quantized asset */
+typedef struct
+{
+	uint32_t raw_size;		/* bytes of the image as RGB565 */
+	uint32_t pal_size;		/* bytes of the index data + RAM_PAL palette */
+	uint16_t colors;		/* palette entries in use */
+	uint32_t mse;			/* mean squared error per pixel (R+G+B, 8bit scale) */
+	uint32_t max_err;		/* largest squared error of a single pixel */
+} PAL_Report_t;
+
+void PAL_reset(void);												/* clear the colour histogram */
+void PAL_histogram(const uint16_t *src, uint32_t n);				/* add n RGB565 pixels to the histogram */
+uint16_t PAL_build(uint32_t *palette);								/* median-cut the histogram into an ARGB palette */
+void PAL_map(const uint16_t *src, uint32_t n, uint8_t *index, PAL_Report_t *report);	/* convert RGB565 pixels into palette indices */
+uint16_t PAL_quantize(const uint16_t *src, uint32_t n, uint32_t *palette, uint8_t *index, PAL_Report_t *report);	/* histogram + build + map of one image */
+
+void PAL_load(uint32_t addr, const uint32_t *palette, uint16_t colors, const uint8_t *index, uint32_t size);	/* upload palette and index data */
+void PAL_bitmap(uint8_t handle, uint32_t addr, uint16_t width, uint16_t height);								/* set up a PALETTED bitmap handle */
+
+#endif
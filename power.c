@@ -0,0 +1,276 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    power.c
+  * @brief   Power manager
+  *          This file contains an idle state machine that dims the backlight
+  *          and uses the STANDBY, SLEEP and PWRDOWN host commands, and
+  *          restores the FT800 on wake.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include "spi.h"
+#include "ft800.h"
+#include "power.h"
+
+#include <string.h>
+
+/* Registers lost in PWRDOWN, as address-contiguous blocks without command or
+   status registers. REG_PCLK, REG_GPIO and REG_PWM_DUTY are handled apart. */
+static const struct { uint32_t addr; uint8_t len; } power_blocks[] =
+{
+	{ REG_HCYCLE,            40 },	/* HCYCLE .. VSYNC1 */
+	{ REG_ROTATE,            24 },	/* ROTATE .. PCLK_POL */
+	{ REG_VOL_PB,             8 },	/* VOL_PB, VOL_SOUND */
+	{ REG_GPIO_DIR,           4 },
+	{ REG_INT_EN,             8 },	/* INT_EN, INT_MASK */
+	{ REG_PWM_HZ,             4 },
+	{ REG_TOUCH_MODE,        24 },	/* TOUCH_MODE .. TOUCH_RZTHRESH */
+	{ REG_TOUCH_TRANSFORM_A, 24 },	/* TOUCH_TRANSFORM_A .. F */
+};
+#define POWER_BLOCKS	(sizeof(power_blocks)/sizeof(power_blocks[0]))
+#define POWER_REGS		136
+
+static const POWER_Config_t *cfg;
+static POWER_Stats_t stats;
+static uint8_t  state;
+static uint32_t last;				/* time of the last activity */
+static uint32_t entered;			/* time the current state was entered */
+static uint32_t skipped;			/* cmd_dedup_skipped() at the last POWER_frame */
+static uint32_t wake_t;				/* time of the last wake request */
+static uint8_t  waking;				/* waiting for the first frame after a wake */
+static uint8_t  dark;				/* backlight waits for the first frame */
+static uint8_t  duty, gpio, pclk;	/* values before leaving POWER_ACTIVE */
+static uint16_t prescaler;			/* SPI clock before PWRDOWN */
+static uint8_t  reload;				/* registers restored, RAM_G still to be reloaded */
+static uint8_t  regs[POWER_REGS];
+
+/*** Helpers ***********************************************************************/
+static void power_enter(uint8_t to, uint32_t now)
+{
+	stats.time[state] += now - entered;
+	entered = now;
+	state = to;
+}
+
+static void power_regs(uint8_t dir)
+{
+	HOST_MEM_Op_t ops[POWER_BLOCKS];
+	uint8_t *p = regs;
+	uint8_t i;
+
+	for(i=0; i<POWER_BLOCKS; ++i)
+	{
+		ops[i].addr = power_blocks[i].addr;
+		ops[i].buf = p;
+		ops[i].len = power_blocks[i].len;
+		ops[i].dir = dir;
+		p += power_blocks[i].len;
+	}
+	HOST_MEM_BATCH(ops, POWER_BLOCKS);
+}
+
+static void power_down(uint8_t to, uint32_t now)
+{
+	if(state == POWER_ACTIVE)
+	{
+		duty = HOST_MEM_RD8(REG_PWM_DUTY);
+	}
+
+	if(to == POWER_DIM)
+	{
+		HOST_MEM_WR8(REG_PWM_DUTY, (cfg->dim_duty < duty) ? cfg->dim_duty : duty);
+		power_enter(to, now);
+		return;
+	}
+
+	if(state <= POWER_DIM)
+	{
+		/* last chance to read registers */
+		gpio = HOST_MEM_RD8(REG_GPIO);
+		pclk = HOST_MEM_RD8(REG_PCLK);
+		if(cfg->idle[POWER_OFF]) { power_regs(HOST_MEM_READ); }
+
+		HOST_MEM_WR8(REG_PWM_DUTY, 0);			// the PWM output stops in its current level
+		HOST_MEM_WR8(REG_GPIO, gpio & ~0x80);	// display off
+	}
+	else if(state == POWER_STANDBY && to == POWER_SLEEP)
+	{
+		HOST_CMD_ACTIVE();
+	}
+
+	if(to == POWER_STANDBY)    { HOST_CMD_WRITE(CMD_STANDBY); }
+	else if(to == POWER_SLEEP) { HOST_CMD_WRITE(CMD_SLEEP); }
+	else
+	{
+		prescaler = SPI_getprescaler();
+		HOST_CMD_WRITE(CMD_PWRDOWN);
+	}
+
+	power_enter(to, now);
+}
+
+/*** Power Manager *****************************************************************/
+void POWER_init(const POWER_Config_t *config)
+{
+	cfg = config;
+	memset(&stats, 0, sizeof(stats));
+	state = POWER_ACTIVE;
+	last = entered = cfg->clock();
+	skipped = cmd_dedup_skipped();
+	waking = 0;
+	dark = 0;
+	reload = 0;
+}
+
+/*
+    Function: POWER_update
+    ARGS:     none
+
+    Description: Call from the main loop. Moves to the deepest enabled state
+                 whose idle time has passed since the last POWER_input or
+                 changed frame. Returns the state.
+*/
+uint8_t POWER_update(void)
+{
+	uint32_t now = cfg->clock();
+	uint32_t idle = now - last;
+	uint8_t to = state, s;
+
+	for(s=state+1; s<POWER_STATES; ++s)
+	{
+		if(cfg->idle[s] && idle >= cfg->idle[s]) { to = s; }
+	}
+	if(to != state) { power_down(to, now); }
+
+	return state;
+}
+
+/*
+    Function: POWER_wake
+    ARGS:     none
+
+    Description: Returns to POWER_ACTIVE. From STANDBY and SLEEP only the
+                 display and backlight are switched back on, the FT800 kept
+                 everything else. After PWRDOWN the clock, the saved registers
+                 and the FIFO state are restored and cfg->restore reloads RAM_G;
+                 the backlight then waits for the first frame. Until the clock
+                 commands are sent the FT800 runs without its PLL, so the SPI
+                 clock is lowered to POWER_WAKE_PRESCALER meanwhile. REG_ID is
+                 polled instead of a fixed PLL delay. Returns 0 if the FT800
+                 didn't answer within POWER_WAKE_TIMEOUT or cfg->restore
+                 failed (call again, a failed restore is retried alone).
+*/
+uint8_t POWER_wake(void)
+{
+	uint32_t now = cfg->clock();
+	uint8_t from = state;
+
+	last = now;
+	if(from == POWER_ACTIVE) return 1;
+
+	if(from == POWER_DIM)
+	{
+		HOST_MEM_WR8(REG_PWM_DUTY, duty);
+		power_enter(POWER_ACTIVE, now);
+		return 1;
+	}
+
+	if(!reload)
+	{
+		if(from == POWER_OFF) { SPI_setprescaler(POWER_WAKE_PRESCALER); }
+		HOST_CMD_ACTIVE();
+		if(from == POWER_OFF)
+		{
+			if(cfg->clk_source) { HOST_CMD_WRITE(cfg->clk_source); }
+			if(cfg->clk_speed)  { HOST_CMD_WRITE(cfg->clk_speed); }
+		}
+
+		while(HOST_MEM_RD8(REG_ID) != 0x7C)
+		{
+			if(cfg->clock() - now > POWER_WAKE_TIMEOUT) return 0;
+		}
+	}
+
+	if(from == POWER_OFF)
+	{
+		if(!reload)
+		{
+			SPI_setprescaler(prescaler);			// the PLL runs again
+			power_regs(HOST_MEM_WRITE);
+			HOST_MEM_WR8(REG_PWM_DUTY, 0);			// resets to 128: dark until the first frame
+			HOST_MEM_WR8(REG_PCLK, pclk);			// after the timing registers
+			cmd_resync();
+			cmd_dedup(cmd_dedup_enabled());		// the old frame is gone, don't drop its repeat
+			reload = 1;
+		}
+		if(cfg->restore && !cfg->restore()) return 0;	// stays in POWER_OFF, RAM_G is incomplete
+		reload = 0;
+		dark = 1;
+	}
+	else
+	{
+		HOST_MEM_WR8(REG_PWM_DUTY, duty);
+	}
+	HOST_MEM_WR8(REG_GPIO, gpio);
+
+	++stats.wakes;
+	wake_t = now;
+	waking = 1;
+	power_enter(POWER_ACTIVE, cfg->clock());
+	return 1;
+}
+
+void POWER_input(void)
+{
+	if(state != POWER_ACTIVE) { POWER_wake(); }
+	last = cfg->clock();
+}
+
+/*
+    Function: POWER_frame
+    ARGS:     none
+
+    Description: Call after each CMD_SWAP. With frame deduplication on, frames
+                 that differ from the previous one count as activity (an
+                 animation keeps the display on); without it only POWER_input
+                 does. The first frame after a wake stops the wake timer.
+*/
+void POWER_frame(void)
+{
+	uint32_t now = cfg->clock();
+	uint32_t s = cmd_dedup_skipped();
+
+	if(cmd_dedup_enabled() && s == skipped) { last = now; }
+	skipped = s;
+
+	if(waking)
+	{
+		if(dark) { HOST_MEM_WR8(REG_PWM_DUTY, duty); }
+		dark = 0;
+		waking = 0;
+		stats.wake_last = now - wake_t;
+		if(stats.wake_last > stats.wake_max) { stats.wake_max = stats.wake_last; }
+	}
+}
+
+/*** Status ************************************************************************/
+uint8_t POWER_state(void)
+{
+	return state;
+}
+
+uint8_t POWER_awake(void)
+{
+	return (state <= POWER_DIM) ? 1 : 0;
+}
+
+const POWER_Stats_t* POWER_stats(void)
+{
+	power_enter(state, cfg->clock());
+	return &stats;
+}
@@ -0,0 +1,59 @@
+#ifndef POWER_H
+#define POWER_H
+
+/* Power manager
+ * Dims the backlight and puts the FT800 into STANDBY, SLEEP and finally
+ * PWRDOWN after configurable idle times, and brings it back to the state it
+ * left on wake. Time comes from a clock function, so the state machine can
+ * run against a simulated FT800 on a PC.
+ *
+ * While the FT800 is in STANDBY or deeper its touch engine is stopped:
+ * wake it with POWER_wake() from another source (button, timer, host).
+ * Don't access the FT800 while POWER_awake() returns 0.
+ */
+
+#ifndef POWER_WAKE_TIMEOUT
+#define POWER_WAKE_TIMEOUT  100         /* ms to wait for REG_ID after CMD_ACTIVE */
+#endif
+#ifndef POWER_WAKE_PRESCALER
+#define POWER_WAKE_PRESCALER SPI_BaudRatePrescaler_32  /* SPI clock after PWRDOWN until the clock commands are sent (max. 11 MHz) */
+#endif
+
+/* states, in order of increasing idle time */
+#define POWER_ACTIVE        0
+#define POWER_DIM           1           /* REG_PWM_DUTY lowered */
+#define POWER_STANDBY       2           /* clock gated, PLL running: fastest wake */
+#define POWER_SLEEP         3           /* PLL off: wake waits for the PLL to lock */
+#define POWER_OFF           4           /* PWRDOWN: registers and RAM lost, restored on wake */
+#define POWER_STATES        5
+
+typedef uint32_t (*POWER_Clock_t)(void);	/* millisecond clock */
+
+typedef struct
+{
+	POWER_Clock_t clock;
+	uint32_t idle[POWER_STATES];	/* idle ms before entering each state, 0: state not used ([POWER_ACTIVE] unused) */
+	uint8_t  dim_duty;				/* REG_PWM_DUTY while dimmed */
+	uint8_t  clk_source;			/* CMD_CLKEXT / CMD_CLKINT, resent after PWRDOWN (0: none) */
+	uint8_t  clk_speed;				/* CMD_CLK48M / CMD_CLK36M, resent after PWRDOWN (0: none) */
+	uint8_t  (*restore)(void);		/* reload RAM_G after PWRDOWN (e.g. ASSET_load), 0 on failure */
+} POWER_Config_t;
+
+typedef struct
+{
+	uint32_t wakes;					/* wakes from STANDBY or deeper */
+	uint32_t wake_last;				/* ms from the wake request to the first frame after it */
+	uint32_t wake_max;
+	uint32_t time[POWER_STATES];	/* ms spent in each state */
+} POWER_Stats_t;
+
+void POWER_init(const POWER_Config_t *cfg);		/* start in POWER_ACTIVE */
+uint8_t POWER_update(void);						/* enter lower power states when idle, returns the state */
+void POWER_input(void);							/* report user input: wakes and restarts the idle time */
+void POWER_frame(void);							/* report a frame (after CMD_SWAP); changed frames count as activity */
+uint8_t POWER_wake(void);						/* back to POWER_ACTIVE, 0 if the FT800 doesn't answer */
+uint8_t POWER_state(void);						/* current state */
+uint8_t POWER_awake(void);						/* FT800 accessible (ACTIVE or DIM) */
+const POWER_Stats_t* POWER_stats(void);			/* wake latency and time per state */
+
+#endif
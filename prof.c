@@ -0,0 +1,266 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    prof.c
+  * @brief   Co-processor profiler
+  *          This file contains a sampling profiler that attributes
+  *          co-processor execution time and FIFO stall time to the cmd_x
+  *          call sites that submitted the commands.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include "stm32f4xx.h"
+#include "ft800.h"
+#include "prof.h"
+
+#include <stdio.h>
+#include <string.h>
+
+typedef struct
+{
+	uint8_t  site;
+	uint32_t start;				/* FT_dev->cmd_total before the first word */
+} PROF_Pending_t;
+
+static PROF_Site_t sites[PROF_SITES];
+static uint8_t nsites;
+static uint8_t current;			/* site of the last cmd_x call */
+
+static PROF_Pending_t pending[PROF_PENDING];
+static uint16_t tail, count;
+
+static uint32_t last_clock;		/* REG_CLOCK at the last sample */
+static uint8_t busy;			/* FIFO was not empty at the last sample */
+static uint8_t watch;			/* a cmd_x call was submitted, the FIFO has not been found empty since */
+static uint32_t last_total;		/* FT_dev->cmd_total at the last sample */
+static uint8_t stalled;
+static uint32_t stall_start;
+
+static uint8_t running;
+static uint8_t dedup;			/* cmd_dedup_enabled() before PROF_init */
+
+static PROF_Frame_t frame, last_frame;
+static uint32_t frame_start;
+static uint32_t histogram[PROF_BINS];
+
+/*** Sampling **********************************************************************/
+#define PEND(i)		pending[(tail + (i)) % PROF_PENDING]
+
+/*
+    Function: PROF_sample
+    ARGS:     none
+
+    Description: The ticks since the previous sample are charged to the oldest
+                 call still in the FIFO, if the co-processor was busy. Calls
+                 whose successor has been reached by REG_CMD_READ are retired.
+                 Positions are compared as byte totals (cmd_total), so calls
+                 larger than the FIFO are tracked correctly.
+*/
+uint32_t PROF_sample(void)
+{
+	uint32_t now = HOST_MEM_RD32(REG_CLOCK);
+	uint32_t rd = HOST_MEM_RD32(REG_CMD_READ) & (FT_CMD_FIFO_SIZE-1);
+	uint32_t elapsed = now - last_clock;
+	uint32_t done = FT_dev->cmd_total - ((FT_dev->cmd_wr - rd) & (FT_CMD_FIFO_SIZE-1));
+
+	last_clock = now;
+	if(!running) return rd;
+
+	if(busy && count)
+	{
+		sites[PEND(0).site].busy += elapsed;
+		frame.busy += elapsed;
+	}
+
+	while(count > 1 && (int32_t)(done - PEND(1).start) >= 0)
+	{
+		tail = (tail + 1) % PROF_PENDING;
+		--count;
+	}
+
+	busy = (rd != FT_dev->cmd_wr) ? 1 : 0;
+	if(!busy) { watch = 0; }
+	last_total = FT_dev->cmd_total;
+	return rd;
+}
+
+void PROF_stall(uint8_t full)
+{
+	if(!running) return;
+	if(full && !stalled)
+	{
+		stalled = 1;
+		stall_start = last_clock;
+	}
+	else if(!full && stalled)
+	{
+		stalled = 0;
+		sites[current].stall += last_clock - stall_start;
+		frame.stall += last_clock - stall_start;
+	}
+}
+
+/*
+    Function: PROF_site
+    ARGS:     file: source file of the call, NULL for plain cmd() words
+              line: source line of the call
+
+    Description: Looks up the call site and queues it with the FIFO position its
+                 words will start at. Consecutive calls from the same site
+                 share one queue entry. A cmd_x call takes a sample. Plain
+                 cmd() words take one after a cmd_x call and while the last
+                 sample found the FIFO not empty (the co-processor is the
+                 bottleneck then, the reads don't slow the frame down), and
+                 otherwise once every PROF_INTERVAL FIFO bytes.
+*/
+void PROF_site(const char *file, uint16_t line)
+{
+	uint8_t i;
+
+	if(!running) return;
+	for(i=0; i<nsites; ++i)
+	{
+		if(sites[i].file == file && sites[i].line == line) break;
+	}
+	if(i == nsites)
+	{
+		if(nsites == PROF_SITES) { i = 0; }				// table full: count as plain words
+		else
+		{
+			sites[i].file = file;
+			sites[i].line = line;
+			++nsites;
+		}
+	}
+
+	++sites[i].count;
+	current = i;
+
+	if(file || busy || watch || FT_dev->cmd_total - last_total >= PROF_INTERVAL) { PROF_sample(); }
+	if(file) { watch = 1; }
+	if(count && PEND(count-1).site == i) return;
+
+	if(count == PROF_PENDING)
+	{
+		tail = (tail + 1) % PROF_PENDING;
+		--count;
+	}
+	PEND(count).site = i;
+	PEND(count).start = FT_dev->cmd_total;
+	++count;
+}
+
+/*** Control ***********************************************************************/
+/*
+    Function: PROF_init
+    ARGS:     none
+
+    Description: Clears the statistics and starts profiling. Frame
+                 deduplication is switched off until PROF_stop(): buffered
+                 words have no FIFO position yet.
+*/
+void PROF_init(void)
+{
+	if(!running) { dedup = cmd_dedup_enabled(); }
+	cmd_dedup(0);
+
+	memset(sites, 0, sizeof(sites));
+	memset(histogram, 0, sizeof(histogram));
+	memset(&frame, 0, sizeof(frame));
+	memset(&last_frame, 0, sizeof(last_frame));
+	nsites = 1;					// site 0: plain cmd() words
+	current = 0;
+	tail = 0;
+	count = 0;
+	stalled = 0;
+
+	cmd_wait(PROF_TIMEOUT);
+	busy = 0;
+	watch = 0;
+	last_total = FT_dev->cmd_total;
+	last_clock = HOST_MEM_RD32(REG_CLOCK);
+	frame_start = last_clock;
+	running = 1;
+}
+
+/* stops profiling (the statistics are kept) and restores frame deduplication */
+void PROF_stop(void)
+{
+	if(!running) return;
+	running = 0;
+	cmd_dedup(dedup);
+}
+
+/*
+    Function: PROF_frame
+    ARGS:     none
+
+    Description: Samples until the co-processor has executed everything,
+                 then adds the frame to the histogram. Returns the statistics
+                 of the frame. If the FIFO hasn't drained after PROF_TIMEOUT
+                 samples (co-processor fault, hung command) the frame is
+                 closed anyway with complete = 0; its busy time is a lower
+                 bound and the rest is charged to the next frame.
+*/
+const PROF_Frame_t* PROF_frame(void)
+{
+	uint32_t bin, polls = PROF_TIMEOUT;
+
+	if(!running) return &last_frame;
+	while(polls && PROF_sample() != FT_dev->cmd_wr) { --polls; }
+	frame.complete = polls ? 1 : 0;
+
+	frame.span = last_clock - frame_start;
+	frame_start = last_clock;
+
+	bin = frame.busy / PROF_BIN_TICKS;
+	if(bin >= PROF_BINS) bin = PROF_BINS-1;
+	++histogram[bin];
+
+	last_frame = frame;
+	memset(&frame, 0, sizeof(frame));
+	return &last_frame;
+}
+
+const PROF_Site_t* PROF_sites(uint8_t *n)
+{
+	*n = nsites;
+	return sites;
+}
+
+const uint32_t* PROF_histogram(void)
+{
+	return histogram;
+}
+
+/*
+    Function: PROF_report
+    ARGS:     out: line output function (e.g. UART)
+
+    Description: Prints one CSV line per call site and per histogram bin:
+                 prof,<file>,<line>,<calls>,<busy ticks>,<stall ticks>
+                 hist,<bin start ticks>,<frames>
+*/
+void PROF_report(PROF_Output_t out)
+{
+	char line[96];
+	uint8_t i;
+
+	out("prof,file,line,calls,busy,stall");
+	for(i=0; i<nsites; ++i)
+	{
+		snprintf(line, sizeof(line), "prof,%s,%u,%lu,%lu,%lu", sites[i].file ? sites[i].file : "cmd",
+		         (unsigned)sites[i].line, (unsigned long)sites[i].count,
+		         (unsigned long)sites[i].busy, (unsigned long)sites[i].stall);
+		out(line);
+	}
+	for(i=0; i<PROF_BINS; ++i)
+	{
+		snprintf(line, sizeof(line), "hist,%lu,%lu", (unsigned long)(i*PROF_BIN_TICKS), (unsigned long)histogram[i]);
+		out(line);
+	}
+}
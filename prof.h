@@ -0,0 +1,66 @@
+#ifndef PROF_H
+#define PROF_H
+
+/* Co-processor profiler
+ * Build with FT_PROF defined. ft800.h then wraps the cmd_x functions so
+ * every call records its source file and line together with the FIFO
+ * position of its first word. Sampling REG_CMD_READ against REG_CLOCK tells
+ * which call the co-processor is executing; the time between samples and
+ * the time the host waits for FIFO space are charged to that call site.
+ * Times are in REG_CLOCK ticks (48 MHz system clock). Samples are taken at
+ * every cmd_x call, when the FIFO shadow runs out of space, while PROF_frame()
+ * drains the FIFO and on plain cmd() words: each word after a cmd_x call and
+ * while the co-processor was found busy, otherwise every PROF_INTERVAL bytes.
+ */
+
+#ifndef PROF_SITES
+#define PROF_SITES          32      /* call sites, site 0 collects plain cmd() words */
+#endif
+#ifndef PROF_PENDING
+#define PROF_PENDING        128     /* calls queued in the FIFO */
+#endif
+#ifndef PROF_INTERVAL
+#define PROF_INTERVAL       256     /* FIFO bytes of plain cmd() words between samples while the co-processor is idle */
+#endif
+#ifndef PROF_TIMEOUT
+#define PROF_TIMEOUT        FT_CMD_TIMEOUT  /* samples PROF_frame waits for the FIFO to drain */
+#endif
+#ifndef PROF_BINS
+#define PROF_BINS           16      /* histogram bins, the last one collects everything above */
+#endif
+#ifndef PROF_BIN_TICKS
+#define PROF_BIN_TICKS      48000UL /* histogram bin width (1 ms) */
+#endif
+
+typedef struct
+{
+	const char *file;			/* NULL: plain cmd() words */
+	uint16_t line;
+	uint32_t count;				/* calls */
+	uint32_t busy;				/* co-processor ticks */
+	uint32_t stall;				/* ticks the host waited for FIFO space */
+} PROF_Site_t;
+
+typedef struct
+{
+	uint32_t busy;				/* co-processor ticks */
+	uint32_t stall;				/* host FIFO wait ticks */
+	uint32_t span;				/* ticks from the end of the previous frame until the FIFO drained */
+	uint8_t  complete;			/* 0: the FIFO didn't drain within PROF_TIMEOUT samples */
+} PROF_Frame_t;
+
+typedef void (*PROF_Output_t)(const char *line);
+
+void PROF_init(void);										/* clear statistics and start, switches frame deduplication off */
+void PROF_stop(void);										/* stop, restores frame deduplication */
+const PROF_Frame_t* PROF_frame(void);						/* wait for the FIFO to drain (max. PROF_TIMEOUT samples) and close the frame (call after CMD_SWAP) */
+const PROF_Site_t* PROF_sites(uint8_t *n);					/* per call site statistics */
+const uint32_t* PROF_histogram(void);						/* frames per co-processor busy time bin */
+void PROF_report(PROF_Output_t out);						/* print sites and histogram as CSV lines */
+
+/* hooks used by ft800.h / ft800.c */
+void PROF_site(const char *file, uint16_t line);			/* a cmd_x call is about to write the FIFO */
+uint32_t PROF_sample(void);									/* sample REG_CLOCK and REG_CMD_READ, returns REG_CMD_READ */
+void PROF_stall(uint8_t stalled);							/* the FIFO is full / has space again */
+
+#endif
@@ -0,0 +1,175 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    sched.c
+  * @brief   Bandwidth scheduler
+  *          This file contains a cooperative scheduler that splits bulk
+  *          transfers into chunks and interleaves them with frame traffic
+  *          under a per-frame SPI byte budget.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include "stm32f4xx.h"
+#include "ft800.h"
+#include "sched.h"
+
+#include <string.h>
+
+static SCHED_Job_t jobs[SCHED_JOBS];
+static SCHED_Stats_t stats[SCHED_CLASSES];
+static uint32_t budget;
+static uint32_t seq;
+static uint32_t bus_mark;			/* FT_dev->spi_bytes at the end of the last SCHED_run() */
+static uint32_t stream_mark;		/* FT_dev->stream_bytes at the end of the last SCHED_run() */
+
+/*** Helpers ***********************************************************************/
+static uint8_t sched_queue(uint8_t cls, uint8_t dir, uint32_t addr, uint8_t *buf, uint32_t len, SCHED_Done_t done, void *ctx)
+{
+	uint8_t i;
+
+	if(cls == SCHED_UI || cls >= SCHED_CLASSES || !len) return 0;
+
+	for(i=0; i<SCHED_JOBS; ++i)
+	{
+		SCHED_Job_t *j = &jobs[i];
+
+		if(j->used) continue;
+
+		j->used = 1;
+		j->cls = cls;
+		j->dir = dir;
+		j->seq = seq++;
+		j->addr = addr;
+		j->buf = buf;
+		j->len = len;
+		j->done = done;
+		j->ctx = ctx;
+		return 1;
+	}
+	return 0;
+}
+
+/* highest priority class first, oldest job first within a class */
+static SCHED_Job_t* sched_next(void)
+{
+	SCHED_Job_t *best = 0;
+	uint8_t i;
+
+	for(i=0; i<SCHED_JOBS; ++i)
+	{
+		SCHED_Job_t *j = &jobs[i];
+
+		if(!j->used) continue;
+		if(!best || j->cls < best->cls || (j->cls == best->cls && (int32_t)(j->seq - best->seq) < 0))
+		{
+			best = j;
+		}
+	}
+	return best;
+}
+
+/*** Queue *************************************************************************/
+void SCHED_init(uint32_t bytes)
+{
+	memset(jobs, 0, sizeof(jobs));
+	memset(stats, 0, sizeof(stats));
+	budget = bytes;
+	bus_mark = FT_dev->spi_bytes;
+	stream_mark = FT_dev->stream_bytes;
+}
+
+uint8_t SCHED_write(uint8_t cls, uint32_t addr, const uint8_t *data, uint32_t len, SCHED_Done_t done, void *ctx)
+{
+	return sched_queue(cls, SCHED_WRITE, addr, (uint8_t*)data, len, done, ctx);
+}
+
+uint8_t SCHED_read(uint8_t cls, uint32_t addr, uint8_t *buf, uint32_t len, SCHED_Done_t done, void *ctx)
+{
+	return sched_queue(cls, SCHED_READ, addr, buf, len, done, ctx);
+}
+
+uint8_t SCHED_busy(uint8_t cls)
+{
+	uint8_t i, n = 0;
+
+	for(i=0; i<SCHED_JOBS; ++i)
+	{
+		if(jobs[i].used && jobs[i].cls == cls) ++n;
+	}
+	return n;
+}
+
+const SCHED_Stats_t* SCHED_stats(uint8_t cls)
+{
+	return (cls < SCHED_CLASSES) ? &stats[cls] : 0;
+}
+
+/*
+    Function: SCHED_run
+    ARGS:     none
+
+    Description: Call once per frame, after the frame's CMD_SWAP. The SPI
+                 bytes counted by the host interface since the last call are
+                 charged to SCHED_UI, except cmd_stream data (inflate, JPEG),
+                 which is charged to SCHED_ASSET. The rest of the budget is
+                 spent on queued jobs in SCHED_CHUNK pieces, each charged
+                 with its transaction header. At least one chunk is moved per
+                 frame, so bulk work can't starve. Returns the bytes moved.
+*/
+uint32_t SCHED_run(void)
+{
+	uint32_t stream = FT_dev->stream_bytes - stream_mark;
+	uint32_t ui = FT_dev->spi_bytes - bus_mark - stream;
+	uint32_t used = ui + stream;
+	uint32_t left = (used < budget) ? budget - used : 0;
+	uint32_t moved = 0;
+	uint8_t c;
+
+	for(c=0; c<SCHED_CLASSES; ++c) { stats[c].frame = 0; }
+	stats[SCHED_UI].frame = ui;
+	stats[SCHED_UI].total += ui;
+	stats[SCHED_ASSET].frame = stream;
+	stats[SCHED_ASSET].total += stream;
+
+	if(left < SCHED_CHUNK) { left = SCHED_CHUNK; }
+
+	while(left)
+	{
+		SCHED_Job_t *j = sched_next();
+		uint32_t n, bytes;
+
+		if(!j) break;
+
+		n = j->len;
+		if(n > SCHED_CHUNK) { n = SCHED_CHUNK; }
+		if(n > left) { n = left; }
+
+		bytes = FT_dev->spi_bytes;
+		if(j->dir == SCHED_WRITE) { HOST_MEM_WR_STR(j->addr, j->buf, n); }
+		else                      { HOST_MEM_READ_STR(j->addr, j->buf, n); }
+		bytes = FT_dev->spi_bytes - bytes;
+
+		j->addr += n;
+		j->buf += n;
+		j->len -= n;
+		left = (bytes < left) ? left - bytes : 0;
+		moved += n;
+		stats[j->cls].frame += bytes;
+		stats[j->cls].total += bytes;
+
+		if(!j->len)
+		{
+			j->used = 0;
+			++stats[j->cls].jobs;
+			if(j->done) { j->done(j->ctx); }
+		}
+	}
+
+	bus_mark = FT_dev->spi_bytes;
+	stream_mark = FT_dev->stream_bytes;
+	return moved;
+}
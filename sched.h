@@ -0,0 +1,58 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+/* Bandwidth scheduler
+ * Bulk transfers are queued as jobs and moved in SCHED_CHUNK pieces by
+ * SCHED_run(), once per frame, within what is left of the per-frame SPI
+ * byte budget after the frame's own traffic. Traffic is measured in SPI
+ * bytes on the bus (FT_Device_t.spi_bytes), headers and register polls
+ * included.
+ */
+
+/* priority classes, lower number is served first */
+#define SCHED_UI            0       /* frame traffic: commands, register access (accounted, not queued) */
+#define SCHED_AUDIO         1       /* audio buffer refills */
+#define SCHED_ASSET         2       /* bitmap / font uploads, cmd_stream data (accounted) */
+#define SCHED_READBACK      3       /* snapshot and memory readouts */
+#define SCHED_CLASSES       4
+
+#define SCHED_WRITE         0
+#define SCHED_READ          1
+
+#ifndef SCHED_JOBS
+#define SCHED_JOBS          8       /* queued jobs */
+#endif
+#ifndef SCHED_CHUNK
+#define SCHED_CHUNK         512     /* bytes per SPI transaction */
+#endif
+
+typedef void (*SCHED_Done_t)(void *ctx);
+
+typedef struct
+{
+	uint8_t  used;
+	uint8_t  cls;
+	uint8_t  dir;				/* SCHED_WRITE / SCHED_READ */
+	uint32_t seq;				/* submission order within a class */
+	uint32_t addr;				/* FT800 address of the next chunk */
+	uint8_t *buf;				/* host buffer of the next chunk */
+	uint32_t len;				/* bytes left */
+	SCHED_Done_t done;			/* called when the job finished, can be NULL */
+	void *ctx;
+} SCHED_Job_t;
+
+typedef struct
+{
+	uint32_t frame;				/* SPI bytes in the last SCHED_run() frame */
+	uint32_t total;				/* SPI bytes since SCHED_init() */
+	uint32_t jobs;				/* finished jobs */
+} SCHED_Stats_t;
+
+void SCHED_init(uint32_t budget);										/* clear queue and statistics, set bytes per frame */
+uint8_t SCHED_write(uint8_t cls, uint32_t addr, const uint8_t *data, uint32_t len, SCHED_Done_t done, void *ctx);	/* queue a write into FT800 memory */
+uint8_t SCHED_read(uint8_t cls, uint32_t addr, uint8_t *buf, uint32_t len, SCHED_Done_t done, void *ctx);			/* queue a read from FT800 memory */
+uint32_t SCHED_run(void);												/* move queued data within this frame's budget (call after CMD_SWAP) */
+uint8_t SCHED_busy(uint8_t cls);										/* jobs of a class still queued */
+const SCHED_Stats_t* SCHED_stats(uint8_t cls);							/* per-class bandwidth statistics */
+
+#endif
@@ -0,0 +1,178 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    shadow.c
+  * @brief   RAM_G shadow
+  *          This file contains a host side mirror of a RAM_G region with
+  *          page granular dirty tracking. Small writes are collected in MCU
+  *          memory and flushed once per frame as one burst per run of dirty
+  *          bytes.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include "stm32f4xx.h"
+#include "ft800.h"
+#include "shadow.h"
+
+#include <string.h>
+
+/*** Helpers ***********************************************************************/
+static inline uint8_t shadow_dirty(const SHADOW_t *s, uint32_t page)
+{
+	return (s->dirty[page >> 5] >> (page & 31)) & 1;
+}
+
+/* bytes lo..hi of a page are written */
+static void shadow_mark(SHADOW_t *s, uint32_t page, uint8_t lo, uint8_t hi)
+{
+	if(s->loaded) { lo = 0; hi = SHADOW_PAGE-1; }
+
+	if(!shadow_dirty(s, page))
+	{
+		s->dirty[page >> 5] |= 1UL << (page & 31);
+	}
+	else if(lo > s->hi[page]+1 || hi+1 < s->lo[page])
+	{
+		/* the bytes in between were never written: send what the page has */
+		uint32_t start = page*SHADOW_PAGE + s->lo[page];
+		uint32_t len = s->hi[page] - s->lo[page] + 1;
+
+		HOST_MEM_WR_STR(s->addr + start, &s->mem[start], len);
+		s->sent += len;
+	}
+	else
+	{
+		if(s->lo[page] < lo) lo = s->lo[page];
+		if(s->hi[page] > hi) hi = s->hi[page];
+	}
+	s->lo[page] = lo;
+	s->hi[page] = hi;
+}
+
+/*** Region ************************************************************************/
+/*
+    Function: SHADOW_init
+    ARGS:     s:    region
+              addr: FT800 address
+              mem:  host copy, size bytes
+              size: bytes, at most SHADOW_PAGES*SHADOW_PAGE
+              load: read the current RAM_G contents into mem
+
+    Description: Sets up a region. Returns 0 and leaves s alone if size is
+                 larger than SHADOW_PAGES pages.
+*/
+uint8_t SHADOW_init(SHADOW_t *s, uint32_t addr, uint8_t *mem, uint32_t size, uint8_t load)
+{
+	if(size > SHADOW_PAGES*SHADOW_PAGE) return 0;
+
+	s->addr = addr;
+	s->size = size;
+	s->mem = mem;
+	s->loaded = load;
+	s->sent = 0;
+	memset(s->dirty, 0, sizeof(s->dirty));
+
+	if(load) HOST_MEM_READ_STR(addr, mem, size);
+	return 1;
+}
+
+/*** Writes ************************************************************************/
+/* writes outside the region are ignored */
+void SHADOW_wr8(SHADOW_t *s, uint32_t addr, uint8_t data)
+{
+	uint32_t o = addr - s->addr;
+
+	if(o >= s->size) return;
+	s->mem[o] = data;
+	shadow_mark(s, o / SHADOW_PAGE, o % SHADOW_PAGE, o % SHADOW_PAGE);
+}
+
+void SHADOW_wr16(SHADOW_t *s, uint32_t addr, uint16_t data)
+{
+	uint8_t b[2] = { (uint8_t)data, (uint8_t)(data>>8) };
+	SHADOW_write(s, addr, b, 2);
+}
+
+void SHADOW_wr32(SHADOW_t *s, uint32_t addr, uint32_t data)
+{
+	uint8_t b[4] = { (uint8_t)data, (uint8_t)(data>>8), (uint8_t)(data>>16), (uint8_t)(data>>24) };
+	SHADOW_write(s, addr, b, 4);
+}
+
+void SHADOW_write(SHADOW_t *s, uint32_t addr, const uint8_t *data, uint32_t len)
+{
+	uint32_t o = addr - s->addr;
+
+	if(o >= s->size) return;
+	if(len > s->size - o) len = s->size - o;
+
+	memcpy(&s->mem[o], data, len);
+	SHADOW_touch(s, addr, len);
+}
+
+uint8_t* SHADOW_ptr(SHADOW_t *s, uint32_t addr)
+{
+	uint32_t o = addr - s->addr;
+	return (o < s->size) ? &s->mem[o] : 0;
+}
+
+void SHADOW_touch(SHADOW_t *s, uint32_t addr, uint32_t len)
+{
+	uint32_t o = addr - s->addr;
+	uint32_t end;
+
+	if(o >= s->size || !len) return;
+	end = (len > s->size - o) ? s->size : o + len;
+
+	while(o < end)
+	{
+		uint32_t page_end = (o | (SHADOW_PAGE-1UL)) + 1;
+		uint32_t last = ((end < page_end) ? end : page_end) - 1;
+
+		shadow_mark(s, o / SHADOW_PAGE, o % SHADOW_PAGE, last % SHADOW_PAGE);
+		o = last + 1;
+	}
+}
+
+/*
+    Function: SHADOW_flush
+    ARGS:     s: region
+
+    Description: Writes every run of dirty bytes with a single
+                 HOST_MEM_WR_STR and marks the region clean. A run continues
+                 into the next page if both are written up to the page
+                 boundary (always with load = 1). Call once per frame.
+                 Returns the number of bytes sent since the last flush.
+*/
+uint32_t SHADOW_flush(SHADOW_t *s)
+{
+	uint32_t pages = (s->size + SHADOW_PAGE - 1) / SHADOW_PAGE;
+	uint32_t page = 0, sent = s->sent;
+
+	while(page < pages)
+	{
+		uint32_t first, start, len;
+
+		if(!s->dirty[page >> 5]) { page = (page | 31) + 1; continue; }	// 32 clean pages
+		if(!shadow_dirty(s, page)) { ++page; continue; }
+
+		first = page;
+		while(s->hi[page] == SHADOW_PAGE-1 && page+1 < pages && shadow_dirty(s, page+1) && !s->lo[page+1]) ++page;
+
+		start = first * SHADOW_PAGE + s->lo[first];
+		len = page * SHADOW_PAGE + s->hi[page] + 1 - start;
+		if(len > s->size - start) len = s->size - start;
+		++page;
+
+		HOST_MEM_WR_STR(s->addr + start, &s->mem[start], len);
+		sent += len;
+	}
+
+	memset(s->dirty, 0, sizeof(s->dirty));
+	s->sent = 0;
+	return sent;
+}
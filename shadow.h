@@ -0,0 +1,44 @@
+#ifndef SHADOW_H
+#define SHADOW_H
+
+/* RAM_G shadow
+ * A host copy of a RAM_G region. Writes go to the copy and mark their pages
+ * dirty, SHADOW_flush() sends every run of dirty bytes in one transaction.
+ * A region set up with load = 1 holds the RAM_G contents, so dirty pages are
+ * sent whole and adjacent ones merge. Without load only the written bytes of
+ * a page are sent; a write that would leave a gap inside a page sends the
+ * bytes collected there first.
+ */
+
+#ifndef SHADOW_PAGE
+#define SHADOW_PAGE         64      /* bytes per dirty page, power of two, max. 256 */
+#endif
+#if SHADOW_PAGE > 256
+#error "SHADOW_PAGE: byte offsets in a page are 8 bits"
+#endif
+#ifndef SHADOW_PAGES
+#define SHADOW_PAGES        256     /* pages per region (16 KB with 64 byte pages) */
+#endif
+
+typedef struct
+{
+	uint32_t addr;				/* FT800 address of the region */
+	uint32_t size;				/* bytes */
+	uint8_t *mem;				/* host copy, size bytes */
+	uint8_t  loaded;			/* mem holds the RAM_G contents */
+	uint32_t sent;				/* bytes sent since the last flush (gaps in a page) */
+	uint32_t dirty[(SHADOW_PAGES+31)/32];
+	uint8_t  lo[SHADOW_PAGES];	/* first and last written byte of a dirty page */
+	uint8_t  hi[SHADOW_PAGES];
+} SHADOW_t;
+
+uint8_t SHADOW_init(SHADOW_t *s, uint32_t addr, uint8_t *mem, uint32_t size, uint8_t load);	/* set up a region, optionally reading its current contents; 0 if larger than SHADOW_PAGES pages */
+void SHADOW_wr8(SHADOW_t *s, uint32_t addr, uint8_t data);					/* write 8 bits into the shadow */
+void SHADOW_wr16(SHADOW_t *s, uint32_t addr, uint16_t data);				/* write 16 bits into the shadow */
+void SHADOW_wr32(SHADOW_t *s, uint32_t addr, uint32_t data);				/* write 32 bits into the shadow */
+void SHADOW_write(SHADOW_t *s, uint32_t addr, const uint8_t *data, uint32_t len);	/* write a byte string into the shadow */
+uint8_t* SHADOW_ptr(SHADOW_t *s, uint32_t addr);							/* host pointer for direct access (mark with SHADOW_touch) */
+void SHADOW_touch(SHADOW_t *s, uint32_t addr, uint32_t len);				/* mark a range dirty */
+uint32_t SHADOW_flush(SHADOW_t *s);											/* write dirty runs to RAM_G, returns bytes sent */
+
+#endif
@@ -16,81 +16,74 @@
 #include "main.h"
 #include "spi.h"
 
+const FT_Bus_t FT_default_bus = FT_BUS_DEFAULT;
+
+#ifdef FT_MULTI_DEVICE
+const FT_Bus_t *FT_bus = &FT_default_bus;
+#endif
+
 /*** SPI INIT **********************************************************************/
-void SPI_init(void)
-{	
-    /* FT800 pin configuration
-	 * SCK  = PA5
-	 * MISO = PA6
-	 * MOSI = PB5
-	 * CS   = PA4
-	 * PDN  = PE8
-     */
-    
-    SPI_InitTypeDef SPI_InitTypeDefStruct;
+/*
+    Function: SPI_init_bus
+    ARGS:     bus: SPI peripheral and pins of one FT800
+
+    Description: Enables the clocks, configures the pins (SCK/MISO/MOSI as
+                 alternate function, CS/PDN as outputs idling high) and
+                 starts the SPI at the slow init clock.
+*/
+void SPI_init_bus(const FT_Bus_t *bus)
+{
     GPIO_InitTypeDef GPIO_InitTypeDefStruct;
+
+	bus->spi_clk_cmd(bus->spi_clk, ENABLE);
+    SPI_bus_prescaler(bus, SPI_BaudRatePrescaler_32);
+
+    RCC_AHB1PeriphClockCmd(bus->sck.clk, ENABLE);
+	RCC_AHB1PeriphClockCmd(bus->miso.clk, ENABLE);
+	RCC_AHB1PeriphClockCmd(bus->mosi.clk, ENABLE);
+	RCC_AHB1PeriphClockCmd(bus->cs.clk, ENABLE);
+	RCC_AHB1PeriphClockCmd(bus->pdn.clk, ENABLE);
     
-	RCC_APB2PeriphClockCmd(RCC_APB2Periph_SPI1, ENABLE);
-     
-    SPI_InitTypeDefStruct.SPI_Direction = SPI_Direction_2Lines_FullDuplex;
-    SPI_InitTypeDefStruct.SPI_Mode = SPI_Mode_Master;
-    SPI_InitTypeDefStruct.SPI_DataSize = SPI_DataSize_8b;
-    SPI_InitTypeDefStruct.SPI_CPOL = SPI_CPOL_Low;
-    SPI_InitTypeDefStruct.SPI_CPHA = SPI_CPHA_1Edge;
-    SPI_InitTypeDefStruct.SPI_NSS = SPI_NSS_Soft;
-    SPI_InitTypeDefStruct.SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_32;
-    SPI_InitTypeDefStruct.SPI_FirstBit = SPI_FirstBit_MSB;
-     
-    SPI_Init(SPI1, &SPI_InitTypeDefStruct);
-    
-    RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOA , ENABLE);
-	RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOB , ENABLE);
-	RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOE , ENABLE);
-    
-    //SCK, MISO
-    GPIO_InitTypeDefStruct.GPIO_Pin = GPIO_Pin_5 | GPIO_Pin_6;
+    //SCK
+    GPIO_InitTypeDefStruct.GPIO_Pin = FT_PIN(bus->sck.pin);
     GPIO_InitTypeDefStruct.GPIO_Mode = GPIO_Mode_AF;
     GPIO_InitTypeDefStruct.GPIO_Speed = GPIO_Speed_50MHz;
     GPIO_InitTypeDefStruct.GPIO_OType = GPIO_OType_PP;
 	GPIO_InitTypeDefStruct.GPIO_PuPd = GPIO_PuPd_UP;
-    GPIO_Init(GPIOA, &GPIO_InitTypeDefStruct);
+    GPIO_Init(bus->sck.port, &GPIO_InitTypeDefStruct);
+	
+	//MISO
+    GPIO_InitTypeDefStruct.GPIO_Pin = FT_PIN(bus->miso.pin);
+    GPIO_Init(bus->miso.port, &GPIO_InitTypeDefStruct);
 	
 	//MOSI
-    GPIO_InitTypeDefStruct.GPIO_Pin = GPIO_Pin_5;
-    GPIO_InitTypeDefStruct.GPIO_Mode = GPIO_Mode_AF;
-    GPIO_InitTypeDefStruct.GPIO_Speed = GPIO_Speed_50MHz;
-    GPIO_InitTypeDefStruct.GPIO_OType = GPIO_OType_PP;
-	GPIO_InitTypeDefStruct.GPIO_PuPd = GPIO_PuPd_UP;
-    GPIO_Init(GPIOB, &GPIO_InitTypeDefStruct);
+    GPIO_InitTypeDefStruct.GPIO_Pin = FT_PIN(bus->mosi.pin);
+    GPIO_Init(bus->mosi.port, &GPIO_InitTypeDefStruct);
     
     //CS
-    GPIO_InitTypeDefStruct.GPIO_Pin = GPIO_Pin_4;
+    GPIO_InitTypeDefStruct.GPIO_Pin = FT_PIN(bus->cs.pin);
     GPIO_InitTypeDefStruct.GPIO_Mode = GPIO_Mode_OUT;
     GPIO_InitTypeDefStruct.GPIO_Speed = GPIO_Speed_50MHz;
     GPIO_InitTypeDefStruct.GPIO_PuPd = GPIO_PuPd_UP;
     GPIO_InitTypeDefStruct.GPIO_OType = GPIO_OType_PP;
-    GPIO_Init(GPIOA, &GPIO_InitTypeDefStruct);
+    GPIO_Init(bus->cs.port, &GPIO_InitTypeDefStruct);
     
     //PDN
-    GPIO_InitTypeDefStruct.GPIO_Pin = GPIO_Pin_8;
-    GPIO_InitTypeDefStruct.GPIO_Mode = GPIO_Mode_OUT;
-    GPIO_InitTypeDefStruct.GPIO_Speed = GPIO_Speed_50MHz;
-    GPIO_InitTypeDefStruct.GPIO_PuPd = GPIO_PuPd_UP;
-    GPIO_InitTypeDefStruct.GPIO_OType = GPIO_OType_PP;
-    GPIO_Init(GPIOE, &GPIO_InitTypeDefStruct);
+    GPIO_InitTypeDefStruct.GPIO_Pin = FT_PIN(bus->pdn.pin);
+    GPIO_Init(bus->pdn.port, &GPIO_InitTypeDefStruct);
      
-    GPIO_PinAFConfig(GPIOA, GPIO_PinSource5, GPIO_AF_SPI1);
-    GPIO_PinAFConfig(GPIOA, GPIO_PinSource6, GPIO_AF_SPI1);
-    GPIO_PinAFConfig(GPIOB, GPIO_PinSource5, GPIO_AF_SPI1);
+    GPIO_PinAFConfig(bus->sck.port, bus->sck.pin, bus->spi_af);
+    GPIO_PinAFConfig(bus->miso.port, bus->miso.pin, bus->spi_af);
+    GPIO_PinAFConfig(bus->mosi.port, bus->mosi.pin, bus->spi_af);
     
 	//CS, PDN to pull up
-    GPIO_SetBits(GPIOE, GPIO_Pin_8);
-	GPIO_SetBits(GPIOA, GPIO_Pin_4);
+    GPIO_SetBits(bus->pdn.port, FT_PIN(bus->pdn.pin));
+	GPIO_SetBits(bus->cs.port, FT_PIN(bus->cs.pin));
     
-    SPI_Cmd(SPI1, ENABLE);
+    SPI_Cmd(bus->spi, ENABLE);
 }
 
-void SPI_speedup(void)
+void SPI_bus_prescaler(const FT_Bus_t *bus, uint16_t prescaler)
 {
     SPI_InitTypeDef SPI_InitTypeDefStruct;
      
@@ -100,46 +93,61 @@ void SPI_speedup(void)
     SPI_InitTypeDefStruct.SPI_CPOL = SPI_CPOL_Low;
     SPI_InitTypeDefStruct.SPI_CPHA = SPI_CPHA_1Edge;
     SPI_InitTypeDefStruct.SPI_NSS = SPI_NSS_Soft;
-    SPI_InitTypeDefStruct.SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_4;
-    
+    SPI_InitTypeDefStruct.SPI_BaudRatePrescaler = prescaler;
     SPI_InitTypeDefStruct.SPI_FirstBit = SPI_FirstBit_MSB;
      
-    SPI_Init(SPI1, &SPI_InitTypeDefStruct);
+    SPI_Init(bus->spi, &SPI_InitTypeDefStruct);
 }
 
-/*** SEND **************************************************************************/
-char SPI_send(char data)
-{    
-    while(!SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_TXE)); 
-    SPI_I2S_SendData(SPI1, data);
-    while(!SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE));
-    
-    return SPI_I2S_ReceiveData(SPI1);
+/*
+    Function: SPI_bus_hz
+    ARGS:     bus:       SPI bus
+              prescaler: SPI_BaudRatePrescaler_x
+
+    Description: SCK frequency of the bus at the given prescaler, from the
+                 APB clock the SPI peripheral of the bus runs on.
+*/
+uint32_t SPI_bus_hz(const FT_Bus_t *bus, uint16_t prescaler)
+{
+    RCC_ClocksTypeDef clocks;
+    uint32_t pclk;
+
+    RCC_GetClocksFreq(&clocks);
+    pclk = (bus->spi_clk_cmd == RCC_APB2PeriphClockCmd) ? clocks.PCLK2_Frequency : clocks.PCLK1_Frequency;
+    return pclk / (2UL << (prescaler >> 3));
 }
 
-/*** REC ***************************************************************************/
-char SPI_rec(char address)
-{      
-    while(!SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_TXE)); 
-    SPI_I2S_SendData(SPI1, address);
-    while(!SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE));
-    SPI_I2S_ReceiveData(SPI1);
-     
-    while(!SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_TXE)); 
-    SPI_I2S_SendData(SPI1, 0x00);
-    while(!SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE));
-     
-    return  SPI_I2S_ReceiveData(SPI1);
+/* the functions below act on the bus of the current device (FT_BUS) */
+void SPI_init(void)
+{	
+    /* FT800 pin configuration: see spi.h
+	 * SCK  = PA5
+	 * MISO = PA6
+	 * MOSI = PB5
+	 * CS   = PA4
+	 * PDN  = PE8
+     */
+    SPI_init_bus(FT_BUS);
+}
+
+void SPI_speedup(void)
+{
+    SPI_setprescaler(SPI_BaudRatePrescaler_4);
 }
 
-/*** FT800 SPI select **************************************************************/
-void FT_spi_select(void)
+void SPI_setprescaler(uint16_t prescaler)
 {
-    GPIO_ResetBits(GPIOA, GPIO_Pin_4);
+    SPI_bus_prescaler(FT_BUS, prescaler);
 }
 
-/*** FT800 SPI deselect ************************************************************/
-void FT_spi_deselect(void)
+uint16_t SPI_getprescaler(void)
 {
-    GPIO_SetBits(GPIOA, GPIO_Pin_4);
+    return FT_BUS_SPI(FT_BUS)->CR1 & SPI_BaudRatePrescaler_256;
+}
+
+/*** REC ***************************************************************************/
+char SPI_rec(char address)
+{      
+    SPI_send(address);
+    return SPI_send(0x00);
 }
@@ -1,13 +1,193 @@
 #ifndef SPI_H
 #define SPI_H
 
+#include "stm32f4xx.h"
+
+#ifdef FT_TRACE
+#include "trace.h"
+#endif
+
+#ifdef FT_BENCH
+#include "bench.h"
+#endif
+
+#ifdef FT_SIM
+#include "ftsim.h"
+#endif
+
+/* FT800 bus and pin configuration
+ * Defaults match the STM32F4 Discovery wiring, override them from the compiler
+ * command line (e.g. -DFT_CS_PORT=GPIOB -DFT_CS_PIN=12 -DFT_CS_CLK=RCC_AHB1Periph_GPIOB).
+ * Pins are given as pin numbers (0..15).
+ */
+#ifndef FT_SPI
+#define FT_SPI              SPI1
+#define FT_SPI_CLK          RCC_APB2Periph_SPI1
+#define FT_SPI_CLK_CMD      RCC_APB2PeriphClockCmd
+#define FT_SPI_AF           GPIO_AF_SPI1
+#endif
+
+#ifndef FT_SCK_PORT
+#define FT_SCK_PORT         GPIOA
+#define FT_SCK_CLK          RCC_AHB1Periph_GPIOA
+#define FT_SCK_PIN          5
+#endif
+
+#ifndef FT_MISO_PORT
+#define FT_MISO_PORT        GPIOA
+#define FT_MISO_CLK         RCC_AHB1Periph_GPIOA
+#define FT_MISO_PIN         6
+#endif
+
+#ifndef FT_MOSI_PORT
+#define FT_MOSI_PORT        GPIOB
+#define FT_MOSI_CLK         RCC_AHB1Periph_GPIOB
+#define FT_MOSI_PIN         5
+#endif
+
+#ifndef FT_CS_PORT
+#define FT_CS_PORT          GPIOA
+#define FT_CS_CLK           RCC_AHB1Periph_GPIOA
+#define FT_CS_PIN           4
+#endif
+
+#ifndef FT_PDN_PORT
+#define FT_PDN_PORT         GPIOE
+#define FT_PDN_CLK          RCC_AHB1Periph_GPIOE
+#define FT_PDN_PIN          8
+#endif
+
+#define FT_PIN(n)           ((uint16_t)(1U<<(n)))
+
+/* One pin of an FT800 bus */
+typedef struct
+{
+    GPIO_TypeDef *port;
+    uint8_t       pin;              /* pin number (0..15) */
+    uint32_t      clk;              /* RCC_AHB1Periph_GPIOx */
+} FT_Pin_t;
+
+/* SPI bus and pins of one FT800 */
+typedef struct FT_Bus
+{
+    SPI_TypeDef  *spi;
+    uint32_t      spi_clk;          /* RCC_APBxPeriph_SPIx */
+    void        (*spi_clk_cmd)(uint32_t periph, FunctionalState state);   /* RCC_APBxPeriphClockCmd */
+    uint8_t       spi_af;           /* GPIO_AF_SPIx */
+    FT_Pin_t      sck, miso, mosi, cs, pdn;
+} FT_Bus_t;
+
+/* bus built from the defines above */
+#define FT_BUS_DEFAULT      { FT_SPI, FT_SPI_CLK, FT_SPI_CLK_CMD, FT_SPI_AF,            \
+                              { FT_SCK_PORT,  FT_SCK_PIN,  FT_SCK_CLK  },               \
+                              { FT_MISO_PORT, FT_MISO_PIN, FT_MISO_CLK },               \
+                              { FT_MOSI_PORT, FT_MOSI_PIN, FT_MOSI_CLK },               \
+                              { FT_CS_PORT,   FT_CS_PIN,   FT_CS_CLK   },               \
+                              { FT_PDN_PORT,  FT_PDN_PIN,  FT_PDN_CLK  } }
+
+extern const FT_Bus_t FT_default_bus;
+
+/* With FT_MULTI_DEVICE the bus functions act on the bus they are given. In a
+ * single device build the bus argument is ignored and the compile-time
+ * constants above are used, so CS toggling stays a single BSRR store to a
+ * constant address. */
+#ifdef FT_MULTI_DEVICE
+#define FT_BUS_SPI(bus)         ((bus)->spi)
+#define FT_BUS_CS_PORT(bus)     ((bus)->cs.port)
+#define FT_BUS_CS_MASK(bus)     FT_PIN((bus)->cs.pin)
+#define FT_BUS_PDN_PORT(bus)    ((bus)->pdn.port)
+#define FT_BUS_PDN_MASK(bus)    FT_PIN((bus)->pdn.pin)
+#else
+#define FT_BUS_SPI(bus)         ((void)(bus), FT_SPI)
+#define FT_BUS_CS_PORT(bus)     ((void)(bus), FT_CS_PORT)
+#define FT_BUS_CS_MASK(bus)     FT_PIN(FT_CS_PIN)
+#define FT_BUS_PDN_PORT(bus)    ((void)(bus), FT_PDN_PORT)
+#define FT_BUS_PDN_MASK(bus)    FT_PIN(FT_PDN_PIN)
+#endif
+
+/* Bus of the device selected with FT_device(), used by the functions without
+ * a bus argument (SPI_send, FT_spi_select, SPI_init, ...) */
+#ifdef FT_MULTI_DEVICE
+extern const FT_Bus_t *FT_bus;
+#define FT_BUS              FT_bus
+#else
+#define FT_BUS              (&FT_default_bus)
+#endif
+
 /* FT800 low-level functions */
-void SPI_init(void);			/* SPI1 init for FT800 */
-void SPI_speedup(void);			/* Speed Up SPI1 */
-char SPI_send(char data);		/* Send char to SPI1 */
-char SPI_rec(char address);		/* Receive char from SPI1 */
+void SPI_init_bus(const FT_Bus_t *bus);                         /* clocks, pins and SPI of a bus */
+void SPI_bus_prescaler(const FT_Bus_t *bus, uint16_t prescaler); /* set SPI clock of a bus (SPI_BaudRatePrescaler_x) */
+uint32_t SPI_bus_hz(const FT_Bus_t *bus, uint16_t prescaler);   /* SCK frequency of a bus at a prescaler */
+void SPI_init(void);			/* SPI init of the current bus */
+void SPI_speedup(void);			/* Speed Up SPI of the current bus */
+void SPI_setprescaler(uint16_t prescaler);	/* set SPI clock of the current bus (SPI_BaudRatePrescaler_x) */
+uint16_t SPI_getprescaler(void);			/* SPI clock of the current bus (SPI_BaudRatePrescaler_x) */
+char SPI_rec(char address);		/* Receive char from SPI */
+
+/*** Send **************************************************************************/
+static inline char FT_bus_send(const FT_Bus_t *bus, char data)
+{
+    char rx;
+
+#ifdef FT_SIM
+    rx = (char)FTSIM_xfer(FT_BUS_SPI(bus), (uint8_t)data);
+#else
+    while(!(FT_BUS_SPI(bus)->SR & SPI_I2S_FLAG_TXE));
+    FT_BUS_SPI(bus)->DR = (uint8_t)data;
+    while(!(FT_BUS_SPI(bus)->SR & SPI_I2S_FLAG_RXNE));
+    rx = (char)FT_BUS_SPI(bus)->DR;
+#endif
+
+#ifdef FT_TRACE
+    TRACE_byte(data, rx);
+#endif
+#ifdef FT_BENCH
+    ++BENCH_spi.bytes;
+#endif
+    return rx;
+}
+
+/*** FT800 SPI select / deselect (single BSRR store) *******************************/
+static inline void FT_bus_select(const FT_Bus_t *bus)
+{
+#ifdef FT_TRACE
+    TRACE_begin();
+#endif
+#ifdef FT_BENCH
+    ++BENCH_spi.transactions;
+#endif
+#ifdef FT_SIM
+    FTSIM_select(FT_BUS_SPI(bus));
+#endif
+    FT_BUS_CS_PORT(bus)->BSRRH = FT_BUS_CS_MASK(bus);
+}
+
+static inline void FT_bus_deselect(const FT_Bus_t *bus)
+{
+    FT_BUS_CS_PORT(bus)->BSRRL = FT_BUS_CS_MASK(bus);
+#ifdef FT_SIM
+    FTSIM_deselect(FT_BUS_SPI(bus));
+#endif
+#ifdef FT_TRACE
+    TRACE_end();
+#endif
+}
+
+/*** FT800 power down pin **********************************************************/
+static inline void FT_bus_pdn(const FT_Bus_t *bus, uint8_t level)
+{
+    if(level) FT_BUS_PDN_PORT(bus)->BSRRL = FT_BUS_PDN_MASK(bus);
+    else      FT_BUS_PDN_PORT(bus)->BSRRH = FT_BUS_PDN_MASK(bus);
+#ifdef FT_SIM
+    FTSIM_pdn(FT_BUS_SPI(bus), level);
+#endif
+}
 
-void FT_spi_select(void);		/* Select FT800 */
-void FT_spi_deselect(void);		/* Deselect FT800 */
+/*** Current bus *******************************************************************/
+static inline char SPI_send(char data)      { return FT_bus_send(FT_BUS, data); }
+static inline void FT_spi_select(void)      { FT_bus_select(FT_BUS); }
+static inline void FT_spi_deselect(void)    { FT_bus_deselect(FT_BUS); }
+static inline void FT_pdn_low(void)         { FT_bus_pdn(FT_BUS, 0); }
+static inline void FT_pdn_high(void)        { FT_bus_pdn(FT_BUS, 1); }
 
-#endif
\ No newline at end of file
+#endif
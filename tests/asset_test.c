@@ -0,0 +1,127 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    asset_test.c
+  * @brief   Asset manager test (host)
+  *          Loads assets into the FT800 model: upload, CRC verified cache hit
+  *          after a simulated MCU reset, full manifest, a co-processor
+  *          that stopped answering and the decoded size check of JPEG
+  *          bundle entries.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_SIM -I. -Itests -Itools -o asset_test tests/asset_test.c tests/stm32_mock.c tools/ftsim.c ft800.c asset.c
+  *          Usage: asset_test
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ft800.h"
+#include "asset.h"
+#include "ftsim.h"
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+static FTSIM_t sim;
+static uint8_t data[256];
+
+static ASSET_t asset(uint32_t id, uint32_t addr)
+{
+	ASSET_t a = { id, 1, addr, sizeof(data), data };
+	return a;
+}
+
+/* MCU reset: the library state is gone, the FT800 keeps its memory */
+static void reset(void)
+{
+	FT_device_init(FT_dev, 0);
+	ASSET_begin();
+}
+
+/* bundle with one 64x32 baseline JPEG (headers only, the model fills the image) */
+static const uint8_t jpeg[] =
+{
+	0xFF,0xD8, 0xFF,0xC0, 0x00,0x0B, 0x08, 0x00,0x20, 0x00,0x40, 0x01, 0x01,0x11,0x00, 0xFF,0xD9, 0x00
+};
+
+static void test_bundle(void)
+{
+	static uint32_t bundle[16];
+	uint8_t *b = (uint8_t*)bundle;
+
+	bundle[0] = ASSET_BUNDLE_MAGIC;
+	bundle[1] = 1;
+	bundle[2] = 7;								/* id */
+	bundle[3] = ASSET_JPEG;
+	bundle[4] = 28;								/* offset */
+	bundle[5] = sizeof(jpeg);
+	bundle[6] = 64*32*2;						/* raw_size as written by ftpack */
+	memcpy(b + 28, jpeg, sizeof(jpeg));
+
+	CHECK(ASSET_bundle_load(b, 7, RAM_G + 0x10000, 0));
+	while(!cmd_ready()) { FTSIM_idle(&sim, 200); }
+	CHECK(sim.mem[RAM_G + 0x10000 + 64*32*2 - 1] != 0 && sim.mem[RAM_G + 0x10000 + 64*32*2] == 0 && !sim.fault);
+
+	CHECK(!ASSET_bundle_load(b, 7, ASSET_MANIFEST_ADDR - 64*32, 0));		/* RGB565 doesn't fit */
+	CHECK(ASSET_bundle_load(b, 7, ASSET_MANIFEST_ADDR - 64*32, OPT_MONO));	/* L8 does */
+	while(!cmd_ready()) { FTSIM_idle(&sim, 200); }
+
+	bundle[6] = 0;								/* old bundle without the decoded size */
+	CHECK(!ASSET_bundle_load(b, 7, RAM_G, 0));
+}
+
+int main(void)
+{
+	ASSET_t a;
+	uint32_t i, bytes;
+
+	for(i=0; i<sizeof(data); ++i) { data[i] = (uint8_t)(i*13); }
+
+	FTSIM_init(&sim);
+	FTSIM_attach(&sim, 0);
+	reset();
+
+	a = asset(1, RAM_G);
+	CHECK(ASSET_load(&a) == ASSET_UPLOADED);
+	ASSET_end();
+	CHECK(!memcmp(&sim.mem[RAM_G], data, sizeof(data)));
+
+	/* after a reset the asset is verified, not sent again */
+	reset();
+	bytes = (uint32_t)sim.stats.bytes;
+	CHECK(ASSET_load(&a) == ASSET_CACHED);
+	CHECK(sim.stats.bytes - bytes < sizeof(data));
+
+	/* changed memory is uploaded again */
+	sim.mem[RAM_G + 10] ^= 0xFF;
+	CHECK(ASSET_load(&a) == ASSET_UPLOADED);
+
+	/* a full manifest is an error and nothing is written */
+	ASSET_invalidate();
+	for(i=0; i<ASSET_MAX; ++i)
+	{
+		a = asset(i, RAM_G + i*sizeof(data));
+		CHECK(ASSET_load(&a) == ASSET_UPLOADED);
+	}
+	a = asset(ASSET_MAX, RAM_G + ASSET_MAX*sizeof(data));
+	CHECK(ASSET_load(&a) == ASSET_ERROR);
+	CHECK(sim.mem[a.addr + 1] != data[1]);
+
+	test_bundle();
+
+	/* a stuck co-processor makes the CRC time out instead of hanging */
+	a = asset(0, RAM_G);
+	sim.fault = 1;
+	FTSIM_wr32(&sim, REG_CMD_READ, 0xFFF);
+	CHECK(ASSET_load(&a) == ASSET_ERROR);
+
+	FTSIM_free(&sim);
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,179 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    batch_test.c
+  * @brief   HOST_MEM_BATCH test (host)
+  *          Runs batches against the FT800 model and checks the memory
+  *          contents, the data read back, the SPI transactions and bytes:
+  *          consecutive address-adjacent transfers share a transaction,
+  *          gaps, reordered and mixed direction transfers don't, and a
+  *          batch with an unknown direction is rejected before anything
+  *          is sent.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_SIM -I. -Itests -Itools -o batch_test tests/batch_test.c tests/stm32_mock.c tools/ftsim.c ft800.c
+  *          Usage: batch_test
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ft800.h"
+#include "ftsim.h"
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+#define BASE        (RAM_G + 0x100)
+
+static FTSIM_t sim;
+static uint64_t t0;
+static uint32_t b0;
+
+static void reset(void)
+{
+	FTSIM_free(&sim);
+	FTSIM_init(&sim);
+	FTSIM_attach(&sim, 0);
+	FT_device_init(FT_dev, 0);
+	memset(&sim.mem[BASE], 0xEE, 64);
+}
+
+static void mark(void)
+{
+	t0 = sim.stats.transactions;
+	b0 = FT_dev->spi_bytes;
+}
+
+static uint32_t transactions(void) { return (uint32_t)(sim.stats.transactions - t0); }
+static uint32_t bytes(void)        { return FT_dev->spi_bytes - b0; }
+
+/* writes and reads that continue each other: one transaction per direction */
+static void test_merged(void)
+{
+	uint8_t a[4] = { 1, 2, 3, 4 }, b[2] = { 5, 6 }, c[6] = { 7, 8, 9, 10, 11, 12 };
+	uint8_t r1[5], r2[7];
+	int32_t t[6] = { 0x10000, 2, -3, 4, 0x10000, 0x12345678 }, back[6];
+	HOST_MEM_Op_t wr[3] =
+	{
+		{ BASE,     a, 4, HOST_MEM_WRITE },
+		{ BASE + 4, b, 2, HOST_MEM_WRITE },
+		{ BASE + 6, c, 6, HOST_MEM_WRITE },
+	};
+	HOST_MEM_Op_t rd[2] =
+	{
+		{ BASE,     r1, 5, HOST_MEM_READ },
+		{ BASE + 5, r2, 7, HOST_MEM_READ },
+	};
+	HOST_MEM_Op_t regs[6];
+	uint8_t i;
+
+	reset();
+	mark();
+	CHECK(HOST_MEM_BATCH(wr, 3));
+	CHECK(transactions() == 1);
+	CHECK(bytes() == 3 + 12);
+	for(i=0; i<12; ++i) { CHECK(sim.mem[BASE + i] == i + 1); }
+	CHECK(sim.mem[BASE + 12] == 0xEE);
+
+	mark();
+	CHECK(HOST_MEM_BATCH(rd, 2));
+	CHECK(transactions() == 1);
+	CHECK(bytes() == 4 + 12);
+	for(i=0; i<5; ++i) { CHECK(r1[i] == i + 1); }
+	for(i=0; i<7; ++i) { CHECK(r2[i] == i + 6); }
+
+	/* the six touch transform words from six variables */
+	for(i=0; i<6; ++i)
+	{
+		regs[i].addr = REG_TOUCH_TRANSFORM_A + 4*i;
+		regs[i].buf = (uint8_t*)&t[i];
+		regs[i].len = 4;
+		regs[i].dir = HOST_MEM_WRITE;
+	}
+	mark();
+	CHECK(HOST_MEM_BATCH(regs, 6));
+	CHECK(transactions() == 1);
+	for(i=0; i<6; ++i) { back[i] = (int32_t)FTSIM_rd32(&sim, REG_TOUCH_TRANSFORM_A + 4*i); }
+	CHECK(!memcmp(back, t, sizeof(t)));
+}
+
+/* only a transfer that continues the one before it in the list is merged */
+static void test_unmerged(void)
+{
+	uint8_t a[4] = { 1, 2, 3, 4 }, b[4] = { 5, 6, 7, 8 }, r[4];
+	HOST_MEM_Op_t gap[2] =
+	{
+		{ BASE,     a, 4, HOST_MEM_WRITE },
+		{ BASE + 5, b, 4, HOST_MEM_WRITE },
+	};
+	HOST_MEM_Op_t reversed[2] =
+	{
+		{ BASE + 4, b, 4, HOST_MEM_WRITE },
+		{ BASE,     a, 4, HOST_MEM_WRITE },
+	};
+	HOST_MEM_Op_t mixed[3] =
+	{
+		{ BASE,     a, 4, HOST_MEM_WRITE },
+		{ BASE + 4, r, 4, HOST_MEM_READ },
+		{ BASE + 8, b, 4, HOST_MEM_WRITE },
+	};
+
+	reset();
+	mark();
+	CHECK(HOST_MEM_BATCH(gap, 2));
+	CHECK(transactions() == 2);
+	CHECK(bytes() == 2*(3 + 4));
+	CHECK(!memcmp(&sim.mem[BASE], a, 4) && sim.mem[BASE + 4] == 0xEE && !memcmp(&sim.mem[BASE + 5], b, 4));
+
+	reset();
+	mark();
+	CHECK(HOST_MEM_BATCH(reversed, 2));
+	CHECK(transactions() == 2);
+	CHECK(!memcmp(&sim.mem[BASE], a, 4) && !memcmp(&sim.mem[BASE + 4], b, 4));
+
+	reset();
+	mark();
+	CHECK(HOST_MEM_BATCH(mixed, 3));
+	CHECK(transactions() == 3);
+	CHECK(bytes() == (3 + 4) + (4 + 4) + (3 + 4));
+	CHECK(r[0] == 0xEE && r[3] == 0xEE);
+	CHECK(!memcmp(&sim.mem[BASE + 8], b, 4));
+}
+
+/* an unknown direction rejects the whole batch, an empty one sends nothing */
+static void test_reject(void)
+{
+	uint8_t a[4] = { 1, 2, 3, 4 };
+	HOST_MEM_Op_t bad[2] =
+	{
+		{ BASE,     a, 4, HOST_MEM_WRITE },
+		{ BASE + 4, a, 4, 2 },
+	};
+
+	reset();
+	mark();
+	CHECK(!HOST_MEM_BATCH(bad, 2));
+	CHECK(transactions() == 0 && bytes() == 0);
+	CHECK(sim.mem[BASE] == 0xEE);
+
+	CHECK(HOST_MEM_BATCH(bad, 0));
+	CHECK(transactions() == 0);
+	CHECK(!sim.fault);
+}
+
+int main(void)
+{
+	test_merged();
+	test_unmerged();
+	test_reject();
+
+	FTSIM_free(&sim);
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
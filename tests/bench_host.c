@@ -0,0 +1,104 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    bench_host.c
+  * @brief   Benchmark suite on a PC (host)
+  *          Runs bench.c against the FT800 model and prints the CSV report of
+  *          BENCH_report. Cycles are simulated host cycles (see cycles.h),
+  *          so results can be compared between builds without a board; the
+  *          host_ns column is the CPU time the PC really spent.
+  *          With a baseline file (CSV from an earlier run) the results are
+  *          compared with BENCH_compare and regressions fail the run.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_SIM -DFT_BENCH -I. -Itests -Itools -o bench_host tests/bench_host.c tests/stm32_mock.c tools/ftsim.c bench.c ft800.c tween.c shadow.c
+  *          Usage: bench_host [baseline.csv [tolerance%]]
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ft800.h"
+#include "bench.h"
+#include "ftsim.h"
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+static void out(const char *line)
+{
+	printf("%s\n", line);
+}
+
+static const BENCH_Result_t* find(const BENCH_Result_t *r, uint8_t n, const char *name)
+{
+	uint8_t i;
+
+	for(i=0; i<n; ++i) { if(!strcmp(r[i].name, name)) return &r[i]; }
+	return 0;
+}
+
+/* bench,<name>,<transactions>,<bytes>,<cycles>,<fps>[,<host_ns>] lines of an earlier report */
+static uint8_t load(const char *path, BENCH_Baseline_t *base, char names[][32])
+{
+	char line[128];
+	uint8_t n = 0;
+	FILE *f = fopen(path, "r");
+
+	if(!f) { perror(path); exit(2); }
+	while(n < BENCH_WORKLOADS && fgets(line, sizeof(line), f))
+	{
+		unsigned long t, b, c;
+
+		if(sscanf(line, "bench,%31[^,],%lu,%lu,%lu", names[n], &t, &b, &c) != 4) continue;
+		base[n].name = names[n];
+		base[n].bytes = (uint32_t)b;
+		base[n].cycles = (uint32_t)c;
+		++n;
+	}
+	fclose(f);
+	return n;
+}
+
+int main(int argc, char **argv)
+{
+	static FTSIM_t sim;
+	BENCH_Result_t r[BENCH_WORKLOADS];
+	uint8_t n;
+
+	FTSIM_init(&sim);
+	FTSIM_attach(&sim, 0);
+	FT_device_init(FT_dev, 0);
+
+	BENCH_init();
+	n = BENCH_run(r);
+	BENCH_report(r, n, out);
+
+	/* the drain after each workload is not billed: a register write workload
+	   costs its own transactions only */
+	CHECK(n == BENCH_WORKLOADS);
+	CHECK(find(r, n, "regs_single")->transactions - find(r, n, "regs_batch")->transactions == 5);
+	CHECK(find(r, n, "pixel_writes")->transactions == 256);
+	CHECK(find(r, n, "pixel_shadow")->transactions == 16);
+	CHECK(find(r, n, "start_screen")->cycles > 0 && !sim.fault);
+	CHECK(find(r, n, "tweens")->host_ns > 0);
+
+	if(argc > 1)
+	{
+		static char names[BENCH_WORKLOADS][32];
+		BENCH_Baseline_t base[BENCH_WORKLOADS];
+		uint8_t nbase = load(argv[1], base, names);
+
+		CHECK(!BENCH_compare(r, n, base, nbase, (uint8_t)(argc > 2 ? atoi(argv[2]) : 5), out));
+	}
+
+	FTSIM_free(&sim);
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
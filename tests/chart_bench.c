@@ -0,0 +1,142 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    chart_bench.c
+  * @brief   Chart widget benchmark (host)
+  *          Pushes 1M samples into a chart in blocks of varying size, checks
+  *          the column envelopes against a plain min/max and prints the
+  *          decimation time per sample. Draws the chart against the FT800
+  *          model and checks the display list budget and that an unchanged
+  *          chart frame is dropped by frame deduplication.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_SIM -I. -Itests -Itools -o chart_bench tests/chart_bench.c tests/stm32_mock.c tools/ftsim.c ft800.c chart.c
+  *          Usage: chart_bench
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ft800.h"
+#include "chart.h"
+#include "ftsim.h"
+
+#define SAMPLES     1000000UL
+#define WIDTH       480
+#define SPP         (SAMPLES / WIDTH / 2)		/* the ring wraps once */
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+static int16_t samples[SAMPLES];
+static CHART_t chart;
+static FTSIM_t sim;
+
+static double ms_since(const struct timespec *t0)
+{
+	struct timespec t1;
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	return (t1.tv_sec - t0->tv_sec)*1e3 + (t1.tv_nsec - t0->tv_nsec)/1e6;
+}
+
+/* column c of the chart against a plain min/max of its samples */
+static int column_ok(uint32_t c)
+{
+	uint32_t first = (SAMPLES / SPP - WIDTH + c) * SPP;
+	uint16_t r = chart.head + c;
+	int16_t lo = 32767, hi = -32768;
+	uint32_t i;
+
+	if(r >= chart.w) r -= chart.w;
+	for(i=first; i<first+SPP; ++i)
+	{
+		if(samples[i] < lo) lo = samples[i];
+		if(samples[i] > hi) hi = samples[i];
+	}
+	return chart.lo[r] == lo && chart.hi[r] == hi;
+}
+
+static void test_push(void)
+{
+	struct timespec t0;
+	uint32_t i, n, ok = 1;
+	double ms;
+
+	srand(1);
+	for(i=0; i<SAMPLES; ++i) { samples[i] = (int16_t)((rand() & 0xFFFF) - 32768); }
+
+	CHART_init(&chart, 0, 0, WIDTH, 200, -32768, 32767, SPP);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(i=0; i<SAMPLES; i+=n)
+	{
+		n = 1 + (i * 7919) % 997;				// odd sizes and offsets, like DMA half buffers
+		if(n > SAMPLES - i) n = SAMPLES - i;
+		CHART_push(&chart, &samples[i], n);
+	}
+	ms = ms_since(&t0);
+
+	CHECK(chart.cols == WIDTH);
+	for(i=0; i<WIDTH; ++i) { ok &= column_ok(i); }
+	CHECK(ok);
+
+	printf("push %lu samples: %.2f ms, %.2f ns/sample\n", SAMPLES, ms, ms * 1e6 / SAMPLES);
+}
+
+static void frame(uint8_t mode)
+{
+	cmd(CMD_DLSTART);
+	cmd(CLEAR(1,1,1));
+	CHART_draw(&chart, mode);
+	cmd(DISPLAY());
+	cmd(CMD_SWAP);
+}
+
+static void test_draw(void)
+{
+	uint8_t mode;
+
+	FTSIM_init(&sim);
+	FTSIM_attach(&sim, 0);
+	FT_device_init(FT_dev, 0);
+	cmd_dedup(1);
+
+	for(mode=CHART_LINE; mode<=CHART_FILL; ++mode)
+	{
+		uint32_t skipped = cmd_dedup_skipped();
+		uint64_t words;
+
+		frame(mode);
+		while(!cmd_ready()) { FTSIM_idle(&sim, 1000); }
+		words = sim.stats.dl_words;
+		FTSIM_idle(&sim, sim.cost.frame);
+
+		frame(mode);
+		while(!cmd_ready()) { FTSIM_idle(&sim, 1000); }
+		FTSIM_idle(&sim, sim.cost.frame);
+
+		CHECK(cmd_dedup_skipped() == skipped + 1);		// CHART_draw words are part of the frame
+		CHECK(sim.stats.dl_words == words);
+		CHECK(FTSIM_rd32(&sim, REG_CMD_DL) <= 4UL*(chart.budget + 3));
+		CHECK(sim.shown[0] == CLEAR(1,1,1));
+		printf("draw %s: %lu display list words\n", mode ? "fill" : "line", (unsigned long)(FTSIM_rd32(&sim, REG_CMD_DL) / 4));
+	}
+	CHECK(!sim.fault);
+	FTSIM_free(&sim);
+}
+
+int main(void)
+{
+	test_push();
+	test_draw();
+
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    dedup_bench.c
+  * @brief   Frame deduplication break-even benchmark (host)
+  *          Sends frames of several sizes with a varying share of repeated
+  *          frames to the FT800 model, with and without cmd_dedup(), and
+  *          prints SPI bytes and host cycles per frame. Also checks that
+  *          argument words equal to CMD_DLSTART/CMD_SWAP don't split frames.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_SIM -I. -Itests -Itools -o dedup_bench tests/dedup_bench.c tests/stm32_mock.c tools/ftsim.c ft800.c
+  *          Usage: dedup_bench
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ft800.h"
+#include "ftsim.h"
+
+#define FRAMES      200
+#define HASH_CYCLES 12		/* host cycles per captured word on the target: copy, multiply, shift */
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+static FTSIM_t sim;
+
+static void reset(void)
+{
+	FTSIM_free(&sim);
+	FTSIM_init(&sim);
+	FTSIM_attach(&sim, 0);
+	FT_device_init(FT_dev, 0);
+}
+
+#define MODE_CMD    0		/* cmd() per word */
+#define MODE_BURST  1		/* whole frame with one cmd_burst() */
+#define MODE_DEDUP  2		/* cmd() per word, cmd_dedup(1) */
+
+/* a frame of n words, the contents depend on seed */
+static void frame(uint16_t n, uint32_t seed, uint8_t mode)
+{
+	static uint32_t buf[FT_DEDUP_WORDS];
+	uint16_t i, k = 0;
+
+	buf[k++] = CMD_DLSTART;
+	buf[k++] = CLEAR(1,1,1);
+	buf[k++] = BEGIN(FTPOINTS);
+	for(i=0; i<n-6; ++i) { buf[k++] = VERTEX2II((i*7) & 0x1FF, (i*3 + seed) & 0x1FF, 0, 0); }
+	buf[k++] = END();
+	buf[k++] = DISPLAY();
+	buf[k++] = CMD_SWAP;
+
+	if(mode == MODE_DEDUP) { FTSIM_idle(&sim, HASH_CYCLES*k); }	// capture happens before the burst
+	if(mode == MODE_BURST) { cmd_burst(buf, k); }
+	else { for(i=0; i<k; ++i) { cmd(buf[i]); } }
+}
+
+/* FRAMES frames, repeat% of them identical to the one before */
+static void run(uint16_t n, uint8_t repeat, uint8_t mode, uint64_t *bytes, uint64_t *cycles)
+{
+	uint32_t seed = 0;
+	uint16_t f;
+
+	reset();
+	cmd_dedup(mode == MODE_DEDUP);
+
+	for(f=0; f<FRAMES; ++f)
+	{
+		if((uint32_t)(f % 100) >= repeat) { ++seed; }
+		frame(n, seed, mode);
+		while(!cmd_ready()) { FTSIM_idle(&sim, 200); }
+	}
+
+	*bytes = sim.stats.bytes / FRAMES;
+	*cycles = sim.now / FRAMES;
+}
+
+/* a colour argument that looks like CMD_SWAP / CMD_DLSTART stays in the frame */
+static void test_arguments(void)
+{
+	uint32_t dl_words;
+
+	reset();
+	cmd_dedup(1);
+
+	cmd(CMD_DLSTART);
+	cmd_fgcolor(CMD_SWAP);
+	cmd_bgcolor(CMD_DLSTART);
+	cmd_text(10, 10, 26, 0, "abc");
+	cmd(DISPLAY());
+	cmd(CMD_SWAP);
+	while(!cmd_ready()) { FTSIM_idle(&sim, 200); }
+	FTSIM_idle(&sim, sim.cost.frame);
+
+	CHECK(sim.stats.swaps == 1);
+	CHECK(sim.fault == 0);
+	dl_words = sim.stats.dl_words;
+
+	/* the same frame again is dropped, with the arguments it is identical */
+	cmd(CMD_DLSTART);
+	cmd_fgcolor(CMD_SWAP);
+	cmd_bgcolor(CMD_DLSTART);
+	cmd_text(10, 10, 26, 0, "abc");
+	cmd(DISPLAY());
+	cmd(CMD_SWAP);
+	CHECK(cmd_dedup_skipped() == 1);
+	CHECK(sim.stats.dl_words == dl_words);
+
+	/* a different argument is a different frame */
+	cmd(CMD_DLSTART);
+	cmd_fgcolor(CMD_SWAP);
+	cmd_bgcolor(0x102030);
+	cmd_text(10, 10, 26, 0, "abc");
+	cmd(DISPLAY());
+	cmd(CMD_SWAP);
+	while(!cmd_ready()) { FTSIM_idle(&sim, 200); }
+	CHECK(cmd_dedup_skipped() == 1);
+	CHECK(sim.stats.commands == 10);
+}
+
+int main(void)
+{
+	static const uint16_t sizes[] = { 16, 64, 256, 1000 };
+	static const uint8_t repeats[] = { 0, 25, 50, 75, 95 };
+	uint8_t i, j;
+
+	FTSIM_init(&sim);
+	test_arguments();
+
+	/* dedup buffers a frame and sends it as one burst, so it is compared with
+	   both cmd() per word and a hand-made burst; the dedup column wins over
+	   the burst column once enough frames repeat to pay for the hashing
+	   (HASH_CYCLES per word, the model only counts bus and co-processor time) */
+	printf("frame words  repeated  bytes/frame: cmd   burst  dedup   cycles/frame: cmd     burst    dedup\n");
+	for(i=0; i<sizeof(sizes)/sizeof(sizes[0]); ++i)
+	for(j=0; j<sizeof(repeats); ++j)
+	{
+		uint64_t b[3], c[3];
+		uint8_t m;
+
+		for(m=0; m<3; ++m) { run(sizes[i], repeats[j], m, &b[m], &c[m]); }
+		printf("%11u  %7u%%  %17llu %7llu %6llu  %18llu %9llu %8llu\n", sizes[i], repeats[j],
+		       (unsigned long long)b[0], (unsigned long long)b[1], (unsigned long long)b[2],
+		       (unsigned long long)c[0], (unsigned long long)c[1], (unsigned long long)c[2]);
+
+		if(!repeats[j]) { CHECK(cmd_dedup_skipped() == 0); }
+		else            { CHECK(b[2] < b[1] && c[2] < c[1]); }
+	}
+
+	FTSIM_free(&sim);
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
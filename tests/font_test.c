@@ -0,0 +1,221 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    font_test.c
+  * @brief   Text layout test (host)
+  *          Seeds font tables in RAM_G of the FT800 model, reads them with
+  *          FONT_init and checks the cmd_text calls FONT_box produces, as
+  *          the co-processor receives them: wrapping at spaces, hard line
+  *          breaks, the ellipsis on the last line, right / centred /
+  *          vertically centred text and UTF-8 replacement characters.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_SIM -I. -Itests -Itools -o font_test tests/font_test.c tests/stm32_mock.c tools/ftsim.c ft800.c font.c
+  *          Usage: font_test
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ft800.h"
+#include "font.h"
+#include "ftsim.h"
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+#define TABLES      (RAM_G + 0x10000)	/* stand-in for the ROM font tables */
+#define FONT        28
+#define HEIGHT      20					/* letters 10, space 5, '.' 4, '?' 8 pixels wide */
+
+static FTSIM_t sim;
+
+/* cmd_text calls seen by the co-processor */
+typedef struct
+{
+	int16_t  x, y;
+	uint16_t font, options;
+	char     str[FONT_LINE+1];
+} Text_t;
+
+static Text_t texts[16];
+static uint8_t n_texts;
+
+static void on_command(FTSIM_t *s, uint32_t c, const uint32_t *args)
+{
+	uint32_t rd = FTSIM_rd32(s, REG_CMD_READ);
+	Text_t *t = &texts[n_texts];
+	uint16_t k;
+
+	if(c != CMD_TEXT || n_texts >= sizeof(texts)/sizeof(texts[0])) return;
+
+	t->x = (int16_t)(args[0] & 0xFFFF);
+	t->y = (int16_t)(args[0] >> 16);
+	t->font = (uint16_t)(args[1] & 0xFFFF);
+	t->options = (uint16_t)(args[1] >> 16);
+	for(k=0; k<FONT_LINE; ++k)
+	{
+		t->str[k] = (char)s->mem[RAM_CMD + ((rd + 12 + k) & (FT_CMD_FIFO_SIZE-1))];
+		if(!t->str[k]) break;
+	}
+	t->str[k] = 0;
+	++n_texts;
+}
+
+static void reset(void)
+{
+	FT_Gpu_Fonts_t table;
+	uint8_t i;
+
+	FTSIM_free(&sim);
+	FTSIM_init(&sim);
+	FTSIM_attach(&sim, 0);
+	sim.on_command = on_command;
+	FT_device_init(FT_dev, 0);
+
+	memset(&table, 0, sizeof(table));
+	memset(table.FontWidth, 10, sizeof(table.FontWidth));
+	table.FontWidth[' '] = 5;
+	table.FontWidth['.'] = 4;
+	table.FontWidth['?'] = 8;
+	table.FontHeightInPixels = HEIGHT;
+	for(i=0; i<FONT_HANDLES-FONT_ROM_FIRST; ++i)
+	{
+		memcpy(&sim.mem[TABLES + i*FT_GPU_FONT_TABLE_SIZE], &table, FT_GPU_FONT_TABLE_SIZE);
+	}
+	FTSIM_wr32(&sim, FONT_ROM_PTR, TABLES);
+	FONT_init();
+}
+
+/* one frame with a text box, returns the lines FONT_box drew */
+static uint16_t box(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t options, const char *str)
+{
+	uint16_t lines;
+
+	n_texts = 0;
+	cmd(CMD_DLSTART);
+	cmd(CLEAR(1,1,1));
+	lines = FONT_box(x, y, w, h, FONT, options, str);
+	cmd(DISPLAY());
+	cmd(CMD_SWAP);
+	while(!cmd_ready()) { FTSIM_idle(&sim, 1000); }
+	CHECK(!sim.fault);
+	return lines;
+}
+
+static int text(uint8_t i, int16_t x, int16_t y, uint16_t options, const char *str)
+{
+	if(i >= n_texts) return 0;
+	if(texts[i].x != x || texts[i].y != y || texts[i].font != FONT || texts[i].options != options || strcmp(texts[i].str, str))
+	{
+		printf("text %u: %d,%d %u \"%s\"\n", i, texts[i].x, texts[i].y, texts[i].options, texts[i].str);
+		return 0;
+	}
+	return 1;
+}
+
+static void test_metrics(void)
+{
+	uint16_t used;
+
+	reset();
+	CHECK(FONT_height(FONT) == HEIGHT);
+	CHECK(FONT_metrics(16) && FONT_metrics(31) && !FONT_metrics(15));
+	CHECK(FONT_width(FONT, "ab c") == 35);
+	CHECK(FONT_width(FONT, "a\xC3\xB1" "b") == 28);						// ñ is one '?'
+	CHECK(FONT_fit(FONT, "abcdef", 35, &used) == 3 && used == 30);
+	CHECK(FONT_fit(FONT, "a\xE2\x82\xAC" "b", 20, &used) == 4 && used == 18);	// never splits a sequence
+}
+
+/* breaks after the last space that fits, the space itself isn't drawn */
+static void test_wrap(void)
+{
+	reset();
+	CHECK(box(10, 20, 100, 100, 0, "hello world foo bar") == 3);
+	CHECK(n_texts == 3);
+	CHECK(text(0, 10, 20, 0, "hello"));
+	CHECK(text(1, 10, 40, 0, "world foo"));
+	CHECK(text(2, 10, 60, 0, "bar"));
+
+	/* a word wider than the box is broken anywhere */
+	CHECK(box(0, 0, 45, 100, 0, "abcdefgh ij") == 3);
+	CHECK(text(0, 0, 0, 0, "abcd"));
+	CHECK(text(1, 0, 20, 0, "efgh"));
+	CHECK(text(2, 0, 40, 0, "ij"));
+}
+
+/* '\n' ends a line, an empty line takes its height but draws nothing */
+static void test_breaks(void)
+{
+	reset();
+	CHECK(box(0, 0, 200, 100, 0, "ab\n\ncd") == 3);
+	CHECK(n_texts == 2);
+	CHECK(text(0, 0, 0, 0, "ab"));
+	CHECK(text(1, 0, 40, 0, "cd"));
+}
+
+/* text that doesn't fit ends with "..." on the last line */
+static void test_ellipsis(void)
+{
+	reset();
+	CHECK(box(0, 0, 100, 40, 0, "hello world foo bar") == 2);
+	CHECK(n_texts == 2);
+	CHECK(text(0, 0, 0, 0, "hello"));
+	CHECK(text(1, 0, 20, 0, "world foo..."));
+
+	CHECK(box(0, 0, 100, 40, FONT_NOWRAP, "abcdefghijklmnop") == 1);
+	CHECK(text(0, 0, 0, 0, "abcdefgh..."));
+
+	CHECK(box(0, 0, 100, 40, FONT_NOWRAP, "abcdefghij") == 1);		// fits exactly
+	CHECK(text(0, 0, 0, 0, "abcdefghij"));
+}
+
+/* cmd_text aligns each line, OPT_CENTERY centres the block of lines */
+static void test_align(void)
+{
+	reset();
+	CHECK(box(10, 0, 100, 100, OPT_RIGHTX, "hello world") == 2);
+	CHECK(text(0, 110, 0, OPT_RIGHTX, "hello"));
+	CHECK(text(1, 110, 20, OPT_RIGHTX, "world"));
+
+	CHECK(box(10, 0, 100, 100, OPT_CENTERX, "hi") == 1);
+	CHECK(text(0, 60, 0, OPT_CENTERX, "hi"));
+
+	CHECK(box(10, 50, 100, 100, OPT_CENTERX | OPT_CENTERY, "hello world") == 2);
+	CHECK(text(0, 60, 80, OPT_CENTERX, "hello"));					// (100 - 2*20) / 2 below the top
+	CHECK(text(1, 60, 100, OPT_CENTERX, "world"));
+
+	CHECK(box(0, 0, 100, 40, OPT_CENTERY, "hello world foo bar") == 2);	// full box: no offset
+	CHECK(text(0, 0, 0, 0, "hello"));
+}
+
+/* multi-byte characters are drawn as '?' and measured as such */
+static void test_utf8(void)
+{
+	reset();
+	CHECK(box(0, 0, 200, 100, 0, "a\xC3\xB1" "b \xE2\x82\xAC\xF0\x9F\x98\x80") == 1);
+	CHECK(text(0, 0, 0, 0, "a?b ??"));
+
+	CHECK(box(0, 0, 30, 100, 0, "\xC3\xA4\xC3\xB6\xC3\xBC\xC3\x9F") == 2);	// 3 x 8 px per line
+	CHECK(text(0, 0, 0, 0, "???"));
+	CHECK(text(1, 0, 20, 0, "?"));
+}
+
+int main(void)
+{
+	test_metrics();
+	test_wrap();
+	test_breaks();
+	test_ellipsis();
+	test_align();
+	test_utf8();
+
+	FTSIM_free(&sim);
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
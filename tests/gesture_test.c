@@ -0,0 +1,144 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    gesture_test.c
+  * @brief   Gesture recognizer test (host)
+  *          Replays the recorded sample streams of tests/gestures.csv
+  *          through GESTURE_update and compares the events of every stream
+  *          with its "= ..." line: taps, long presses, drags and swipes,
+  *          with and without touch dropouts, and a new touch after a
+  *          release that was never confirmed.
+  *
+  *          Build: gcc -O2 -std=gnu99 -I. -o gesture_test tests/gesture_test.c gesture.c
+  *          Usage: gesture_test [samples.csv]   (default: tests/gestures.csv)
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "gesture.h"
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+static const char *names[] = { "none", "down", "tap", "long", "drag", "swipe", "up" };
+
+#define MAX_EVENTS	64
+
+typedef struct
+{
+	char    name[64];			/* comment line above the "= ..." line */
+	char    expect[256];		/* event names from the "= ..." line */
+	char    got[256];
+	uint8_t events[MAX_EVENTS];
+	uint8_t n;
+} Stream_t;
+
+static uint32_t streams;
+
+static void stream_check(Stream_t *st)
+{
+	uint8_t i;
+
+	if(!st->name[0]) return;
+	++streams;
+
+	st->got[0] = 0;
+	for(i=0; i<st->n; ++i)
+	{
+		if(i) strcat(st->got, " ");
+		strcat(st->got, names[st->events[i]]);
+	}
+	if(strcmp(st->got, st->expect))
+	{
+		printf("FAIL %s: expected \"%s\", got \"%s\"\n", st->name, st->expect, st->got);
+		++failed;
+	}
+}
+
+static void test_replay(const char *path)
+{
+	FILE *in = fopen(path, "r");
+	GESTURE_t g;
+	Stream_t st;
+	char line[256];
+	char name[64] = "";
+
+	CHECK(in != NULL);
+	if(!in) return;
+
+	memset(&st, 0, sizeof(st));
+	GESTURE_init(&g);
+
+	while(fgets(line, sizeof(line), in))
+	{
+		unsigned long ms;
+		int touched, x, y;
+		uint8_t ev;
+
+		line[strcspn(line, "\r\n")] = 0;
+
+		if(line[0] == '#')
+		{
+			strncpy(name, &line[1 + (line[1] == ' ')], sizeof(name) - 1);
+			continue;
+		}
+		if(line[0] == '=')
+		{
+			/* a new stream, named by the comment above it */
+			stream_check(&st);
+			memset(&st, 0, sizeof(st));
+			strcpy(st.name, name);
+			strncpy(st.expect, &line[1 + (line[1] == ' ')], sizeof(st.expect) - 1);
+			GESTURE_init(&g);
+			continue;
+		}
+		if(sscanf(line, "%lu,%d,%d,%d", &ms, &touched, &x, &y) != 4) continue;
+
+		ev = GESTURE_update(&g, (uint8_t)(touched != 0), (int16_t)x, (int16_t)y, (uint32_t)ms);
+		if(ev != GESTURE_NONE && st.n < MAX_EVENTS) { st.events[st.n++] = ev; }
+	}
+	stream_check(&st);
+	fclose(in);
+}
+
+/* a touch 1 s after a single untouched sample: the first press ends as a
+   tap and a new one starts, it must not become a long press */
+static void test_lost(void)
+{
+	GESTURE_t g;
+
+	GESTURE_init(&g);
+	CHECK(GESTURE_update(&g, 1, 10, 10, 0) == GESTURE_DOWN);
+	CHECK(GESTURE_update(&g, 1, 10, 10, 16) == GESTURE_NONE);
+	CHECK(GESTURE_update(&g, 0, 0, 0, 32) == GESTURE_NONE);
+	CHECK(GESTURE_update(&g, 1, 80, 90, 1000) == GESTURE_TAP);
+	CHECK(g.x0 == 80 && g.y0 == 90 && g.t0 == 1000);
+	CHECK(GESTURE_update(&g, 1, 80, 90, 1016) == GESTURE_DOWN);
+	CHECK(GESTURE_update(&g, 1, 80, 90, 1700) == GESTURE_LONG);
+
+	/* the deferred GESTURE_DOWN doesn't swallow a drag */
+	GESTURE_init(&g);
+	GESTURE_update(&g, 1, 10, 10, 0);
+	GESTURE_update(&g, 0, 0, 0, 16);
+	CHECK(GESTURE_update(&g, 1, 100, 100, 500) == GESTURE_TAP);
+	CHECK(GESTURE_update(&g, 1, 140, 100, 516) == GESTURE_DOWN);
+	CHECK(GESTURE_update(&g, 1, 140, 100, 532) == GESTURE_DRAG);
+	CHECK(g.dx == g.x - 100 && g.dx > GESTURE_SLOP);
+}
+
+int main(int argc, char **argv)
+{
+	test_replay(argc > 1 ? argv[1] : "tests/gestures.csv");
+	CHECK(streams >= 8);
+	test_lost();
+
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
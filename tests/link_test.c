@@ -0,0 +1,166 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    link_test.c
+  * @brief   SPI link training test (host)
+  *          Trains the link against the FT800 model with the mocked RCC
+  *          clocks: no rate above LINK_MAX_HZ is tried, a rate that fails
+  *          the CMD_MEMCRC check limits the selection, and after a REG_ID
+  *          error LINK_check recovers and an unchanged frame is sent again
+  *          with deduplication on.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_SIM -I. -Itests -Itools -o link_test tests/link_test.c tests/stm32_mock.c tools/ftsim.c spi.c ft800.c link.c
+  *          Usage: link_test
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "stm32f4xx.h"
+#include "stm32_mock.h"
+#include "spi.h"
+#include "ft800.h"
+#include "link.h"
+#include "ftsim.h"
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+static FTSIM_t sim;
+
+#define BR(spi)     ((spi)->CR1 & 0x0038)
+
+/* every CMD_MEMCRC records the SPI clock it was tested at, and corrupts the
+   test area at the rate given in bad (the model itself has no clock limit) */
+static uint32_t fastest;
+static int32_t bad = -1;
+
+static void on_command(FTSIM_t *s, uint32_t c, const uint32_t *args)
+{
+	uint32_t hz;
+
+	if(c != CMD_MEMCRC) return;
+	hz = SPI_bus_hz(FT_BUS, BR(FT_SPI));
+	if(hz > fastest) fastest = hz;
+	if((int32_t)BR(FT_SPI) == bad) s->mem[args[0]] ^= 0x01;
+}
+
+static void reset(void)
+{
+	MOCK_reset();
+	FTSIM_free(&sim);
+	FTSIM_init(&sim);
+	FTSIM_attach(&sim, 0);
+	sim.on_command = on_command;
+	FT_device_init(FT_dev, 0);
+	SPI_init();
+	fastest = 0;
+	bad = -1;
+}
+
+/* SCK from the APB clock of the bus: SPI1 on APB2, SPI2 on APB1 */
+static void test_clock(void)
+{
+	static const FT_Bus_t bus2 = { .spi = SPI2, .spi_clk = RCC_APB1Periph_SPI2, .spi_clk_cmd = RCC_APB1PeriphClockCmd, .spi_af = GPIO_AF_SPI2 };
+
+	CHECK(SPI_bus_hz(&FT_default_bus, SPI_BaudRatePrescaler_2) == SystemCoreClock/4);
+	CHECK(SPI_bus_hz(&FT_default_bus, SPI_BaudRatePrescaler_4) == SystemCoreClock/8);
+	CHECK(SPI_bus_hz(&FT_default_bus, SPI_BaudRatePrescaler_256) == SystemCoreClock/512);
+	CHECK(SPI_bus_hz(&bus2, SPI_BaudRatePrescaler_2) == SystemCoreClock/8);
+}
+
+/* 42 MHz at /2 is out of spec: /4 is the fastest tried and, as it didn't
+   fail, no margin is applied */
+static void test_train(void)
+{
+	reset();
+	CHECK(LINK_train());
+	CHECK(fastest > 0 && fastest <= LINK_MAX_HZ);
+	CHECK(fastest == SPI_bus_hz(FT_BUS, SPI_BaudRatePrescaler_4));
+	CHECK(LINK_prescaler() == SPI_BaudRatePrescaler_4);
+	CHECK(BR(FT_SPI) == SPI_BaudRatePrescaler_4);
+	CHECK(!sim.fault);
+}
+
+/* a rate that corrupts data stops the training, the next slower passing
+   rate plus the margin is used and the co-processor still works */
+static void test_fail(void)
+{
+	int32_t m[6];
+
+	reset();
+	bad = SPI_BaudRatePrescaler_8;
+	CHECK(LINK_train());
+	CHECK(fastest == SPI_bus_hz(FT_BUS, SPI_BaudRatePrescaler_8));
+	CHECK(LINK_prescaler() == SPI_BaudRatePrescaler_32);
+	CHECK(cmd_getmatrix(m));
+	CHECK(!sim.fault);
+}
+
+static void frame(void)
+{
+	cmd(CMD_DLSTART);
+	cmd(CLEAR_COLOR_RGB(0,0,255));
+	cmd(CLEAR(1,1,1));
+	cmd(DISPLAY());
+	cmd(CMD_SWAP);
+}
+
+static void settle(void)
+{
+	while(!cmd_ready()) { FTSIM_idle(&sim, 1000); }
+	FTSIM_idle(&sim, sim.cost.frame);
+}
+
+/* the restarted co-processor shows nothing, so the frame shown before the
+   error must not be deduplicated away afterwards */
+static void test_recover(void)
+{
+	uint32_t skipped;
+
+	reset();
+	CHECK(LINK_train());
+	cmd_dedup(1);
+	frame();
+	settle();
+	skipped = cmd_dedup_skipped();
+	frame();
+	settle();
+	CHECK(cmd_dedup_skipped() == skipped + 1);
+
+	sim.mem[REG_ID] = 0;							// the link is down
+	CHECK(!LINK_check());
+	CHECK(LINK_errors() == 1);
+	CHECK(LINK_prescaler() == SPI_BaudRatePrescaler_32);
+
+	sim.mem[REG_ID] = 0x7C;							// and back
+	memset(sim.shown, 0, FT_DL_SIZE);
+	CHECK(LINK_check());							// up at the slowest rate
+	CHECK(LINK_prescaler() == SPI_BaudRatePrescaler_32);
+	CHECK(LINK_train());
+	CHECK(LINK_prescaler() == SPI_BaudRatePrescaler_4);
+	frame();
+	settle();
+	CHECK(cmd_dedup_skipped() == skipped + 1);
+	CHECK(sim.shown[0] == CLEAR_COLOR_RGB(0,0,255));
+	CHECK(!sim.fault);
+	cmd_dedup(0);
+}
+
+int main(void)
+{
+	test_clock();
+	test_train();
+	test_fail();
+	test_recover();
+
+	FTSIM_free(&sim);
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
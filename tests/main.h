@@ -0,0 +1,6 @@
+#ifndef MAIN_H
+#define MAIN_H
+
+/* Host stand-in for the application header included by spi.c */
+
+#endif
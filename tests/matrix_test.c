@@ -0,0 +1,202 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    matrix_test.c
+  * @brief   Bitmap transform matrix test (host)
+  *          Composes transforms with MATRIX_x and with the co-processor
+  *          matrix commands of the FT800 model and compares the result of
+  *          CMD_GETMATRIX and CMD_SETMATRIX with MATRIX_emit: bit-exact for
+  *          translations, power-of-two scales and quarter turns, within one
+  *          8.8 step otherwise. Checks that MATRIX_set and MATRIX_sprites
+  *          frames are deduplicated like cmd() frames.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_SIM -I. -Itests -Itools -o matrix_test tests/matrix_test.c tests/stm32_mock.c tools/ftsim.c ft800.c matrix.c
+  *          Usage: matrix_test
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ft800.h"
+#include "matrix.h"
+#include "ftsim.h"
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+static FTSIM_t sim;
+
+/* one step of a transform, applied to both sides */
+typedef struct { uint8_t op; int32_t x, y, z; } Step_t;
+
+#define OP_TRANSLATE    1
+#define OP_SCALE        2
+#define OP_ROTATE       3
+#define OP_AROUND       4
+
+typedef struct { const char *name; uint8_t exact; Step_t steps[4]; } Case_t;
+
+#define PX(v)           ((int32_t)((v) * 65536.0))
+
+/* steps name only the fields they use */
+#define TRANSLATE(dx,dy)    { .op = OP_TRANSLATE, .x = (dx), .y = (dy) }
+#define SCALE(sx,sy)        { .op = OP_SCALE, .x = (sx), .y = (sy) }
+#define ROTATE(a)           { .op = OP_ROTATE, .x = (a) }
+#define AROUND(a,cx,cy)     { .op = OP_AROUND, .x = (a), .y = (cx), .z = (cy) }
+
+static const Case_t cases[] =
+{
+	{ "identity",        1, { { .op = 0 } } },
+	{ "translate",       1, { TRANSLATE(PX(10.5), PX(-3.3)) } },
+	{ "scale 2, 0.5",    1, { SCALE(PX(2), PX(0.5)) } },
+	{ "quarter turns",   1, { ROTATE(16384), TRANSLATE(PX(7), PX(9)), ROTATE(32768) } },
+	{ "around centre",   1, { AROUND(49152, PX(32), PX(32)), SCALE(PX(4), PX(4)) } },
+	{ "rotate 30",       0, { ROTATE(65536/12) } },
+	{ "rotate, scale",   0, { TRANSLATE(PX(64), PX(64)), ROTATE(12345), SCALE(PX(1.5), PX(1.5)), TRANSLATE(PX(-64), PX(-64)) } },
+	{ "scale 3",         0, { SCALE(PX(3), PX(-3)), ROTATE(-5000) } },
+};
+
+static void apply(MATRIX_t *m, const Step_t *s)
+{
+	switch(s->op)
+	{
+		case OP_TRANSLATE:
+			MATRIX_translate(m, s->x, s->y);
+			cmd_translate(s->x, s->y);
+			break;
+		case OP_SCALE:
+			MATRIX_scale(m, s->x, s->y);
+			cmd_scale(s->x, s->y);
+			break;
+		case OP_ROTATE:
+			MATRIX_rotate(m, s->x);
+			cmd_rotate(s->x);
+			break;
+		case OP_AROUND:
+			MATRIX_rotate_around(m, s->x, s->y, s->z);
+			cmd_translate(s->y, s->z);
+			cmd_rotate(s->x);
+			cmd_translate(-s->y, -s->z);
+			break;
+	}
+}
+
+/* sign-extended field of a BITMAP_TRANSFORM word */
+static int32_t field(uint32_t word, uint8_t k)
+{
+	uint8_t bits = (k == 2 || k == 5) ? 24 : 17;
+	int32_t v = (int32_t)(word & ((1UL << bits) - 1));
+
+	return (v & (1L << (bits-1))) ? v - (1L << bits) : v;
+}
+
+static void test_cases(void)
+{
+	uint32_t n, i, k;
+
+	for(n=0; n<sizeof(cases)/sizeof(cases[0]); ++n)
+	{
+		const Case_t *c = &cases[n];
+		MATRIX_t m;
+		uint32_t dl[6];
+		int32_t get[6];
+		int ok = 1;
+
+		MATRIX_identity(&m);
+		cmd(CMD_DLSTART);
+		cmd_loadidentity();
+		for(i=0; i<4 && c->steps[i].op; ++i) { apply(&m, &c->steps[i]); }
+		cmd_setmatrix();
+		cmd(DISPLAY());
+		cmd(CMD_SWAP);
+		CHECK(cmd_getmatrix(get));
+
+		MATRIX_emit(dl, &m);
+		for(k=0; k<6; ++k)
+		{
+			int32_t d = field(dl[k], k) - get[k];
+			uint32_t set = FTSIM_rd32(&sim, RAM_DL + 4*k);
+
+			if(c->exact) { ok &= (d == 0) && (set == dl[k]); }
+			else         { ok &= (d >= -1 && d <= 1) && (field(set, k) == get[k]); }
+		}
+		if(!ok) { printf("case \"%s\": MATRIX_emit differs from CMD_GETMATRIX\n", c->name); }
+		CHECK(ok);
+	}
+}
+
+/* MATRIX_set and MATRIX_sprites frames go through the dedup frame buffer */
+static void frame(const MATRIX_t *m, const int16_t *xy)
+{
+	cmd(CMD_DLSTART);
+	cmd(CLEAR(1,1,1));
+	cmd(BEGIN(BITMAPS));
+	MATRIX_set(&m[0]);
+	cmd(VERTEX2II(10, 10, 0, 0));
+	MATRIX_sprites(m, xy, 3);
+	cmd(END());
+	cmd(DISPLAY());
+	cmd(CMD_SWAP);
+}
+
+static void test_dedup(void)
+{
+	static const int16_t xy[6] = { 20, 20, 40, 40, 60, 60 };
+	MATRIX_t m[3];
+	uint32_t words[64], t[6], last[6], n = 0, skipped, k;
+	uint8_t i;
+
+	for(i=0; i<3; ++i)
+	{
+		MATRIX_identity(&m[i]);
+		MATRIX_rotate_around(&m[i], 4096*i, PX(16), PX(16));
+	}
+
+	/* expected display list: the sprites only repeat changed transform words */
+	words[n++] = CLEAR(1,1,1);
+	words[n++] = BEGIN(BITMAPS);
+	n += MATRIX_emit(&words[n], &m[0]);
+	words[n++] = VERTEX2II(10, 10, 0, 0);
+	for(i=0; i<3; ++i)
+	{
+		MATRIX_emit(t, &m[i]);
+		for(k=0; k<6; ++k) { if(!i || t[k] != last[k]) { words[n++] = t[k]; last[k] = t[k]; } }
+		words[n++] = VERTEX2F(xy[2*i]*16, xy[2*i+1]*16);
+	}
+	words[n++] = END();
+	words[n++] = DISPLAY();
+
+	cmd_dedup(1);
+	skipped = cmd_dedup_skipped();
+	frame(m, xy);
+	while(!cmd_ready()) { FTSIM_idle(&sim, 1000); }
+	FTSIM_idle(&sim, sim.cost.frame);
+	frame(m, xy);
+	CHECK(cmd_dedup_skipped() == skipped + 1);
+
+	while(!cmd_ready()) { FTSIM_idle(&sim, 1000); }
+	FTSIM_idle(&sim, sim.cost.frame);
+	CHECK(!sim.fault);
+	CHECK(!memcmp(sim.shown, words, n*4));
+	cmd_dedup(0);
+}
+
+int main(void)
+{
+	FTSIM_init(&sim);
+	FTSIM_attach(&sim, 0);
+	FT_device_init(FT_dev, 0);
+
+	test_cases();
+	test_dedup();
+
+	FTSIM_free(&sim);
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    movie_test.c
+  * @brief   MJPEG player test (host)
+  *          Plays a JPEG sequence on the FT800 model and checks that
+  *          CMD_LOADIMAGE never decodes into a buffer used by the display
+  *          list on screen or waiting for its swap, that MOVIE_service
+  *          doesn't wait for frames larger than the FIFO and that every
+  *          frame is shown. Other commands are sent whenever MOVIE_busy
+  *          allows it and must not disturb the JPEG data.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_SIM -I. -Itests -Itools -o movie_test tests/movie_test.c tests/stm32_mock.c tools/ftsim.c ft800.c movie.c
+  *          Usage: movie_test
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ft800.h"
+#include "movie.h"
+#include "ftsim.h"
+
+#define FRAMES      10
+#define JPEG_SIZE   9000		/* more than the FIFO holds */
+#define W           64
+#define H           32
+#define SPARE       (RAM_G + 2*W*H*2)	/* cleared by commands sent while the player isn't busy */
+#define SPARE_WORDS 1024
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+static FTSIM_t sim;
+static uint8_t jpeg[FRAMES][JPEG_SIZE];
+static uint32_t decoding;			/* CMD_LOADIMAGE destination, 0: none */
+static uint32_t overwrites;
+
+/* SOI, SOF0 WxH, filler without 0xFF, EOI */
+static void make_jpeg(uint8_t *p, uint8_t seed)
+{
+	static const uint8_t sof[] = { 0xFF,0xD8, 0xFF,0xC0, 0x00,0x0B, 0x08, 0x00,H, 0x00,W, 0x01, 0x01,0x11,0x00 };
+	uint32_t i;
+
+	memcpy(p, sof, sizeof(sof));
+	for(i=sizeof(sof); i<JPEG_SIZE-2; ++i) { p[i] = (uint8_t)((i + seed) % 0xFE); }
+	p[JPEG_SIZE-2] = 0xFF;
+	p[JPEG_SIZE-1] = 0xD9;
+}
+
+static uint8_t source(void *ctx, uint32_t frame, const uint8_t **data, uint32_t *len)
+{
+	(void)ctx;
+	if(frame >= FRAMES) return 0;
+	*data = jpeg[frame];
+	*len = JPEG_SIZE;
+	return 1;
+}
+
+/* a display list uses the bitmap at addr */
+static int uses(const uint32_t *dl, uint32_t addr)
+{
+	uint16_t k;
+
+	for(k=0; k<FT_DL_SIZE/4 && dl[k] != DISPLAY(); ++k)
+	{
+		if(dl[k] == BITMAP_SOURCE(addr)) return 1;
+	}
+	return 0;
+}
+
+/* the buffer being decoded is neither on screen nor about to be */
+static void check_target(void)
+{
+	if(!decoding) return;
+	if(uses(sim.shown, decoding)) { ++overwrites; }
+	if(sim.mem[REG_DLSWAP] != DLSWAP_DONE && uses((const uint32_t*)&sim.mem[RAM_DL], decoding)) { ++overwrites; }
+}
+
+static void on_command(FTSIM_t *s, uint32_t cmd, const uint32_t *args)
+{
+	(void)s;
+	decoding = (cmd == CMD_LOADIMAGE) ? args[0] : 0;
+	check_target();
+}
+
+int main(void)
+{
+	MOVIE_t m;
+	uint32_t i, bytes, most = 0, busy = 0, extra = 0;
+
+	for(i=0; i<FRAMES; ++i) { make_jpeg(jpeg[i], (uint8_t)i); }
+
+	FTSIM_init(&sim);
+	FTSIM_attach(&sim, 0);
+	FT_device_init(FT_dev, 0);
+	sim.on_command = on_command;
+	memset(&sim.mem[SPARE], 0xFF, 4*SPARE_WORDS);
+
+	memset(&m, 0, sizeof(m));
+	m.buf[0] = RAM_G;
+	m.buf[1] = RAM_G + W*H*2;
+	m.width = W;
+	m.height = H;
+	m.interval = 2;
+	m.refresh = 60;
+	m.source = source;
+
+	CHECK(MOVIE_start(&m));
+
+	for(i=0; i<100000 && !MOVIE_done(&m); ++i)
+	{
+		FTSIM_idle(&sim, 20000);
+
+		bytes = (uint32_t)sim.stats.bytes;
+		if(MOVIE_service(&m))
+		{
+			cmd(CMD_DLSTART);
+			cmd(CLEAR(1,1,1));
+			MOVIE_draw(&m, 0, 0);
+			cmd(DISPLAY());
+			cmd(CMD_SWAP);
+		}
+		else if(!MOVIE_busy(&m) && i % 7 == 0 && extra < SPARE_WORDS)
+		{
+			cmd_memzero(SPARE + 4*extra, 4);				// other co-processor work between frames
+			++extra;
+		}
+		if(MOVIE_busy(&m)) { ++busy; }
+		if(sim.stats.bytes - bytes > most) { most = (uint32_t)(sim.stats.bytes - bytes); }
+
+		if(sim.data_cmd != CMD_LOADIMAGE) { decoding = 0; }
+		check_target();
+	}
+
+	CHECK(MOVIE_done(&m));
+	CHECK(m.shown + m.dropped == FRAMES);
+	CHECK(overwrites == 0);
+	CHECK(busy > 0 && extra > 0);
+	for(i=0; i<4*extra && !sim.mem[SPARE + i]; ++i);
+	CHECK(i == 4*extra);
+	CHECK(most <= FT_CMD_FIFO_SIZE + 256);		// one FIFO fill per call, not the whole JPEG
+	CHECK(!sim.fault);
+
+	printf("shown %u, dropped %u, %u.%02u fps, most SPI bytes per MOVIE_service %u\n",
+	       (unsigned)m.shown, (unsigned)m.dropped, (unsigned)(MOVIE_fps(&m)/100), (unsigned)(MOVIE_fps(&m)%100), (unsigned)most);
+
+	FTSIM_free(&sim);
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,246 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    multi_bench.c
+  * @brief   Two-device benchmark (host)
+  *          Drives two FT800 models on SPI1 and SPI2 through the device API
+  *          (FT_cmd_x with an explicit device context): one device alone,
+  *          both from one thread (interleaved frames) and both from two
+  *          threads. Prints the aggregate frame rate in simulated time and
+  *          checks that each display shows its own frames, and that both
+  *          devices get a frame deduplication buffer.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_SIM -DFT_MULTI_DEVICE -I. -Itests -Itools -o multi_bench tests/multi_bench.c tests/stm32_mock.c tools/ftsim.c spi.c ft800.c -lpthread
+  *          Usage: multi_bench
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "stm32f4xx.h"
+#include "stm32_mock.h"
+#include "spi.h"
+#include "ft800.h"
+#include "ftsim.h"
+
+#define FRAMES      300
+#define POINTS      400			/* vertices per frame */
+#define CLOCK       168000000.0	/* host cycles per second */
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+/* second FT800: SPI2 on PB13/PB14/PB15, CS = PB12, PDN = PD8 */
+static const FT_Bus_t bus2 = { SPI2, RCC_APB1Periph_SPI2, RCC_APB1PeriphClockCmd, GPIO_AF_SPI2,
+                               { GPIOB, 13, RCC_AHB1Periph_GPIOB },
+                               { GPIOB, 14, RCC_AHB1Periph_GPIOB },
+                               { GPIOB, 15, RCC_AHB1Periph_GPIOB },
+                               { GPIOB, 12, RCC_AHB1Periph_GPIOB },
+                               { GPIOD,  8, RCC_AHB1Periph_GPIOD } };
+
+static const FT_Bus_t *buses[2] = { &FT_default_bus, &bus2 };
+static const uint32_t colors[2] = { 0xFF0000, 0x0000FF };
+
+static FTSIM_t sim[2];
+static FT_Device_t dev[2];
+
+static void reset(void)
+{
+	uint8_t i;
+
+	for(i=0; i<2; ++i)
+	{
+		FTSIM_free(&sim[i]);
+		FTSIM_init(&sim[i]);
+		FTSIM_attach(&sim[i], buses[i]->spi);
+		FT_device_init(&dev[i], buses[i]);
+	}
+}
+
+/* one frame on device i */
+static void frame(uint8_t i, uint32_t n)
+{
+	FT_Device_t *d = &dev[i];
+	uint16_t k;
+
+	FT_cmd(d, CMD_DLSTART);
+	FT_cmd(d, CLEAR(1,1,1));
+	FT_cmd(d, COLOR_RGB(colors[i] >> 16, (colors[i] >> 8) & 0xFF, colors[i] & 0xFF));
+	FT_cmd(d, BEGIN(FTPOINTS));
+	for(k=0; k<POINTS; ++k) { FT_cmd(d, VERTEX2II((k*7 + n) & 0x1FF, (k*3) & 0xFF, 0, 0)); }
+	FT_cmd(d, END());
+	FT_cmd_text(d, 10, 10, 26, 0, i ? "device 2" : "device 1");
+	FT_cmd(d, DISPLAY());
+	FT_cmd(d, CMD_SWAP);
+}
+
+/* the co-processor of device i has caught up, the last frame is shown */
+static void finish(uint8_t i)
+{
+	while(!FT_cmd_ready(&dev[i])) { FTSIM_idle(&sim[i], 200); }
+	FTSIM_idle(&sim[i], sim[i].cost.frame);
+}
+
+/* the display of device i shows colour c */
+static int shows(uint8_t i, uint8_t c)
+{
+	uint32_t rgb = COLOR_RGB(colors[c] >> 16, (colors[c] >> 8) & 0xFF, colors[c] & 0xFF);
+	uint16_t k;
+
+	for(k=0; k<FT_DL_SIZE/4; ++k) { if(sim[i].shown[k] == rgb) return 1; }
+	return 0;
+}
+
+static double fps(uint32_t frames, uint64_t cycles)
+{
+	return frames * CLOCK / (double)cycles;
+}
+
+/* device 1 alone */
+static double run_single(void)
+{
+	uint32_t n;
+
+	reset();
+	for(n=0; n<FRAMES; ++n)
+	{
+		frame(0, n);
+		while(!FT_cmd_ready(&dev[0])) { FTSIM_idle(&sim[0], 200); }
+	}
+	finish(0);
+
+	CHECK(!sim[0].fault && shows(0, 0));
+	return fps(FRAMES, sim[0].now);
+}
+
+/* both devices from one thread: the host is busy with one bus at a time, so
+   the time spent on one bus also passes on the other */
+static uint64_t start;
+
+static void begin(uint8_t i)	{ start = sim[i].now; }
+static void end(uint8_t i)		{ FTSIM_idle(&sim[i ^ 1], (uint32_t)(sim[i].now - start)); }
+
+static double run_interleaved(void)
+{
+	uint32_t n;
+	uint8_t i, busy;
+
+	reset();
+	for(n=0; n<FRAMES; ++n)
+	{
+		for(i=0; i<2; ++i) { begin(i); frame(i, n); end(i); }
+		do
+		{
+			busy = 0;
+			for(i=0; i<2; ++i) { begin(i); busy |= !FT_cmd_ready(&dev[i]); end(i); }
+			if(busy) { FTSIM_idle(&sim[0], 200); FTSIM_idle(&sim[1], 200); }
+		} while(busy);
+	}
+	for(i=0; i<2; ++i) { finish(i); }
+
+	for(i=0; i<2; ++i) { CHECK(!sim[i].fault && shows(i, i) && !shows(i, i ^ 1)); }
+	return fps(2*FRAMES, sim[0].now > sim[1].now ? sim[0].now : sim[1].now);
+}
+
+/* both devices from two threads, each thread owns one device context */
+static void* worker(void *arg)
+{
+	uint8_t i = (uint8_t)(uintptr_t)arg;
+	uint32_t n;
+
+	for(n=0; n<FRAMES; ++n)
+	{
+		frame(i, n);
+		while(!FT_cmd_ready(&dev[i])) { FTSIM_idle(&sim[i], 200); }
+	}
+	finish(i);
+	return 0;
+}
+
+static double run_threads(void)
+{
+	pthread_t t[2];
+	uint8_t i;
+
+	reset();
+	for(i=0; i<2; ++i) { pthread_create(&t[i], 0, worker, (void*)(uintptr_t)i); }
+	for(i=0; i<2; ++i) { pthread_join(t[i], 0); }
+
+	for(i=0; i<2; ++i) { CHECK(!sim[i].fault && shows(i, i) && !shows(i, i ^ 1)); }
+	CHECK(sim[0].stats.commands == sim[1].stats.commands);
+	return fps(2*FRAMES, sim[0].now > sim[1].now ? sim[0].now : sim[1].now);
+}
+
+/* SPI_init_bus sets up the bus it is given, not the compile-time one */
+static void test_init(void)
+{
+	MOCK_reset();
+	SPI_init_bus(&bus2);
+	CHECK(MOCK_log.apb1 & RCC_APB1Periph_SPI2);
+	CHECK(!(MOCK_log.apb2 & FT_SPI_CLK));
+	CHECK((MOCK_log.ahb1 & (RCC_AHB1Periph_GPIOB|RCC_AHB1Periph_GPIOD)) == (RCC_AHB1Periph_GPIOB|RCC_AHB1Periph_GPIOD));
+	CHECK(((GPIOB->MODER >> (2*13)) & 3) == GPIO_Mode_AF);
+	CHECK(((GPIOB->MODER >> (2*12)) & 3) == GPIO_Mode_OUT);
+	CHECK(SPI2->CR1 & 0x0040);
+
+	SPI_bus_prescaler(&bus2, SPI_BaudRatePrescaler_8);
+	CHECK((SPI2->CR1 & 0x0038) == SPI_BaudRatePrescaler_8);
+}
+
+/* FT_DEVICES devices get a deduplication buffer each, none is kept back
+   for the unused default device */
+static void test_dedup(void)
+{
+	FT_Device_t extra;
+	uint8_t i;
+
+	reset();
+	FT_device_init(&extra, &bus2);
+	for(i=0; i<2; ++i)
+	{
+		FT_cmd_dedup(&dev[i], 1);
+		CHECK(FT_cmd_dedup_enabled(&dev[i]));
+		frame(i, 0);
+		finish(i);
+		frame(i, 0);
+		finish(i);
+		CHECK(FT_cmd_dedup_skipped(&dev[i]) == 1);
+		FT_cmd_dedup(&dev[i], 0);
+	}
+	FT_cmd_dedup(&extra, 1);
+	CHECK(!FT_cmd_dedup_enabled(&extra));
+}
+
+int main(void)
+{
+	double single, inter, threads;
+
+	test_init();
+	test_dedup();
+
+	single  = run_single();
+	inter   = run_interleaved();
+	threads = run_threads();
+
+	printf("mode         devices  frames/s (aggregate)\n");
+	printf("single       %7u  %20.1f\n", 1, single);
+	printf("interleaved  %7u  %20.1f\n", 2, inter);
+	printf("threads      %7u  %20.1f\n", 2, threads);
+
+	/* one host thread shares its bus time between the devices, two threads
+	   (two cores or DMA-driven buses) drive both at full speed */
+	CHECK(inter > single * 0.9);
+	CHECK(threads > single * 1.8);
+
+	FTSIM_free(&sim[0]);
+	FTSIM_free(&sim[1]);
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,152 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    palette_test.c
+  * @brief   Palette quantizer test (host)
+  *          Quantizes synthetic RGB565 images and checks palette size,
+  *          index range, error report and the uploaded bitmap setup.
+  *          Images with up to 256 colours must come out exact.
+  *          Prints the quantization time of a 480x272 image.
+  *
+  *          Build: gcc -O2 -std=gnu99 -I. -o palette_test tests/palette_test.c palette.c
+  *          Usage: palette_test
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ft800.h"
+#include "palette.h"
+
+#define W       480
+#define H       272
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+/* FT800 calls of PAL_load / PAL_bitmap are recorded instead of sent */
+static uint32_t wr_addr[2], wr_len[2], wr_n;
+static uint32_t dl[8], dl_n;
+
+void HOST_MEM_WR_STR(uint32_t addr, uint8_t *pnt, uint32_t len)
+{
+	(void)pnt;
+	if(wr_n < 2) { wr_addr[wr_n] = addr; wr_len[wr_n] = len; }
+	++wr_n;
+}
+
+uint8_t (cmd)(uint32_t data)
+{
+	if(dl_n < 8) { dl[dl_n] = data; }
+	++dl_n;
+	return 1;
+}
+
+static uint16_t rgb565(uint32_t r, uint32_t g, uint32_t b)
+{
+	return (uint16_t)(((r>>3)<<11) | ((g>>2)<<5) | (b>>3));
+}
+
+/* RGB565 expanded to ARGB8888 the way RAM_PAL entries are compared */
+static uint32_t exact8888(uint16_t p)
+{
+	uint32_t r = (p>>11)&0x1F, g = (p>>5)&0x3F, b = p&0x1F;
+
+	return 0xFF000000UL | (((r<<3)|(r>>2))<<16) | (((g<<2)|(g>>4))<<8) | ((b<<3)|(b>>2));
+}
+
+static double ms_since(const struct timespec *t0)
+{
+	struct timespec t1;
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	return (t1.tv_sec - t0->tv_sec)*1e3 + (t1.tv_nsec - t0->tv_nsec)/1e6;
+}
+
+int main(void)
+{
+	static uint16_t img[W*H];
+	static uint8_t index[W*H];
+	uint32_t palette[PAL_COLORS];
+	PAL_Report_t rep;
+	struct timespec t0;
+	uint16_t colors;
+	uint32_t i, x, y;
+	double ms;
+
+	/* few colours: every colour gets its own entry, no error */
+	for(i=0; i<W*H; ++i) { img[i] = (i % 7 == 0) ? rgb565(255,0,0) : ((i & 1) ? rgb565(0,0,255) : rgb565(0,255,0)); }
+	colors = PAL_quantize(img, W*H, palette, index, &rep);
+	CHECK(colors == 3);
+	CHECK(rep.colors == 3);
+	CHECK(rep.raw_size == W*H*2);
+	CHECK(rep.pal_size == W*H + 3*4);
+	CHECK(index[0] != index[1]);
+	CHECK(index[2] == index[4]);
+	CHECK(palette[index[0]] == 0xFFFF0000UL);
+	CHECK(palette[index[1]] == 0xFF0000FFUL);
+	CHECK(palette[index[2]] == 0xFF00FF00UL);
+	CHECK(rep.mse == 0 && rep.max_err == 0);
+
+	/* 64 level grey ramp: 64 entries, exact */
+	for(i=0; i<W*H; ++i) { img[i] = rgb565((i%64)*4, (i%64)*4, (i%64)*4); }
+	colors = PAL_quantize(img, W*H, palette, index, &rep);
+	CHECK(colors == 64);
+	CHECK(rep.mse == 0 && rep.max_err == 0);
+
+	/* exactly PAL_COLORS colours still fit, one more uses the median cut */
+	for(i=0; i<W*H; ++i) { img[i] = (uint16_t)((i % PAL_COLORS) * 251); }
+	colors = PAL_quantize(img, W*H, palette, index, &rep);
+	CHECK(colors == PAL_COLORS);
+	CHECK(rep.mse == 0 && rep.max_err == 0);
+	for(i=0; i<W*H; ++i) { if(palette[index[i]] != exact8888(img[i])) break; }
+	CHECK(i == W*H);
+
+	img[0] = 0xFFFF;
+	colors = PAL_quantize(img, W*H, palette, index, &rep);
+	CHECK(colors <= PAL_COLORS && rep.max_err > 0);
+
+	/* smooth gradients with noise: palette full, error bounded */
+	srand(1);
+	for(y=0; y<H; ++y)
+	for(x=0; x<W; ++x)
+	{
+		uint32_t n = (uint32_t)(rand() & 7);
+		img[y*W+x] = rgb565(x*255/W, y*255/H, ((x+y)*255/(W+H) + n) & 0xFF);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	colors = PAL_quantize(img, W*H, palette, index, &rep);
+	ms = ms_since(&t0);
+
+	CHECK(colors > 128 && colors <= PAL_COLORS);
+	for(i=0; i<W*H; ++i) { if(index[i] >= colors) break; }
+	CHECK(i == W*H);
+	for(i=0; i<colors; ++i) { if((palette[i] >> 24) != 0xFF) break; }
+	CHECK(i == colors);
+	CHECK(rep.mse < 3*16*16);
+	CHECK(rep.mse <= rep.max_err);
+
+	/* upload and bitmap setup */
+	PAL_load(RAM_G + 1024, palette, colors, index, W*H);
+	CHECK(wr_n == 2);
+	CHECK(wr_addr[0] == RAM_PAL && wr_len[0] == (uint32_t)colors*4);
+	CHECK(wr_addr[1] == RAM_G + 1024 && wr_len[1] == W*H);
+
+	PAL_bitmap(3, RAM_G + 1024, 240, 136);
+	CHECK(dl_n == 4);
+	CHECK(dl[0] == BITMAP_HANDLE(3));
+	CHECK(dl[2] == BITMAP_LAYOUT(PALETTED, 240, 136));
+
+	printf("%ux%u image: %u colours, mse %u, max %u, %.2f ms\n", W, H, colors, (unsigned)rep.mse, (unsigned)rep.max_err, ms);
+	printf("%s\n", failed ? "FAILED" : "OK");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,216 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    power_test.c
+  * @brief   Power manager test (host)
+  *          Runs the power manager against the FT800 model with a simulated
+  *          millisecond clock: idle state sequence, the register blocks
+  *          saved before PWRDOWN and written back on wake, the SPI clock
+  *          while the FT800 runs without its PLL, and a failing RAM_G
+  *          restore hook.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_SIM -I. -Itests -Itools -o power_test tests/power_test.c tests/stm32_mock.c tools/ftsim.c spi.c ft800.c power.c
+  *          Usage: power_test
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "stm32f4xx.h"
+#include "stm32_mock.h"
+#include "spi.h"
+#include "ft800.h"
+#include "power.h"
+#include "ftsim.h"
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+static FTSIM_t sim;
+
+#define BR(spi)     ((spi)->CR1 & 0x0038)
+
+static uint32_t ms;
+static uint32_t clock_ms(void) { return ms; }
+
+/* RAM_G reload hook, fails while fail is set */
+static uint32_t restores;
+static uint8_t fail;
+static uint8_t restore(void) { ++restores; return !fail; }
+
+static const POWER_Config_t config =
+{
+	clock_ms,
+	{ 0, 1000, 2000, 3000, 4000 },
+	16,
+	CMD_CLKEXT,
+	CMD_CLK48M,
+	restore,
+};
+
+/* host commands seen after PWRDOWN and the SPI clock they were sent at */
+static uint8_t  hosts[8], host_br[8];
+static uint32_t n_hosts;
+
+static void on_host(FTSIM_t *s, uint8_t c)
+{
+	(void)s;
+	if(c == CMD_PWRDOWN) { n_hosts = 0; }
+	if(n_hosts < sizeof(hosts)) { hosts[n_hosts] = c; host_br[n_hosts] = BR(FT_SPI); ++n_hosts; }
+}
+
+/* a display configuration with no register at its reset value, one per saved block */
+static const struct { uint32_t addr; uint16_t value; } display[] =
+{
+	{ REG_HCYCLE, 525 }, { REG_HOFFSET, 40 }, { REG_HSIZE, 470 }, { REG_HSYNC0, 2 }, { REG_HSYNC1, 38 },
+	{ REG_VCYCLE, 286 }, { REG_VOFFSET, 14 }, { REG_VSIZE, 262 }, { REG_VSYNC0, 3 }, { REG_VSYNC1, 11 },
+	{ REG_SWIZZLE, 2 }, { REG_PCLK_POL, 1 }, { REG_CSPREAD, 0 }, { REG_DITHER, 0 },
+	{ REG_TOUCH_RZTHRESH, 5000 }, { REG_VOL_SOUND, 0x40 }, { REG_PWM_HZ, 400 },
+};
+#define DISPLAY_REGS	(sizeof(display)/sizeof(display[0]))
+
+static void reset(void)
+{
+	uint8_t i;
+
+	MOCK_reset();
+	FTSIM_free(&sim);
+	FTSIM_init(&sim);
+	FTSIM_attach(&sim, 0);
+	sim.on_host = on_host;
+	FT_device_init(FT_dev, 0);
+	SPI_init();
+	SPI_setprescaler(SPI_BaudRatePrescaler_4);
+
+	for(i=0; i<DISPLAY_REGS; ++i) { HOST_MEM_WR16(display[i].addr, display[i].value); }
+	HOST_MEM_WR32(REG_TOUCH_TRANSFORM_F, 0x12345678UL);
+	HOST_MEM_WR8(REG_GPIO, 0x80);
+	HOST_MEM_WR8(REG_PCLK, 5);
+	HOST_MEM_WR8(REG_PWM_DUTY, 100);
+
+	ms = 0;
+	restores = 0;
+	fail = 0;
+	n_hosts = 0;
+	POWER_init(&config);
+}
+
+static void frame(void)
+{
+	cmd(CMD_DLSTART);
+	cmd(CLEAR(1,1,1));
+	cmd(DISPLAY());
+	cmd(CMD_SWAP);
+	while(!cmd_ready()) { FTSIM_idle(&sim, 1000); }
+	POWER_frame();
+}
+
+/* DIM, STANDBY, SLEEP, then PWRDOWN clears the model */
+static void sleep_off(void)
+{
+	ms = 1000;
+	CHECK(POWER_update() == POWER_DIM);
+	CHECK(HOST_MEM_RD8(REG_PWM_DUTY) == 16);
+	ms = 2000;
+	CHECK(POWER_update() == POWER_STANDBY);
+	CHECK(sim.host_cmd == CMD_STANDBY);
+	ms = 3000;
+	CHECK(POWER_update() == POWER_SLEEP);
+	CHECK(sim.host_cmd == CMD_SLEEP);
+	ms = 4000;
+	CHECK(POWER_update() == POWER_OFF);
+	CHECK(sim.down && !POWER_awake());
+}
+
+static void test_pwrdown(void)
+{
+	uint8_t i;
+
+	reset();
+	sleep_off();
+
+	ms = 5000;
+	CHECK(POWER_wake());
+	CHECK(POWER_state() == POWER_ACTIVE);
+	CHECK(restores == 1);
+
+	/* ACTIVE and the clock commands at the slow rate, the old rate after */
+	CHECK(n_hosts == 4);
+	CHECK(hosts[1] == CMD_ACTIVE && hosts[2] == CMD_CLKEXT && hosts[3] == CMD_CLK48M);
+	for(i=1; i<4; ++i) { CHECK(host_br[i] == POWER_WAKE_PRESCALER); }
+	CHECK(BR(FT_SPI) == SPI_BaudRatePrescaler_4);
+
+	for(i=0; i<DISPLAY_REGS; ++i)
+	{
+		if(HOST_MEM_RD16(display[i].addr) != display[i].value) { printf("register %06lX not restored\n", (unsigned long)display[i].addr); ++failed; }
+	}
+	CHECK(HOST_MEM_RD32(REG_TOUCH_TRANSFORM_F) == 0x12345678UL);
+	CHECK(HOST_MEM_RD8(REG_PCLK) == 5);
+	CHECK(HOST_MEM_RD8(REG_GPIO) == 0x80);
+
+	/* the backlight waits for the first frame (REG_PWM_DUTY resets to 128) */
+	CHECK(HOST_MEM_RD8(REG_PWM_DUTY) == 0);
+	ms = 5020;
+	frame();
+	CHECK(HOST_MEM_RD8(REG_PWM_DUTY) == 100);
+	CHECK(POWER_stats()->wakes == 1 && POWER_stats()->wake_last == 20);
+	CHECK(!sim.fault);
+}
+
+/* a failed RAM_G reload keeps the state, the next call only retries it */
+static void test_restore_fail(void)
+{
+	uint64_t host_cmds;
+
+	reset();
+	sleep_off();
+
+	fail = 1;
+	CHECK(!POWER_wake());
+	CHECK(POWER_state() == POWER_OFF);
+	CHECK(restores == 1);
+	CHECK(HOST_MEM_RD16(REG_VSYNC1) == 11);
+
+	fail = 0;
+	host_cmds = sim.stats.host_cmds;
+	HOST_MEM_WR16(REG_HCYCLE, 525 + 1);				// not written again
+	CHECK(POWER_wake());
+	CHECK(POWER_state() == POWER_ACTIVE);
+	CHECK(restores == 2);
+	CHECK(sim.stats.host_cmds == host_cmds);
+	CHECK(HOST_MEM_RD16(REG_HCYCLE) == 525 + 1);
+	CHECK(BR(FT_SPI) == SPI_BaudRatePrescaler_4);
+}
+
+/* STANDBY keeps the registers, only the display and backlight come back */
+static void test_standby(void)
+{
+	reset();
+	ms = 2000;
+	CHECK(POWER_update() == POWER_STANDBY);
+	CHECK(HOST_MEM_RD8(REG_GPIO) == 0x00);
+
+	POWER_input();
+	CHECK(POWER_state() == POWER_ACTIVE);
+	CHECK(HOST_MEM_RD8(REG_GPIO) == 0x80);
+	CHECK(HOST_MEM_RD8(REG_PWM_DUTY) == 100);
+	CHECK(restores == 0);
+	CHECK(sim.host_cmd == CMD_ACTIVE);
+}
+
+int main(void)
+{
+	test_pwrdown();
+	test_restore_fail();
+	test_standby();
+
+	FTSIM_free(&sim);
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,208 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    prof_test.c
+  * @brief   Co-processor profiler test (host)
+  *          Profiles frames against the FT800 model, whose cost model makes
+  *          widgets expensive, and checks that the busy time lands on the
+  *          widget call sites, that the frame busy time matches the model,
+  *          that plain cmd() words cost no SPI reads, that PROF_frame
+  *          gives up on a co-processor that stopped and that PROF_stop
+  *          restores frame deduplication.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_SIM -DFT_PROF -I. -Itests -Itools -o prof_test tests/prof_test.c tests/stm32_mock.c tools/ftsim.c ft800.c prof.c
+  *          Usage: prof_test
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ft800.h"
+#include "prof.h"
+#include "ftsim.h"
+
+#define FRAMES      20
+#define POINTS      200
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+static FTSIM_t sim;
+
+static void points(uint16_t n)
+{
+	uint16_t k;
+
+	cmd(BEGIN(FTPOINTS));
+	for(k=0; k<n; ++k) { cmd(VERTEX2II(k & 0x1FF, (k*3) & 0xFF, 0, 0)); }
+	cmd(END());
+}
+
+static uint16_t text_line, button_line;
+
+static void frame(void)
+{
+	cmd(CMD_DLSTART);
+	cmd(CLEAR(1,1,1));
+	points(POINTS);
+	cmd_text(10, 10, 26, 0, "profiled text");		text_line = __LINE__;
+	points(POINTS);
+	cmd_button(10, 50, 100, 30, 26, 0, "button");	button_line = __LINE__;
+	cmd(DISPLAY());
+	cmd(CMD_SWAP);
+}
+
+static void print(const char *line)
+{
+	printf("%s\n", line);
+}
+
+/* site of a source line, NULL: not recorded */
+static const PROF_Site_t* site(uint16_t line)
+{
+	const PROF_Site_t *s;
+	uint8_t n, i;
+
+	s = PROF_sites(&n);
+	for(i=0; i<n; ++i) { if(s[i].file && s[i].line == line) return &s[i]; }
+	return 0;
+}
+
+/* profiles FRAMES frames, returns the busy ticks seen by the profiler and
+   the co-processor busy ticks of the model */
+static void run(uint32_t *busy, uint32_t *model)
+{
+	uint64_t cp_busy = sim.stats.cp_busy;
+	uint32_t f;
+
+	PROF_init();
+	*busy = 0;
+	for(f=0; f<FRAMES; ++f)
+	{
+		const PROF_Frame_t *pf;
+
+		frame();
+		pf = PROF_frame();
+		*busy += pf->busy;
+		CHECK(pf->busy <= pf->span && pf->complete);
+		FTSIM_idle(&sim, sim.cost.frame);
+	}
+	*model = (uint32_t)((sim.stats.cp_busy - cp_busy) * 48 / 168);	// 48 MHz ticks per 168 MHz host cycle
+}
+
+/* the co-processor keeps up with the host: the widgets are caught */
+static void test_widgets(void)
+{
+	const PROF_Site_t *text, *button, *plain;
+	const uint32_t *hist;
+	uint32_t busy, model, widget, frames = 0;
+	uint8_t n, i;
+
+	run(&busy, &model);
+	text = site(text_line);
+	button = site(button_line);
+	plain = PROF_sites(&n);
+	CHECK(text && button);
+	if(!text || !button) return;
+
+	widget = FRAMES * (sim.cost.cp_widget * 48 / 168);
+	CHECK(text->count == FRAMES && button->count == FRAMES);
+	CHECK(text->busy >= widget * 85 / 100 && button->busy >= widget * 85 / 100);
+	CHECK(text->busy / text->count > plain[0].busy / plain[0].count);
+	CHECK(busy <= model);
+
+	hist = PROF_histogram();
+	for(i=0; i<PROF_BINS; ++i) { frames += hist[i]; }
+	CHECK(frames == FRAMES);
+
+	PROF_report(print);
+}
+
+/* the co-processor is slower than the host and the FIFO backs up */
+static void test_backlog(void)
+{
+	const PROF_Site_t *plain;
+	uint32_t busy, model;
+	uint8_t n;
+
+	sim.cost.cp_word *= 50;
+	run(&busy, &model);
+	sim.cost.cp_word /= 50;
+
+	plain = PROF_sites(&n);
+	CHECK(busy >= model * 95 / 100 && busy <= model * 105 / 100);
+	CHECK(plain[0].busy > busy / 2);
+	printf("backlog: %lu of %lu busy ticks seen\n", (unsigned long)busy, (unsigned long)model);
+}
+
+/* with the co-processor idle, plain cmd() words take one sample (REG_CLOCK
+   and REG_CMD_READ) per PROF_INTERVAL bytes, a cmd_x call takes one */
+static void test_reads(void)
+{
+	uint64_t t;
+
+	PROF_init();
+	cmd_ready();
+	t = sim.stats.transactions;
+	points(100);
+	CHECK(sim.stats.transactions - t <= 2*102 + 2*(102*4/PROF_INTERVAL + 1));	// data and REG_CMD_WRITE per word
+
+	t = sim.stats.transactions;
+	cmd_text(10, 10, 26, 0, "x");
+	CHECK(sim.stats.transactions - t == 2 + 2*4);	// one sample, 4 words
+	PROF_frame();
+	PROF_stop();
+}
+
+/* a co-processor that stops doesn't hang PROF_frame, the frame is marked
+   incomplete and the next one completes once it runs again */
+static void test_timeout(void)
+{
+	const PROF_Frame_t *pf;
+
+	PROF_init();
+	sim.fault = 1;									// stop the model
+	frame();
+	pf = PROF_frame();
+	CHECK(!pf->complete);
+	sim.fault = 0;
+	pf = PROF_frame();
+	CHECK(pf->complete);
+	CHECK(cmd_ready());
+	PROF_stop();
+}
+
+static void test_dedup(void)
+{
+	cmd_dedup(1);
+	PROF_init();
+	CHECK(!cmd_dedup_enabled());
+	PROF_init();										// restarting keeps the saved state
+	PROF_stop();
+	CHECK(cmd_dedup_enabled());
+	cmd_dedup(0);
+}
+
+int main(void)
+{
+	FTSIM_init(&sim);
+	FTSIM_attach(&sim, 0);
+	FT_device_init(FT_dev, 0);
+
+	test_widgets();
+	test_backlog();
+	test_reads();
+	test_timeout();
+	test_dedup();
+	CHECK(!sim.fault);
+
+	FTSIM_free(&sim);
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
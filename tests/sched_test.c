@@ -0,0 +1,128 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    sched_test.c
+  * @brief   Bandwidth scheduler test (host)
+  *          Runs frames with command traffic, cmd_stream data and queued
+  *          jobs against the FT800 model and checks that the per-class
+  *          statistics add up to the SPI bytes the model saw, with stream
+  *          data billed to SCHED_ASSET and the budget respected.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_SIM -I. -Itests -Itools -o sched_test tests/sched_test.c tests/stm32_mock.c tools/ftsim.c ft800.c sched.c
+  *          Usage: sched_test
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ft800.h"
+#include "sched.h"
+#include "ftsim.h"
+
+#define BUDGET      4000
+#define STREAM      2048		/* CMD_MEMWRITE data per frame */
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+static FTSIM_t sim;
+static uint8_t data[STREAM], upload[16384], readback[1024];
+
+static void frame(uint8_t stream)
+{
+	uint8_t i;
+
+	cmd(CMD_DLSTART);
+	cmd(CLEAR(1,1,1));
+	for(i=0; i<8; ++i) { cmd_text(10, 10+i*20, 26, 0, "Scheduler"); }
+	cmd(DISPLAY());
+	cmd(CMD_SWAP);
+
+	if(stream)
+	{
+		cmd(CMD_MEMWRITE);
+		cmd(RAM_G + 0x20000);
+		cmd(STREAM);
+		cmd_stream(data, STREAM);
+	}
+}
+
+int main(void)
+{
+	uint64_t mark;
+	uint32_t f, sum, ui, asset, stream, jobs, streamed = 0;
+	uint8_t c;
+
+	FTSIM_init(&sim);
+	FTSIM_attach(&sim, 0);
+	FT_device_init(FT_dev, 0);
+
+	/* the host interface counts exactly what crosses the bus */
+	mark = sim.stats.bytes;
+	sum = FT_dev->spi_bytes;
+	HOST_MEM_WR32(RAM_G, 1);
+	HOST_MEM_RD16(RAM_G);
+	HOST_MEM_WR_STR(RAM_G, data, 100);
+	HOST_MEM_READ_STR(RAM_G, readback, 100);
+	cmd(CLEAR(1,1,1));
+	cmd_text(10, 10, 26, 0, "Scheduler");
+	CHECK(FT_dev->spi_bytes - sum == (uint32_t)(sim.stats.bytes - mark));
+
+	SCHED_init(BUDGET);
+	CHECK(SCHED_write(SCHED_ASSET, RAM_G, upload, sizeof(upload), 0, 0));
+	CHECK(SCHED_read(SCHED_READBACK, RAM_G + 0x10000, readback, sizeof(readback), 0, 0));
+	mark = sim.stats.bytes;
+
+	for(f=0; f<20; ++f)
+	{
+		stream = FT_dev->stream_bytes;
+		frame(f & 1);
+		stream = FT_dev->stream_bytes - stream;
+		streamed += stream;
+		SCHED_run();
+
+		ui = SCHED_stats(SCHED_UI)->frame;
+		asset = SCHED_stats(SCHED_ASSET)->frame;
+		sum = 0;
+		for(c=0; c<SCHED_CLASSES; ++c) { sum += SCHED_stats(c)->frame; }
+		jobs = sum - ui - stream;
+
+		/* every byte on the bus since the last run is billed once, stream
+		   data to SCHED_ASSET and not to the frame */
+		CHECK(sum == (uint32_t)(sim.stats.bytes - mark));
+		CHECK((f & 1) ? (stream > STREAM && asset >= stream && ui < STREAM) : !stream);
+		CHECK(ui > 0);
+
+		/* jobs fill what is left of the budget, at least one chunk, each
+		   chunk may exceed it by its transaction header */
+		CHECK(jobs <= ((ui + stream + SCHED_CHUNK < BUDGET) ? BUDGET - ui - stream : SCHED_CHUNK) + 4);
+
+		/* the polls go to the next frame's SCHED_UI */
+		mark = sim.stats.bytes;
+		while(!cmd_ready()) { FTSIM_idle(&sim, 1000); }
+	}
+	CHECK(!SCHED_busy(SCHED_ASSET) && !SCHED_busy(SCHED_READBACK));
+
+	/* jobs are charged their data and the 3 (write) or 4 (read) header bytes
+	   of each chunk, chunks are cut at the budget so there can be more */
+	sum = SCHED_stats(SCHED_ASSET)->total - streamed - sizeof(upload);
+	CHECK(sum % 3 == 0 && sum >= 3*(sizeof(upload)/SCHED_CHUNK));
+	sum = SCHED_stats(SCHED_READBACK)->total - sizeof(readback);
+	CHECK(sum % 4 == 0 && sum >= 4*(sizeof(readback)/SCHED_CHUNK));
+	CHECK(!memcmp(readback, sim.mem + RAM_G + 0x10000, sizeof(readback)));
+	CHECK(!sim.fault);
+
+	printf("ui %u, audio %u, asset %u, readback %u bytes\n",
+	       (unsigned)SCHED_stats(SCHED_UI)->total, (unsigned)SCHED_stats(SCHED_AUDIO)->total,
+	       (unsigned)SCHED_stats(SCHED_ASSET)->total, (unsigned)SCHED_stats(SCHED_READBACK)->total);
+
+	FTSIM_free(&sim);
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
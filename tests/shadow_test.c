@@ -0,0 +1,175 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    shadow_test.c
+  * @brief   RAM_G shadow test (host)
+  *          Flushes shadow regions into the FT800 model and compares RAM_G
+  *          with the expected contents: written bytes arrive, bytes never
+  *          written keep their RAM_G value even inside dirty pages, runs
+  *          merge across page boundaries, and the bytes and transactions
+  *          sent. Random writes are checked against a reference copy.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_SIM -I. -Itests -Itools -o shadow_test tests/shadow_test.c tests/stm32_mock.c tools/ftsim.c ft800.c shadow.c
+  *          Usage: shadow_test
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ft800.h"
+#include "shadow.h"
+#include "ftsim.h"
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+#define BASE        (RAM_G + 4096)
+#define SIZE        1024
+
+static FTSIM_t sim;
+static SHADOW_t shadow;
+static uint8_t mem[SIZE];
+static uint8_t expect[SIZE];
+
+/* RAM_G holds a pattern the shadow doesn't know about */
+static void reset(void)
+{
+	uint32_t i;
+
+	FTSIM_free(&sim);
+	FTSIM_init(&sim);
+	FTSIM_attach(&sim, 0);
+	FT_device_init(FT_dev, 0);
+
+	for(i=0; i<SIZE; ++i) { expect[i] = sim.mem[BASE + i] = (uint8_t)(0xE0 + i); }
+	memset(mem, 0, sizeof(mem));
+}
+
+static void put(uint32_t o, const uint8_t *data, uint32_t len)
+{
+	SHADOW_write(&shadow, BASE + o, data, len);
+	memcpy(&expect[o], data, len);
+}
+
+static int same(void)
+{
+	return !memcmp(&sim.mem[BASE], expect, SIZE);
+}
+
+static void test_init(void)
+{
+	static uint8_t big[SHADOW_PAGES*SHADOW_PAGE + 1];
+
+	CHECK(!SHADOW_init(&shadow, BASE, big, sizeof(big), 0));
+	CHECK(SHADOW_init(&shadow, BASE, big, sizeof(big) - 1, 0));
+}
+
+/* without load only written bytes go out */
+static void test_partial(void)
+{
+	static const uint8_t abc[3] = { 1, 2, 3 };
+	uint64_t t;
+	uint32_t sent;
+
+	reset();
+	CHECK(SHADOW_init(&shadow, BASE, mem, SIZE, 0));
+	t = sim.stats.transactions;
+
+	put(10, abc, 3);										// page 0, bytes 10..12
+	put(62, abc, 2);										// gap in page 0: 10..12 are sent now
+	CHECK(sim.stats.transactions == t + 1);
+	SHADOW_wr32(&shadow, BASE + 64, 0x44434241UL);			// page 1 from its first byte
+	memcpy(&expect[64], "ABCD", 4);
+	SHADOW_wr8(&shadow, BASE + 200, 0x55); expect[200] = 0x55;
+	SHADOW_wr8(&shadow, BASE + 201, 0x66); expect[201] = 0x66;
+
+	sent = SHADOW_flush(&shadow);
+	CHECK(sent == 3 + 6 + 2);								// 10..12, 62..69, 200..201
+	CHECK(sim.stats.transactions == t + 3);
+	CHECK(same());
+
+	/* clean after the flush */
+	t = sim.stats.transactions;
+	CHECK(SHADOW_flush(&shadow) == 0);
+	CHECK(sim.stats.transactions == t);
+}
+
+/* with load whole pages are sent and adjacent ones merge into one burst */
+static void test_loaded(void)
+{
+	uint64_t t;
+
+	reset();
+	CHECK(SHADOW_init(&shadow, BASE, mem, SIZE, 1));
+	CHECK(!memcmp(mem, expect, SIZE));
+	t = sim.stats.transactions;
+
+	SHADOW_wr8(&shadow, BASE + 5, 0x11);   expect[5] = 0x11;
+	SHADOW_wr8(&shadow, BASE + 100, 0x22); expect[100] = 0x22;
+	SHADOW_wr8(&shadow, BASE + 150, 0x33); expect[150] = 0x33;
+
+	CHECK(SHADOW_flush(&shadow) == 3*SHADOW_PAGE);
+	CHECK(sim.stats.transactions == t + 1);
+	CHECK(same());
+}
+
+/* writes through SHADOW_ptr are sent after SHADOW_touch */
+static void test_touch(void)
+{
+	uint8_t *p;
+
+	reset();
+	CHECK(SHADOW_init(&shadow, BASE, mem, SIZE, 0));
+	p = SHADOW_ptr(&shadow, BASE + 120);
+	CHECK(p == &mem[120]);
+	memset(p, 0x77, 20);
+	memset(&expect[120], 0x77, 20);
+	SHADOW_touch(&shadow, BASE + 120, 20);
+	CHECK(SHADOW_flush(&shadow) == 20);
+	CHECK(same());
+	CHECK(!SHADOW_ptr(&shadow, BASE + SIZE));
+}
+
+/* random short writes against a reference copy */
+static void test_random(void)
+{
+	uint8_t data[8];
+	uint32_t n, k;
+
+	reset();
+	CHECK(SHADOW_init(&shadow, BASE, mem, SIZE, 0));
+	srand(7);
+	for(n=0; n<2000; ++n)
+	{
+		uint32_t o = (uint32_t)rand() % SIZE;
+		uint32_t len = 1 + (uint32_t)rand() % 8;
+
+		if(len > SIZE - o) len = SIZE - o;
+		for(k=0; k<len; ++k) { data[k] = (uint8_t)rand(); }
+		put(o, data, len);
+		if(n % 97 == 0) { SHADOW_flush(&shadow); CHECK(same()); }
+	}
+	SHADOW_flush(&shadow);
+	CHECK(same());
+	CHECK(!sim.fault);
+}
+
+int main(void)
+{
+	test_init();
+	test_partial();
+	test_loaded();
+	test_touch();
+	test_random();
+
+	FTSIM_free(&sim);
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
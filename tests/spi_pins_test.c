@@ -0,0 +1,103 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    spi_pins_test.c
+  * @brief   SPI pin override test (host)
+  *          Builds the SPI layer with chip select and power down moved off
+  *          their default pins from the compiler command line and checks
+  *          that SPI_init, FT_spi_select/deselect, FT_pdn_low/high and a
+  *          HOST_MEM_x transfer drive the configured pins and leave the
+  *          default ones alone.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_CS_PORT=GPIOC -DFT_CS_CLK=RCC_AHB1Periph_GPIOC -DFT_CS_PIN=9 -DFT_PDN_PORT=GPIOD -DFT_PDN_CLK=RCC_AHB1Periph_GPIOD -DFT_PDN_PIN=2 -I. -Itests -o spi_pins_test tests/spi_pins_test.c tests/stm32_mock.c spi.c ft800.c
+  *          Usage: spi_pins_test
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "stm32f4xx.h"
+#include "stm32_mock.h"
+#include "spi.h"
+#include "ft800.h"
+
+#if FT_CS_PIN != 9 || FT_PDN_PIN != 2
+#error "build with the overrides of the Build: line"
+#endif
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+/* default pins: CS = PA4, PDN = PE8 */
+#define DEF_CS_PORT     GPIOA
+#define DEF_CS_PIN      4
+#define DEF_PDN_PORT    GPIOE
+#define DEF_PDN_PIN     8
+
+static void clear(void)
+{
+	MOCK_reset();
+	memset(GPIOA, 0, sizeof(GPIO_TypeDef));
+	memset(GPIOB, 0, sizeof(GPIO_TypeDef));
+	memset(GPIOC, 0, sizeof(GPIO_TypeDef));
+	memset(GPIOD, 0, sizeof(GPIO_TypeDef));
+	memset(GPIOE, 0, sizeof(GPIO_TypeDef));
+}
+
+/* neither the default CS nor the default PDN pin was touched */
+static int defaults_idle(void)
+{
+	return !(DEF_CS_PORT->BSRRH & FT_PIN(DEF_CS_PIN)) && !(DEF_CS_PORT->BSRRL & FT_PIN(DEF_CS_PIN))
+		&& !(DEF_CS_PORT->ODR & FT_PIN(DEF_CS_PIN)) && !((DEF_CS_PORT->MODER >> (2*DEF_CS_PIN)) & 3)
+		&& !DEF_PDN_PORT->BSRRH && !DEF_PDN_PORT->BSRRL && !DEF_PDN_PORT->ODR && !DEF_PDN_PORT->MODER;
+}
+
+static void test_init(void)
+{
+	clear();
+	SPI_init();
+	CHECK(MOCK_log.ahb1 & RCC_AHB1Periph_GPIOC);
+	CHECK(MOCK_log.ahb1 & RCC_AHB1Periph_GPIOD);
+	CHECK(!(MOCK_log.ahb1 & RCC_AHB1Periph_GPIOE));		// nothing else lives on port E
+	CHECK(((GPIOC->MODER >> (2*9)) & 3) == GPIO_Mode_OUT);
+	CHECK(((GPIOD->MODER >> (2*2)) & 3) == GPIO_Mode_OUT);
+	CHECK(GPIOC->ODR == FT_PIN(9));						// CS and PDN idle high
+	CHECK(GPIOD->ODR == FT_PIN(2));
+	CHECK(defaults_idle());
+}
+
+static void test_toggle(void)
+{
+	clear();
+	FT_spi_select();
+	CHECK(GPIOC->BSRRH == FT_PIN(9) && GPIOC->BSRRL == 0);
+	FT_spi_deselect();
+	CHECK(GPIOC->BSRRL == FT_PIN(9));
+
+	FT_pdn_low();
+	CHECK(GPIOD->BSRRH == FT_PIN(2) && GPIOD->BSRRL == 0);
+	FT_pdn_high();
+	CHECK(GPIOD->BSRRL == FT_PIN(2));
+	CHECK(defaults_idle());
+
+	/* a transfer selects and deselects the configured CS */
+	clear();
+	HOST_MEM_WR32(0x102478, 0x11223344UL);
+	CHECK(GPIOC->BSRRH == FT_PIN(9) && GPIOC->BSRRL == FT_PIN(9));
+	CHECK(defaults_idle());
+}
+
+int main(void)
+{
+	test_init();
+	test_toggle();
+
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,132 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    spi_test.c
+  * @brief   SPI layer test (host)
+  *          Runs the inline SPI functions of spi.h and SPI_init against the
+  *          mocked StdPeriph register file and checks the register stores,
+  *          the trace hooks and the byte sequence of HOST_MEM_x transfers.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_TRACE -I. -Itests -o spi_test tests/spi_test.c tests/stm32_mock.c spi.c ft800.c
+  *          Usage: spi_test
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "stm32f4xx.h"
+#include "stm32_mock.h"
+#include "spi.h"
+#include "ft800.h"
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+/* trace hooks record the transactions instead of trace.c */
+static uint8_t  mosi[64];
+static uint32_t n_bytes, n_begin, n_end;
+
+void TRACE_begin(void) { ++n_begin; n_bytes = 0; }
+void TRACE_byte(uint8_t out, uint8_t in) { (void)in; if(n_bytes < sizeof(mosi)) mosi[n_bytes] = out; ++n_bytes; }
+void TRACE_end(void) { ++n_end; }
+
+static void test_select(void)
+{
+	MOCK_reset();
+	FT_CS_PORT->BSRRH = 0;
+	FT_CS_PORT->BSRRL = 0;
+
+	FT_spi_select();
+	CHECK(FT_CS_PORT->BSRRH == FT_PIN(FT_CS_PIN));		// CS low with one reset store
+	CHECK(FT_CS_PORT->BSRRL == 0);
+	CHECK(n_begin == 1);
+
+	FT_spi_deselect();
+	CHECK(FT_CS_PORT->BSRRL == FT_PIN(FT_CS_PIN));		// CS high with one set store
+	CHECK(n_end == 1);
+
+	FT_PDN_PORT->BSRRH = 0;
+	FT_PDN_PORT->BSRRL = 0;
+	FT_pdn_low();
+	CHECK(FT_PDN_PORT->BSRRH == FT_PIN(FT_PDN_PIN));
+	FT_pdn_high();
+	CHECK(FT_PDN_PORT->BSRRL == FT_PIN(FT_PDN_PIN));
+}
+
+static void test_send(void)
+{
+	MOCK_reset();
+	n_bytes = 0;
+
+	CHECK(SPI_send((char)0xA5) == (char)0xA5);		// the mock's DR loops back
+	CHECK(FT_SPI->DR == 0xA5);
+	CHECK(n_bytes == 1 && mosi[0] == 0xA5);
+
+	/* waits for TXE */
+	FT_SPI->SR = SPI_I2S_FLAG_TXE | SPI_I2S_FLAG_RXNE;
+	CHECK(SPI_rec(0x12) == 0x00);
+	CHECK(n_bytes == 3 && mosi[1] == 0x12 && mosi[2] == 0x00);
+}
+
+static void test_transfers(void)
+{
+	MOCK_reset();
+
+	HOST_MEM_WR32(0x102478, 0x11223344UL);			// write: 0x80|addr, 3 address bytes, data LSB first
+	CHECK(n_bytes == 7);
+	CHECK(mosi[0] == 0x90 && mosi[1] == 0x24 && mosi[2] == 0x78);
+	CHECK(mosi[3] == 0x44 && mosi[4] == 0x33 && mosi[5] == 0x22 && mosi[6] == 0x11);
+
+	HOST_MEM_RD16(0x102478);						// read: 3 address bytes, dummy byte
+	CHECK(n_bytes == 6);
+	CHECK(mosi[0] == 0x10 && mosi[1] == 0x24 && mosi[2] == 0x78 && mosi[3] == 0x00);
+
+	HOST_CMD_ACTIVE();								// three zero bytes
+	CHECK(n_bytes == 3 && !mosi[0] && !mosi[1] && !mosi[2]);
+
+	HOST_CMD_WRITE(CMD_CLKEXT);						// 0x40|cmd, two zero bytes
+	CHECK(n_bytes == 3 && mosi[0] == (0x40|CMD_CLKEXT) && !mosi[1] && !mosi[2]);
+	CHECK(n_begin == n_end);
+}
+
+static void test_init(void)
+{
+	MOCK_reset();
+	memset(FT_SCK_PORT, 0, sizeof(GPIO_TypeDef));
+	memset(FT_MOSI_PORT, 0, sizeof(GPIO_TypeDef));
+	memset(FT_PDN_PORT, 0, sizeof(GPIO_TypeDef));
+
+	SPI_init();
+	CHECK(MOCK_log.apb2 & FT_SPI_CLK);
+	CHECK((MOCK_log.ahb1 & (FT_SCK_CLK|FT_MISO_CLK|FT_MOSI_CLK|FT_CS_CLK|FT_PDN_CLK)) == (FT_SCK_CLK|FT_MISO_CLK|FT_MOSI_CLK|FT_CS_CLK|FT_PDN_CLK));
+	CHECK(((FT_SCK_PORT->MODER >> (2*FT_SCK_PIN)) & 3) == GPIO_Mode_AF);
+	CHECK(((FT_MISO_PORT->MODER >> (2*FT_MISO_PIN)) & 3) == GPIO_Mode_AF);
+	CHECK(((FT_MOSI_PORT->MODER >> (2*FT_MOSI_PIN)) & 3) == GPIO_Mode_AF);
+	CHECK(((FT_CS_PORT->MODER >> (2*FT_CS_PIN)) & 3) == GPIO_Mode_OUT);
+	CHECK(((FT_PDN_PORT->MODER >> (2*FT_PDN_PIN)) & 3) == GPIO_Mode_OUT);
+	CHECK(((FT_SCK_PORT->AFR[FT_SCK_PIN >> 3] >> (4*(FT_SCK_PIN & 7))) & 0xF) == FT_SPI_AF);
+	CHECK(FT_CS_PORT->ODR & FT_PIN(FT_CS_PIN));		// CS and PDN idle high
+	CHECK(FT_PDN_PORT->ODR & FT_PIN(FT_PDN_PIN));
+	CHECK((FT_SPI->CR1 & 0x0038) == SPI_BaudRatePrescaler_32);
+	CHECK(FT_SPI->CR1 & 0x0040);					// enabled
+
+	SPI_setprescaler(SPI_BaudRatePrescaler_8);
+	CHECK((FT_SPI->CR1 & 0x0038) == SPI_BaudRatePrescaler_8);
+}
+
+int main(void)
+{
+	test_select();
+	test_send();
+	test_transfers();
+	test_init();
+
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
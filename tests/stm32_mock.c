@@ -0,0 +1,99 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    stm32_mock.c
+  * @brief   StdPeriph mock (host)
+  *          Peripheral registers in RAM and recording versions of the
+  *          RCC/GPIO/SPI driver functions, for building the library on a PC.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <string.h>
+
+#include "stm32f4xx.h"
+#include "stm32_mock.h"
+
+GPIO_TypeDef MOCK_GPIOA, MOCK_GPIOB, MOCK_GPIOC, MOCK_GPIOD, MOCK_GPIOE;
+#define SPI_READY	{ .SR = SPI_I2S_FLAG_TXE | SPI_I2S_FLAG_RXNE }
+SPI_TypeDef MOCK_SPI1 = SPI_READY, MOCK_SPI2 = SPI_READY, MOCK_SPI3 = SPI_READY;
+DWT_Type MOCK_DWT;
+CoreDebug_Type MOCK_CoreDebug;
+uint32_t SystemCoreClock = 168000000UL;
+
+MOCK_Log_t MOCK_log;
+
+void MOCK_reset(void)
+{
+	memset(&MOCK_log, 0, sizeof(MOCK_log));
+	memset(&MOCK_SPI1, 0, sizeof(SPI_TypeDef));
+	memset(&MOCK_SPI2, 0, sizeof(SPI_TypeDef));
+	memset(&MOCK_SPI3, 0, sizeof(SPI_TypeDef));
+	MOCK_SPI1.SR = MOCK_SPI2.SR = MOCK_SPI3.SR = SPI_I2S_FLAG_TXE | SPI_I2S_FLAG_RXNE;
+}
+
+void RCC_AHB1PeriphClockCmd(uint32_t periph, FunctionalState state)
+{
+	if(state) MOCK_log.ahb1 |= periph; else MOCK_log.ahb1 &= ~periph;
+}
+
+void RCC_APB1PeriphClockCmd(uint32_t periph, FunctionalState state)
+{
+	if(state) MOCK_log.apb1 |= periph; else MOCK_log.apb1 &= ~periph;
+}
+
+void RCC_APB2PeriphClockCmd(uint32_t periph, FunctionalState state)
+{
+	if(state) MOCK_log.apb2 |= periph; else MOCK_log.apb2 &= ~periph;
+}
+
+void RCC_GetClocksFreq(RCC_ClocksTypeDef *clocks)
+{
+	clocks->SYSCLK_Frequency = SystemCoreClock;
+	clocks->HCLK_Frequency = SystemCoreClock;
+	clocks->PCLK1_Frequency = SystemCoreClock / 4;
+	clocks->PCLK2_Frequency = SystemCoreClock / 2;
+}
+
+void GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init)
+{
+	uint8_t pin;
+
+	for(pin=0; pin<16; ++pin)
+	{
+		if(!(init->GPIO_Pin & (1U<<pin))) continue;
+		port->MODER = (port->MODER & ~(3UL<<(2*pin))) | (init->GPIO_Mode << (2*pin));
+	}
+	++MOCK_log.gpio_inits;
+}
+
+void GPIO_PinAFConfig(GPIO_TypeDef *port, uint16_t source, uint8_t af)
+{
+	port->AFR[source >> 3] = (port->AFR[source >> 3] & ~(0xFUL << (4*(source & 7)))) | ((uint32_t)af << (4*(source & 7)));
+}
+
+void GPIO_SetBits(GPIO_TypeDef *port, uint16_t pins)
+{
+	port->ODR |= pins;
+}
+
+void GPIO_ResetBits(GPIO_TypeDef *port, uint16_t pins)
+{
+	port->ODR &= ~(uint32_t)pins;
+}
+
+void SPI_Init(SPI_TypeDef *spi, SPI_InitTypeDef *init)
+{
+	spi->CR1 = init->SPI_Direction | init->SPI_Mode | init->SPI_DataSize | init->SPI_CPOL |
+	           init->SPI_CPHA | init->SPI_NSS | init->SPI_BaudRatePrescaler | init->SPI_FirstBit;
+	spi->SR = SPI_I2S_FLAG_TXE | SPI_I2S_FLAG_RXNE;
+	++MOCK_log.spi_inits;
+}
+
+void SPI_Cmd(SPI_TypeDef *spi, FunctionalState state)
+{
+	if(state) spi->CR1 |= 0x0040; else spi->CR1 &= ~0x0040;
+}
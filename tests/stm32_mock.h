@@ -0,0 +1,16 @@
+#ifndef STM32_MOCK_H
+#define STM32_MOCK_H
+
+/* What the mocked StdPeriph functions were asked to do */
+typedef struct
+{
+	uint32_t ahb1, apb1, apb2;		/* enabled peripheral clocks */
+	uint32_t gpio_inits;
+	uint32_t spi_inits;
+} MOCK_Log_t;
+
+extern MOCK_Log_t MOCK_log;
+
+void MOCK_reset(void);				/* clear the log, SPI flags TXE|RXNE set */
+
+#endif
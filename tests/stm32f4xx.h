@@ -0,0 +1,125 @@
+#ifndef STM32F4XX_H
+#define STM32F4XX_H
+
+/* Host stand-in for the STM32F4 StdPeriph headers
+ * Peripherals are plain structs in RAM (a mock register file), the driver
+ * functions in stm32_mock.c record their arguments. Only what the library
+ * uses is declared.
+ */
+
+#include <stdint.h>
+
+#define __IO volatile
+
+typedef enum { DISABLE = 0, ENABLE = !DISABLE } FunctionalState;
+
+typedef struct
+{
+	__IO uint32_t MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR;
+	__IO uint16_t BSRRL;				/* set bits */
+	__IO uint16_t BSRRH;				/* reset bits */
+	__IO uint32_t LCKR, AFR[2];
+} GPIO_TypeDef;
+
+typedef struct
+{
+	__IO uint16_t CR1;	uint16_t r0;
+	__IO uint16_t CR2;	uint16_t r1;
+	__IO uint16_t SR;	uint16_t r2;
+	__IO uint16_t DR;	uint16_t r3;	/* loopback: reads return the last write */
+} SPI_TypeDef;
+
+typedef struct { __IO uint32_t CTRL, CYCCNT; } DWT_Type;
+typedef struct { __IO uint32_t DEMCR; } CoreDebug_Type;
+
+extern GPIO_TypeDef MOCK_GPIOA, MOCK_GPIOB, MOCK_GPIOC, MOCK_GPIOD, MOCK_GPIOE;
+extern SPI_TypeDef MOCK_SPI1, MOCK_SPI2, MOCK_SPI3;
+extern DWT_Type MOCK_DWT;
+extern CoreDebug_Type MOCK_CoreDebug;
+extern uint32_t SystemCoreClock;
+
+#define GPIOA               (&MOCK_GPIOA)
+#define GPIOB               (&MOCK_GPIOB)
+#define GPIOC               (&MOCK_GPIOC)
+#define GPIOD               (&MOCK_GPIOD)
+#define GPIOE               (&MOCK_GPIOE)
+#define SPI1                (&MOCK_SPI1)
+#define SPI2                (&MOCK_SPI2)
+#define SPI3                (&MOCK_SPI3)
+#define DWT                 (&MOCK_DWT)
+#define CoreDebug           (&MOCK_CoreDebug)
+
+#define DWT_CTRL_CYCCNTENA_Msk      0x00000001UL
+#define CoreDebug_DEMCR_TRCENA_Msk  0x01000000UL
+
+typedef struct
+{
+	uint16_t SPI_Direction, SPI_Mode, SPI_DataSize, SPI_CPOL, SPI_CPHA, SPI_NSS;
+	uint16_t SPI_BaudRatePrescaler, SPI_FirstBit, SPI_CRCPolynomial;
+} SPI_InitTypeDef;
+
+typedef struct
+{
+	uint32_t GPIO_Pin;
+	uint32_t GPIO_Mode, GPIO_Speed, GPIO_OType, GPIO_PuPd;
+} GPIO_InitTypeDef;
+
+#define SPI_Direction_2Lines_FullDuplex 0x0000
+#define SPI_Mode_Master             0x0104
+#define SPI_DataSize_8b             0x0000
+#define SPI_CPOL_Low                0x0000
+#define SPI_CPHA_1Edge              0x0000
+#define SPI_NSS_Soft                0x0200
+#define SPI_FirstBit_MSB            0x0000
+
+#define SPI_BaudRatePrescaler_2     0x0000
+#define SPI_BaudRatePrescaler_4     0x0008
+#define SPI_BaudRatePrescaler_8     0x0010
+#define SPI_BaudRatePrescaler_16    0x0018
+#define SPI_BaudRatePrescaler_32    0x0020
+#define SPI_BaudRatePrescaler_64    0x0028
+#define SPI_BaudRatePrescaler_128   0x0030
+#define SPI_BaudRatePrescaler_256   0x0038
+
+#define SPI_I2S_FLAG_RXNE           0x0001
+#define SPI_I2S_FLAG_TXE            0x0002
+#define SPI_I2S_FLAG_BSY            0x0080
+
+#define GPIO_Mode_OUT               1
+#define GPIO_Mode_AF                2
+#define GPIO_Speed_50MHz            2
+#define GPIO_OType_PP               0
+#define GPIO_PuPd_UP                1
+
+#define GPIO_AF_SPI1                5
+#define GPIO_AF_SPI2                5
+#define GPIO_AF_SPI3                6
+
+#define RCC_APB2Periph_SPI1         0x00001000UL
+#define RCC_APB1Periph_SPI2         0x00004000UL
+#define RCC_APB1Periph_SPI3         0x00008000UL
+#define RCC_AHB1Periph_GPIOA        0x00000001UL
+#define RCC_AHB1Periph_GPIOB        0x00000002UL
+#define RCC_AHB1Periph_GPIOC        0x00000004UL
+#define RCC_AHB1Periph_GPIOD        0x00000008UL
+#define RCC_AHB1Periph_GPIOE        0x00000010UL
+
+typedef struct
+{
+	uint32_t SYSCLK_Frequency, HCLK_Frequency, PCLK1_Frequency, PCLK2_Frequency;
+} RCC_ClocksTypeDef;
+
+void RCC_AHB1PeriphClockCmd(uint32_t periph, FunctionalState state);
+void RCC_APB1PeriphClockCmd(uint32_t periph, FunctionalState state);
+void RCC_APB2PeriphClockCmd(uint32_t periph, FunctionalState state);
+void RCC_GetClocksFreq(RCC_ClocksTypeDef *clocks);
+
+void GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init);
+void GPIO_PinAFConfig(GPIO_TypeDef *port, uint16_t source, uint8_t af);
+void GPIO_SetBits(GPIO_TypeDef *port, uint16_t pins);
+void GPIO_ResetBits(GPIO_TypeDef *port, uint16_t pins);
+
+void SPI_Init(SPI_TypeDef *spi, SPI_InitTypeDef *init);
+void SPI_Cmd(SPI_TypeDef *spi, FunctionalState state);
+
+#endif
@@ -0,0 +1,120 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    touch_test.c
+  * @brief   Touch calibration test (host)
+  *          Runs TOUCH_calibrate, cmd_calibrate and cmd_memcrc inside frames
+  *          against the FT800 model with deduplication off and on: the
+  *          result words read back from the FIFO have to be the ones the
+  *          co-processor wrote. Checks the TOUCH_save / TOUCH_restore block.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_SIM -I. -Itests -Itools -o touch_test tests/touch_test.c tests/stm32_mock.c tools/ftsim.c ft800.c touch.c gesture.c
+  *          Usage: touch_test
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ft800.h"
+#include "touch.h"
+#include "ftsim.h"
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+static FTSIM_t sim;
+
+static void reset(uint8_t dedup)
+{
+	FTSIM_free(&sim);
+	FTSIM_init(&sim);
+	FTSIM_attach(&sim, 0);
+	FT_device_init(FT_dev, 0);
+	cmd_dedup(dedup);
+}
+
+static void begin(void)
+{
+	cmd(CMD_DLSTART);
+	cmd(CLEAR_COLOR_RGB(0,0,0));
+	cmd(CLEAR(1,1,1));
+}
+
+static void end(void)
+{
+	cmd(DISPLAY());
+	cmd(CMD_SWAP);
+	while(!cmd_ready()) { FTSIM_idle(&sim, 1000); }
+	FTSIM_idle(&sim, sim.cost.frame);
+}
+
+/* the slot of the result word is only known once the frame is in the FIFO */
+static void test_calibrate(uint8_t dedup)
+{
+	TOUCH_Calib_t c, bad;
+	uint8_t i;
+
+	reset(dedup);
+	begin();
+	CHECK(cmd_calibrate() == 1);
+	end();
+
+	reset(dedup);
+	sim.mem[RAM_CMD + 4] = 0x55;					// stale words in the FIFO
+	TOUCH_calibrate(&c);
+	end();
+	CHECK(c.magic == TOUCH_MAGIC);
+	CHECK(c.transform[0] == 0x10000 && c.transform[4] == 0x10000);
+	CHECK(!sim.fault);
+
+	for(i=0; i<6; ++i) { FTSIM_wr32(&sim, REG_TOUCH_TRANSFORM_A + 4*i, 0); }
+	CHECK(TOUCH_restore(&c));
+	CHECK(FTSIM_rd32(&sim, REG_TOUCH_TRANSFORM_A) == 0x10000);
+	CHECK(FTSIM_rd32(&sim, REG_TOUCH_TRANSFORM_E) == 0x10000);
+
+	bad = c;
+	bad.transform[2] ^= 1;
+	CHECK(!TOUCH_restore(&bad));
+}
+
+/* the same CRC with and without deduplication, and the frame that follows
+   the flushed one is still drawn */
+static void test_memcrc(void)
+{
+	static const uint8_t data[64] = "touch calibration block, CMD_MEMCRC inside a frame";
+	uint32_t crc[2];
+	uint8_t dedup;
+
+	for(dedup=0; dedup<2; ++dedup)
+	{
+		reset(dedup);
+		memcpy(&sim.mem[RAM_G], data, sizeof(data));
+		begin();
+		crc[dedup] = cmd_memcrc(RAM_G, sizeof(data));
+		end();
+		CHECK(!sim.fault);
+	}
+	CHECK(crc[0] != 0 && crc[0] == crc[1]);
+
+	begin();
+	end();
+	CHECK(sim.shown[0] == CLEAR_COLOR_RGB(0,0,0));
+	cmd_dedup(0);
+}
+
+int main(void)
+{
+	test_calibrate(0);
+	test_calibrate(1);
+	test_memcrc();
+
+	FTSIM_free(&sim);
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,212 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    tween_test.c
+  * @brief   Tween engine test (host)
+  *          Checks the easing curves (endpoints, clamping, monotony, known
+  *          midpoints, in/out symmetry), tween values over time with delay,
+  *          retargeting and TWEEN_RGB channels, the TWEEN_MAX limit and
+  *          TWEEN_update against REG_FRAMES of the FT800 model. Measures the
+  *          time of one TWEEN_step with TWEEN_MAX running tweens.
+  *
+  *          Build: gcc -O2 -std=gnu99 -DFT_SIM -I. -Itests -Itools -o tween_test tests/tween_test.c tests/stm32_mock.c tools/ftsim.c ft800.c tween.c
+  *          Usage: tween_test
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ft800.h"
+#include "tween.h"
+#include "ftsim.h"
+
+static int failed;
+#define CHECK(c)    do { if(!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); ++failed; } } while(0)
+
+#define T_ONE       65536L
+#define STEPS       10000
+
+static FTSIM_t sim;
+
+static double ms_since(const struct timespec *t0)
+{
+	struct timespec t1;
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	return (t1.tv_sec - t0->tv_sec)*1e3 + (t1.tv_nsec - t0->tv_nsec)/1e6;
+}
+
+/* every curve starts at 0, ends at 1, clamps outside and never goes back */
+static void test_curves(void)
+{
+	uint8_t c;
+	int32_t t;
+
+	for(c=TWEEN_LINEAR; c<=TWEEN_SMOOTH; ++c)
+	{
+		int32_t last = 0, ok = 1;
+
+		CHECK(TWEEN_ease(c, 0) == 0);
+		CHECK(TWEEN_ease(c, T_ONE) == T_ONE);
+		CHECK(TWEEN_ease(c, -1000) == 0);
+		CHECK(TWEEN_ease(c, 2*T_ONE) == T_ONE);
+
+		for(t=0; t<=T_ONE; t+=64)
+		{
+			int32_t e = TWEEN_ease(c, t);
+			if(e < last || e < 0 || e > T_ONE) ok = 0;
+			last = e;
+		}
+		if(!ok) { printf("FAIL curve %u is not monotonic\n", c); ++failed; }
+	}
+
+	CHECK(TWEEN_ease(TWEEN_LINEAR, T_ONE/4) == T_ONE/4);
+	CHECK(TWEEN_ease(TWEEN_IN_QUAD, T_ONE/2) == T_ONE/4);
+	CHECK(TWEEN_ease(TWEEN_OUT_QUAD, T_ONE/2) == T_ONE - T_ONE/4);
+	CHECK(TWEEN_ease(TWEEN_IN_CUBIC, T_ONE/2) == T_ONE/8);
+	CHECK(TWEEN_ease(TWEEN_OUT_CUBIC, T_ONE/2) == T_ONE - T_ONE/8);
+	CHECK(TWEEN_ease(TWEEN_IN_OUT_QUAD, T_ONE/2) == T_ONE/2);
+	CHECK(TWEEN_ease(TWEEN_IN_OUT_CUBIC, T_ONE/2) == T_ONE/2);
+	CHECK(TWEEN_ease(TWEEN_SMOOTH, T_ONE/2) == T_ONE/2);
+	CHECK(TWEEN_ease(TWEEN_LINEAR | TWEEN_RGB, T_ONE/4) == T_ONE/4);	// flags don't change the curve
+
+	/* out(t) = 1 - in(1-t), in/out curves are point symmetric */
+	for(t=0; t<=T_ONE; t+=T_ONE/64)
+	{
+		CHECK(labs(TWEEN_ease(TWEEN_OUT_QUAD, t) - (T_ONE - TWEEN_ease(TWEEN_IN_QUAD, T_ONE - t))) <= 1);
+		CHECK(labs(TWEEN_ease(TWEEN_OUT_CUBIC, t) - (T_ONE - TWEEN_ease(TWEEN_IN_CUBIC, T_ONE - t))) <= 1);
+		CHECK(labs(TWEEN_ease(TWEEN_IN_OUT_CUBIC, t) - (T_ONE - TWEEN_ease(TWEEN_IN_OUT_CUBIC, T_ONE - t))) <= 1);
+		CHECK(labs(TWEEN_ease(TWEEN_SMOOTH, t) - (T_ONE - TWEEN_ease(TWEEN_SMOOTH, T_ONE - t))) <= 1);
+	}
+}
+
+/* delay, values on the way, exact end value and removal, retargeting */
+static void test_step(void)
+{
+	int32_t x = 100, y = -50;
+
+	TWEEN_init(1000);
+	CHECK(TWEEN_start(&x, 300, 0, 100, TWEEN_LINEAR));
+	CHECK(TWEEN_start(&y, 50, 20, 10, TWEEN_IN_QUAD));
+	CHECK(TWEEN_active() == 2 && TWEEN_busy(&x) && TWEEN_busy(&y));
+
+	CHECK(TWEEN_step(1000) == 0);
+	CHECK(x == 100 && y == -50);
+	CHECK(TWEEN_step(1010) == 1);
+	CHECK(x >= 119 && x <= 120 && y == -50);					// y waits for its delay
+	CHECK(TWEEN_step(1025));
+	CHECK(y > -50 && y < 0);									// ease in: below the linear midpoint
+	CHECK(TWEEN_step(1030));
+	CHECK(y == 50 && !TWEEN_busy(&y) && TWEEN_active() == 1);
+	CHECK(x >= 159 && x <= 160);
+
+	/* retarget from the current value, the running tween is replaced */
+	CHECK(TWEEN_start(&x, 0, 0, 50, TWEEN_LINEAR));
+	CHECK(TWEEN_active() == 1);
+	CHECK(TWEEN_step(1055));
+	CHECK(x >= 79 && x <= 80);
+	CHECK(TWEEN_step(1100));
+	CHECK(x == 0 && TWEEN_active() == 0);
+	CHECK(TWEEN_step(1200) == 0);
+
+	/* stop, with and without jumping to the end */
+	x = 0;
+	TWEEN_start(&x, 1000, 0, 100, TWEEN_LINEAR);
+	TWEEN_stop(&x, 0);
+	CHECK(x == 0 && !TWEEN_busy(&x));
+	TWEEN_start(&x, 1000, 0, 100, TWEEN_LINEAR);
+	TWEEN_stop(&x, 1);
+	CHECK(x == 1000 && TWEEN_active() == 0);
+
+	/* zero duration ends with the first step */
+	TWEEN_start(&x, 7, 0, 0, TWEEN_SMOOTH);
+	CHECK(TWEEN_step(1200) && x == 7 && TWEEN_active() == 0);
+}
+
+/* colours: channels are interpolated separately, no carries between them */
+static void test_rgb(void)
+{
+	int32_t c = 0xFF0000, d = 0x00FF00;
+
+	TWEEN_init(0);
+	TWEEN_start(&c, 0x0000FF, 0, 2, TWEEN_LINEAR | TWEEN_RGB);
+	TWEEN_start(&d, 0x0100FF, 0, 2, TWEEN_LINEAR);
+	TWEEN_step(1);
+	CHECK(((c >> 16) & 0xFF) >= 0x7F && ((c >> 16) & 0xFF) <= 0x80);
+	CHECK(((c >> 8) & 0xFF) == 0);
+	CHECK((c & 0xFF) >= 0x7F && (c & 0xFF) <= 0x80);
+	CHECK(d > 0x00FF00 && d < 0x0100FF);						// a plain value crosses channels
+	TWEEN_step(2);
+	CHECK(c == 0x0000FF && d == 0x0100FF);
+}
+
+/* TWEEN_MAX tweens, one more is refused, REG_FRAMES drives TWEEN_update */
+static void test_limit(void)
+{
+	static int32_t v[TWEEN_MAX + 1];
+	uint16_t i;
+
+	FTSIM_init(&sim);
+	FTSIM_attach(&sim, 0);
+	FT_device_init(FT_dev, 0);
+	FTSIM_wr32(&sim, REG_FRAMES, 500);
+
+	TWEEN_init(500);
+	for(i=0; i<TWEEN_MAX; ++i) { CHECK(TWEEN_start(&v[i], 1000 + i, 0, 60, TWEEN_SMOOTH)); }
+	CHECK(!TWEEN_start(&v[TWEEN_MAX], 1, 0, 60, TWEEN_LINEAR));
+	CHECK(TWEEN_active() == TWEEN_MAX);
+	CHECK(TWEEN_start(&v[3], 5, 0, 60, TWEEN_LINEAR));		// retargeting needs no free slot
+
+	FTSIM_wr32(&sim, REG_FRAMES, 530);
+	CHECK(TWEEN_update());
+	CHECK(v[0] > 0 && v[0] < 1000);
+	FTSIM_wr32(&sim, REG_FRAMES, 560);
+	CHECK(TWEEN_update());
+	CHECK(TWEEN_active() == 0);
+	CHECK(v[TWEEN_MAX - 1] == 1000 + TWEEN_MAX - 1 && v[3] == 5 && v[TWEEN_MAX] == 0);
+	CHECK(!sim.fault);
+	FTSIM_free(&sim);
+}
+
+/* host time of a step with TWEEN_MAX tweens on the way, all curves mixed */
+static void test_speed(void)
+{
+	static int32_t v[TWEEN_MAX];
+	struct timespec t0;
+	uint32_t n;
+	uint16_t i;
+	double ms;
+
+	TWEEN_init(0);
+	for(i=0; i<TWEEN_MAX; ++i)
+	{
+		v[i] = i;
+		TWEEN_start(&v[i], (i & 1) ? 0x00FFFFL : 100000L, 0, 2*STEPS, (uint8_t)((i % 8) | ((i & 1) ? TWEEN_RGB : 0)));
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(n=1; n<=STEPS; ++n) { TWEEN_step(n); }
+	ms = ms_since(&t0);
+
+	CHECK(TWEEN_active() == TWEEN_MAX);
+	printf("step with %u tweens: %.0f ns, %.1f ns/tween\n", TWEEN_MAX, ms * 1e6 / STEPS, ms * 1e6 / STEPS / TWEEN_MAX);
+}
+
+int main(void)
+{
+	test_curves();
+	test_step();
+	test_rgb();
+	test_limit();
+	test_speed();
+
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,199 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    ftpack.c
+  * @brief   Asset bundle packer (host tool)
+  *          Packs raw, zlib-compressed and JPEG assets into a bundle that
+  *          ASSET_bundle_load() streams into RAM_G.
+  *
+  *          Build: gcc -O2 -o ftpack ftpack.c -lz
+  *          Usage: ftpack <bundle.bin> <id>:<raw|zlib|jpeg>:<file> ...
+  *
+  *          "zlib" entries fall back to raw when compression doesn't help.
+  *          "jpeg" entries must be baseline JPEGs, their decoded size
+  *          (RGB565) is stored so the loader can check it fits.
+  *          Use xxd -i on the bundle to link it into the firmware.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zlib.h>
+
+#define BUNDLE_MAGIC    0x4B505446UL    /* "FTPK" */
+
+#define ASSET_RAW       0
+#define ASSET_ZLIB      1
+#define ASSET_JPEG      2
+
+typedef struct
+{
+	uint32_t id;
+	uint32_t type;
+	uint32_t offset;
+	uint32_t size;
+	uint32_t raw_size;
+	uint8_t *data;
+} Entry_t;
+
+static void put32(FILE *f, uint32_t v)
+{
+	uint8_t b[4] = { (uint8_t)v, (uint8_t)(v>>8), (uint8_t)(v>>16), (uint8_t)(v>>24) };
+	fwrite(b, 1, 4, f);
+}
+
+static uint8_t *read_file(const char *name, uint32_t *size)
+{
+	FILE *f = fopen(name, "rb");
+	uint8_t *buf;
+	long len;
+
+	if(!f) { perror(name); exit(1); }
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	buf = malloc(len ? len : 1);
+	if(!buf || fread(buf, 1, len, f) != (size_t)len) { fprintf(stderr, "%s: read error\n", name); exit(1); }
+	fclose(f);
+
+	*size = (uint32_t)len;
+	return buf;
+}
+
+/* RGB565 bytes CMD_LOADIMAGE writes for a baseline JPEG (half with OPT_MONO), 0: not a baseline JPEG */
+static uint32_t jpeg_size(const uint8_t *p, uint32_t len)
+{
+	uint32_t i = 2;
+
+	if(len < 4 || p[0] != 0xFF || p[1] != 0xD8) return 0;
+
+	while(i + 4 <= len)
+	{
+		uint32_t seg = ((uint32_t)p[i+2] << 8) | p[i+3];
+
+		if(p[i] != 0xFF) return 0;
+		if(p[i+1] == 0xC0 || p[i+1] == 0xC1)		/* SOF: length, precision, height, width */
+		{
+			if(i + 9 > len) return 0;
+			return (((uint32_t)p[i+5] << 8) | p[i+6]) * (((uint32_t)p[i+7] << 8) | p[i+8]) * 2;
+		}
+		if(p[i+1] == 0xDA || (p[i+1] >= 0xC2 && p[i+1] <= 0xCF && p[i+1] != 0xC4 && p[i+1] != 0xC8 && p[i+1] != 0xCC)) return 0;
+		i += 2 + seg;
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	Entry_t *entries;
+	uint32_t count = (uint32_t)(argc - 2);
+	uint32_t offset, i;
+	unsigned long total_raw = 0, total_stored = 0;
+	FILE *out;
+
+	if(argc < 3)
+	{
+		fprintf(stderr, "usage: %s <bundle.bin> <id>:<raw|zlib|jpeg>:<file> ...\n", argv[0]);
+		return 1;
+	}
+
+	entries = calloc(count, sizeof(Entry_t));
+	offset = 8 + count*20;
+
+	for(i=0; i<count; ++i)
+	{
+		Entry_t *e = &entries[i];
+		char *spec = argv[i+2];
+		char *type = strchr(spec, ':');
+		char *file = type ? strchr(type+1, ':') : NULL;
+		uint8_t *raw;
+		uint32_t raw_size;
+
+		if(!file) { fprintf(stderr, "bad entry '%s'\n", spec); return 1; }
+		*type++ = 0;
+		*file++ = 0;
+
+		e->id = (uint32_t)strtoul(spec, NULL, 0);
+		raw = read_file(file, &raw_size);
+
+		if(!strcmp(type, "zlib"))
+		{
+			uLongf len = compressBound(raw_size);
+			uint8_t *z = malloc(len);
+
+			if(compress2(z, &len, raw, raw_size, 9) != Z_OK) { fprintf(stderr, "%s: compression failed\n", file); return 1; }
+			if(len < raw_size)
+			{
+				e->type = ASSET_ZLIB;
+				e->data = z;
+				e->size = (uint32_t)len;
+				free(raw);
+			}
+			else
+			{
+				e->type = ASSET_RAW;
+				e->data = raw;
+				e->size = raw_size;
+				free(z);
+			}
+			e->raw_size = raw_size;
+		}
+		else if(!strcmp(type, "jpeg") || !strcmp(type, "raw"))
+		{
+			e->type = strcmp(type, "raw") ? ASSET_JPEG : ASSET_RAW;
+			e->data = raw;
+			e->size = raw_size;
+			e->raw_size = (e->type == ASSET_RAW) ? raw_size : jpeg_size(raw, raw_size);
+			if(!e->raw_size) { fprintf(stderr, "%s: not a baseline JPEG\n", file); return 1; }
+		}
+		else
+		{
+			fprintf(stderr, "unknown type '%s'\n", type);
+			return 1;
+		}
+
+		e->offset = offset;
+		offset += (e->size + 3) & ~3UL;
+
+		printf("%6u %-4s %8u -> %8u bytes  %s\n", (unsigned)e->id,
+		       e->type == ASSET_ZLIB ? "zlib" : (e->type == ASSET_JPEG ? "jpeg" : "raw"),
+		       (unsigned)e->raw_size, (unsigned)e->size, file);
+		total_raw += e->raw_size;
+		total_stored += e->size;
+	}
+
+	out = fopen(argv[1], "wb");
+	if(!out) { perror(argv[1]); return 1; }
+
+	put32(out, BUNDLE_MAGIC);
+	put32(out, count);
+	for(i=0; i<count; ++i)
+	{
+		put32(out, entries[i].id);
+		put32(out, entries[i].type);
+		put32(out, entries[i].offset);
+		put32(out, entries[i].size);
+		put32(out, entries[i].raw_size);
+	}
+	for(i=0; i<count; ++i)
+	{
+		static const uint8_t zero[4] = { 0, 0, 0, 0 };
+		fwrite(entries[i].data, 1, entries[i].size, out);
+		fwrite(zero, 1, ((entries[i].size + 3) & ~3UL) - entries[i].size, out);
+		free(entries[i].data);
+	}
+	fclose(out);
+
+	printf("%u entries, %lu -> %lu bytes over SPI, bundle %u bytes\n",
+	       (unsigned)count, total_raw, total_stored, (unsigned)offset);
+	free(entries);
+	return 0;
+}
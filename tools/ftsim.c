@@ -0,0 +1,653 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    ftsim.c
+  * @brief   FT800 model (host)
+  *          SPI transaction decoder, memory, co-processor FIFO and display
+  *          frame model with a cycle cost model, for testing and
+  *          benchmarking the library on a PC.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../ft800.h"
+#include "ftsim.h"
+
+#ifdef FTSIM_ZLIB
+#include <zlib.h>
+#endif
+
+#define SIM_MASK        (FTSIM_MEM_SIZE-1)
+#define FIFO_MASK       (FT_CMD_FIFO_SIZE-1)
+
+#define MODE_READ       0
+#define MODE_WRITE      1
+#define MODE_HOST       2
+
+static struct { const void *bus; FTSIM_t *sim; } routes[FTSIM_BUSES];
+
+/*** Memory ************************************************************************/
+uint32_t FTSIM_rd32(const FTSIM_t *s, uint32_t addr)
+{
+	const uint8_t *p = &s->mem[addr & SIM_MASK];
+	return p[0] | (p[1]<<8) | ((uint32_t)p[2]<<16) | ((uint32_t)p[3]<<24);
+}
+
+void FTSIM_wr32(FTSIM_t *s, uint32_t addr, uint32_t data)
+{
+	uint8_t *p = &s->mem[addr & SIM_MASK];
+	p[0] = (uint8_t)data;
+	p[1] = (uint8_t)(data >> 8);
+	p[2] = (uint8_t)(data >> 16);
+	p[3] = (uint8_t)(data >> 24);
+}
+
+static uint32_t sim_crc32(const uint8_t *p, uint32_t n)
+{
+	uint32_t crc = 0xFFFFFFFFUL;
+	uint8_t k;
+
+	while(n--)
+	{
+		crc ^= *p++;
+		for(k=0; k<8; ++k) { crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1))); }
+	}
+	return ~crc;
+}
+
+/* registers with a non-zero reset value (datasheet), the rest reset to 0 */
+static const struct { uint32_t addr, value; } sim_resets[] =
+{
+	{ REG_FREQUENCY, 48000000UL },
+	{ REG_HCYCLE, 548 }, { REG_HOFFSET, 43 }, { REG_HSIZE, 480 }, { REG_HSYNC1, 41 },
+	{ REG_VCYCLE, 292 }, { REG_VOFFSET, 12 }, { REG_VSIZE, 272 }, { REG_VSYNC1, 10 },
+	{ REG_DITHER, 1 }, { REG_CSPREAD, 1 }, { REG_GPIO_DIR, 0x80 },
+	{ REG_PWM_HZ, 250 }, { REG_PWM_DUTY, 128 },
+	{ REG_TOUCH_TRANSFORM_A, 0x10000 }, { REG_TOUCH_TRANSFORM_E, 0x10000 },
+};
+
+static void sim_powerup(FTSIM_t *s)
+{
+	uint8_t i;
+
+	memset(s->mem, 0, FTSIM_MEM_SIZE);
+	memset(s->shown, 0, FT_DL_SIZE);
+	s->mem[REG_ID] = 0x7C;
+	for(i=0; i<sizeof(sim_resets)/sizeof(sim_resets[0]); ++i) { FTSIM_wr32(s, sim_resets[i].addr, sim_resets[i].value); }
+	s->down = 0;
+	s->fault = 0;
+	s->data_cmd = 0;
+	s->cp_wait = 0;
+	memset(s->matrix, 0, sizeof(s->matrix));
+	s->matrix[0] = s->matrix[4] = 65536;
+	s->cp_time = s->now;
+	s->frame_next = s->now + s->cost.frame;
+}
+
+void FTSIM_init(FTSIM_t *s)
+{
+	memset(s, 0, sizeof(FTSIM_t));
+	s->mem = calloc(1, FTSIM_MEM_SIZE);
+	s->shown = calloc(1, FT_DL_SIZE);
+
+	/* 168 MHz host, 21 MHz SPI, 48 MHz FT800 */
+	s->cost.spi_byte = 64;
+	s->cost.spi_select = 120;
+	s->cost.cp_word = 40;
+	s->cost.cp_widget = 8000;
+	s->cost.cp_byte = 20;
+	s->cost.frame = 168000000UL / 60;
+	s->cost.host_hz = 168000000UL;
+
+	sim_powerup(s);
+}
+
+void FTSIM_free(FTSIM_t *s)
+{
+	uint8_t i;
+
+	for(i=0; i<FTSIM_BUSES; ++i)
+	{
+		if(routes[i].sim == s) { routes[i].sim = 0; routes[i].bus = 0; }
+	}
+#ifdef FTSIM_ZLIB
+	if(s->zlib) { inflateEnd((z_stream*)s->zlib); free(s->zlib); }
+#endif
+	free(s->mem);
+	free(s->shown);
+	s->mem = 0;
+	s->shown = 0;
+}
+
+/*** Routing ***********************************************************************/
+void FTSIM_attach(FTSIM_t *s, const void *bus)
+{
+	uint8_t i, free_slot = FTSIM_BUSES;
+
+	for(i=0; i<FTSIM_BUSES; ++i)
+	{
+		if(routes[i].sim && routes[i].bus == bus) { routes[i].sim = s; return; }
+		if(!routes[i].sim && free_slot == FTSIM_BUSES) { free_slot = i; }
+	}
+	if(free_slot < FTSIM_BUSES)
+	{
+		routes[free_slot].bus = bus;
+		routes[free_slot].sim = s;
+	}
+}
+
+FTSIM_t* FTSIM_of(const void *bus)
+{
+	FTSIM_t *any = 0;
+	uint8_t i;
+
+	for(i=0; i<FTSIM_BUSES; ++i)
+	{
+		if(!routes[i].sim) continue;
+		if(routes[i].bus == bus) return routes[i].sim;
+		if(!routes[i].bus) { any = routes[i].sim; }
+	}
+	return any;
+}
+
+/*** Display ***********************************************************************/
+static void sim_frame(FTSIM_t *s)
+{
+	FTSIM_wr32(s, REG_FRAMES, FTSIM_rd32(s, REG_FRAMES) + 1);
+
+	if(s->mem[REG_DLSWAP] == DLSWAP_FRAME || s->mem[REG_DLSWAP] == DLSWAP_LINE)
+	{
+		memcpy(s->shown, &s->mem[RAM_DL], FT_DL_SIZE);
+		s->mem[REG_DLSWAP] = DLSWAP_DONE;
+		++s->stats.swaps;
+	}
+}
+
+/*** Co-processor ******************************************************************/
+static uint32_t fifo_word(const FTSIM_t *s, uint32_t off)
+{
+	return FTSIM_rd32(s, RAM_CMD + (off & FIFO_MASK));
+}
+
+static void cp_busy(FTSIM_t *s, uint32_t cycles)
+{
+	s->cp_time += cycles;
+	s->stats.cp_busy += cycles;
+}
+
+static void dl_word(FTSIM_t *s, uint32_t data)
+{
+	uint32_t dl = FTSIM_rd32(s, REG_CMD_DL);
+
+	FTSIM_wr32(s, RAM_DL + (dl & (FT_DL_SIZE-1)), data);
+	FTSIM_wr32(s, REG_CMD_DL, (dl + 4) & (FT_DL_SIZE-1));
+	++s->stats.dl_words;
+}
+
+/* LOADIMAGE output: one byte pattern per decoded image */
+static void jpeg_done(FTSIM_t *s)
+{
+	uint32_t h = (s->jpeg_hdr[3] << 8) | s->jpeg_hdr[4];
+	uint32_t w = (s->jpeg_hdr[5] << 8) | s->jpeg_hdr[6];
+	uint32_t bpp = (s->jpeg_opts & OPT_MONO) ? 1 : 2;
+	uint32_t size = w*h*bpp;
+
+	if(s->data_ptr + size > RAM_G + 256*1024UL) { s->fault = 1; return; }
+	memset(&s->mem[s->data_ptr], (uint8_t)(s->stats.commands + 1), size);
+	cp_busy(s, size * s->cost.cp_byte / 4);
+}
+
+/* consume inline data, returns the bytes used (multiples of 4) */
+static uint32_t cp_data(FTSIM_t *s, uint32_t rd, uint32_t avail)
+{
+	uint32_t used = 0;
+
+	while(used < avail && s->data_cmd)
+	{
+		uint32_t w = fifo_word(s, rd + used);
+		uint8_t b[4] = { (uint8_t)w, (uint8_t)(w>>8), (uint8_t)(w>>16), (uint8_t)(w>>24) };
+		uint8_t i;
+
+		used += 4;
+		cp_busy(s, 4 * s->cost.cp_byte);
+
+		if(s->data_cmd == CMD_MEMWRITE)
+		{
+			for(i=0; i<4 && s->data_left; ++i, --s->data_left) { s->mem[(s->data_ptr++) & SIM_MASK] = b[i]; }
+			if(!s->data_left) { s->data_cmd = 0; }
+		}
+		else if(s->data_cmd == CMD_LOADIMAGE)
+		{
+			for(i=0; i<4 && s->data_cmd; ++i)
+			{
+				if(s->jpeg_sof)
+				{
+					s->jpeg_hdr[8 - s->jpeg_sof] = b[i];
+					--s->jpeg_sof;
+				}
+				else if(s->jpeg_ff && (b[i] == 0xC0 || b[i] == 0xC1 || b[i] == 0xC2))
+				{
+					s->jpeg_sof = 8;
+				}
+				else if(s->jpeg_ff && b[i] == 0xD9)
+				{
+					s->data_cmd = 0;					// rest of the word is padding
+					jpeg_done(s);
+				}
+				s->jpeg_ff = (b[i] == 0xFF);
+			}
+			s->data_len += 4;
+		}
+#ifdef FTSIM_ZLIB
+		else if(s->data_cmd == CMD_INFLATE)
+		{
+			z_stream *z = (z_stream*)s->zlib;
+			int ret;
+
+			z->next_in = b;
+			z->avail_in = 4;
+			do
+			{
+				z->next_out = &s->mem[s->data_ptr & SIM_MASK];
+				z->avail_out = 4096;
+				ret = inflate(z, Z_NO_FLUSH);
+				s->data_ptr += 4096 - z->avail_out;
+			} while(ret == Z_OK && z->avail_out == 0);
+
+			if(ret == Z_STREAM_END)
+			{
+				inflateEnd(z);
+				s->data_cmd = 0;						// rest of the word is padding
+			}
+			else if(ret != Z_OK && ret != Z_BUF_ERROR)
+			{
+				s->fault = 1;
+				break;
+			}
+		}
+#endif
+		else
+		{
+			s->fault = 1;
+			break;
+		}
+	}
+	return used;
+}
+
+/* sine and cosine of an angle in 1/65536 turns, rounded to 16.16 */
+static void sim_sincos(uint32_t angle, double *sn, double *cs)
+{
+	int32_t a = (int32_t)(angle & 0xFFFF) - ((angle & 0x8000) ? 65536 : 0);
+	double x = a * (6.283185307179586 / 65536.0);
+	double t = x, sum = 0, k;
+
+	for(k=1; k<40; k+=2) { sum += t; t *= -x*x / ((k+1)*(k+2)); }
+	*sn = sum;
+	*cs = 1;
+	t = 1;
+	for(k=0; k<40; k+=2) { t *= -x*x / ((k+1)*(k+2)); *cs += t; }
+
+	*sn = (double)(int64_t)(*sn * 65536 + ((*sn < 0) ? -0.5 : 0.5));
+	*cs = (double)(int64_t)(*cs * 65536 + ((*cs < 0) ? -0.5 : 0.5));
+}
+
+/* matrix coefficient in the 8.8 (a, b, d, e) or 24.8 (c, f) transform format */
+static int32_t sim_coef(double v)
+{
+	int64_t t = (int64_t)(v / 256);
+
+	if((double)t * 256 > v) { --t; }			// floor, like an arithmetic shift
+	return (int32_t)t;
+}
+
+/* the matrix maps screen to bitmap pixels: every command pre-multiplies with
+   the inverse of its own transform */
+static void sim_matrix(FTSIM_t *s, uint32_t c, const uint32_t *a)
+{
+	double *m = s->matrix, r[6], sn, cs;
+	uint8_t i;
+
+	switch(c)
+	{
+		case CMD_LOADIDENTITY:
+			memset(m, 0, sizeof(s->matrix));
+			m[0] = m[4] = 65536;
+			break;
+
+		case CMD_TRANSLATE:
+			m[2] -= (int32_t)a[0];
+			m[5] -= (int32_t)a[1];
+			break;
+
+		case CMD_SCALE:
+			if(!a[0] || !a[1]) break;
+			for(i=0; i<3; ++i) { m[i] = m[i] * 65536 / (int32_t)a[0]; m[3+i] = m[3+i] * 65536 / (int32_t)a[1]; }
+			break;
+
+		case CMD_ROTATE:
+			sim_sincos(a[0], &sn, &cs);
+			memcpy(r, m, sizeof(r));
+			for(i=0; i<3; ++i)
+			{
+				m[i]   = (cs*r[i]   + sn*r[3+i]) / 65536;
+				m[3+i] = (cs*r[3+i] - sn*r[i])   / 65536;
+			}
+			break;
+
+		case CMD_SETMATRIX:
+			dl_word(s, BITMAP_TRANSFORM_A(sim_coef(m[0])));
+			dl_word(s, BITMAP_TRANSFORM_B(sim_coef(m[1])));
+			dl_word(s, BITMAP_TRANSFORM_C(sim_coef(m[2])));
+			dl_word(s, BITMAP_TRANSFORM_D(sim_coef(m[3])));
+			dl_word(s, BITMAP_TRANSFORM_E(sim_coef(m[4])));
+			dl_word(s, BITMAP_TRANSFORM_F(sim_coef(m[5])));
+			break;
+
+		default:
+			break;
+	}
+}
+
+/* execute one command if it is complete, returns its length in bytes */
+static uint32_t cp_command(FTSIM_t *s, uint32_t rd, uint32_t avail)
+{
+	uint32_t c = fifo_word(s, rd);
+	uint32_t a[16];
+	uint8_t args, i;
+	uint32_t len;
+
+	if(!FT_IS_CMD(c))
+	{
+		if((c & 0xFFFFFF00UL) == 0xFFFFFF00UL) { s->fault = 1; return 4; }	// unknown command
+
+		dl_word(s, c);
+		cp_busy(s, s->cost.cp_word);
+		++s->stats.words;
+		return 4;
+	}
+
+	args = FT_cmd_args(c) & FT_ARGS_COUNT;
+	len = 4 + args*4;
+	if(len > avail) return 0;
+	for(i=0; i<args; ++i) { a[i] = fifo_word(s, rd + 4 + i*4); }
+
+	if(FT_cmd_args(c) & FT_ARGS_STRING)
+	{
+		uint32_t w;
+		do
+		{
+			if(len + 4 > avail) return 0;
+			w = fifo_word(s, rd + len);
+			len += 4;
+		} while(!FT_HAS_ZERO(w));
+		cp_busy(s, s->cost.cp_widget);
+	}
+
+	if(s->on_command) { s->on_command(s, c, a); }
+
+	++s->stats.commands;
+	s->stats.words += len/4;
+	cp_busy(s, (len/4) * s->cost.cp_word);
+
+	switch(c)
+	{
+		case CMD_DLSTART:
+			FTSIM_wr32(s, REG_CMD_DL, 0);
+			break;
+
+		case CMD_SWAP:
+			s->mem[REG_DLSWAP] = DLSWAP_FRAME;
+			break;
+
+		case CMD_MEMCRC:
+			FTSIM_wr32(s, RAM_CMD + ((rd + 12) & FIFO_MASK), sim_crc32(&s->mem[a[0] & SIM_MASK], a[1]));
+			cp_busy(s, a[1] * s->cost.cp_byte / 4);
+			break;
+
+		case CMD_REGREAD:
+			FTSIM_wr32(s, RAM_CMD + ((rd + 8) & FIFO_MASK), FTSIM_rd32(s, a[0]));
+			break;
+
+		case CMD_MEMZERO:
+			memset(&s->mem[a[0] & SIM_MASK], 0, a[1]);
+			cp_busy(s, a[1] * s->cost.cp_byte / 4);
+			break;
+
+		case CMD_MEMSET:
+			memset(&s->mem[a[0] & SIM_MASK], (uint8_t)a[1], a[2]);
+			cp_busy(s, a[2] * s->cost.cp_byte / 4);
+			break;
+
+		case CMD_MEMCPY:
+			memmove(&s->mem[a[0] & SIM_MASK], &s->mem[a[1] & SIM_MASK], a[2]);
+			cp_busy(s, a[2] * s->cost.cp_byte / 4);
+			break;
+
+		case CMD_APPEND:
+		{
+			uint32_t k;
+			for(k=0; k<a[1]; k+=4) { dl_word(s, FTSIM_rd32(s, a[0] + k)); }
+			break;
+		}
+
+		case CMD_LOADIDENTITY:
+		case CMD_TRANSLATE:
+		case CMD_SCALE:
+		case CMD_ROTATE:
+		case CMD_SETMATRIX:
+			sim_matrix(s, c, a);
+			break;
+
+		case CMD_GETMATRIX:
+			for(i=0; i<6; ++i) { FTSIM_wr32(s, RAM_CMD + ((rd + 4 + i*4) & FIFO_MASK), (uint32_t)sim_coef(s->matrix[i])); }
+			break;
+
+		case CMD_GETPTR:
+			FTSIM_wr32(s, RAM_CMD + ((rd + 4) & FIFO_MASK), s->data_ptr);
+			break;
+
+		case CMD_CALIBRATE:
+			FTSIM_wr32(s, REG_TOUCH_TRANSFORM_A, 0x10000);
+			FTSIM_wr32(s, REG_TOUCH_TRANSFORM_E, 0x10000);
+			FTSIM_wr32(s, RAM_CMD + ((rd + 4) & FIFO_MASK), 1);
+			break;
+
+		case CMD_MEMWRITE:
+			s->data_cmd = a[1] ? c : 0;
+			s->data_ptr = a[0];
+			s->data_left = a[1];
+			break;
+
+		case CMD_LOADIMAGE:
+			s->data_cmd = c;
+			s->data_ptr = a[0];
+			s->data_len = 0;
+			s->jpeg_ff = 0;
+			s->jpeg_sof = 0;
+			memset(s->jpeg_hdr, 0, sizeof(s->jpeg_hdr));
+			s->jpeg_opts = a[1];
+			break;
+
+		case CMD_INFLATE:
+#ifdef FTSIM_ZLIB
+			if(!s->zlib) { s->zlib = calloc(1, sizeof(z_stream)); }
+			memset(s->zlib, 0, sizeof(z_stream));
+			inflateInit((z_stream*)s->zlib);
+			s->data_cmd = c;
+			s->data_ptr = a[0];
+#else
+			s->fault = 1;
+#endif
+			break;
+
+		default:
+			break;
+	}
+	return len;
+}
+
+/* run the co-processor up to time t. REG_CMD_READ moves past a command when
+   it has been executed, so it points at the command in progress */
+static void cp_run(FTSIM_t *s, uint64_t t)
+{
+	uint32_t rd, wr;
+
+	if(s->fault) return;
+	if(s->cp_wait)
+	{
+		if(s->cp_time > t) return;
+		FTSIM_wr32(s, REG_CMD_READ, s->cp_next);
+		s->cp_wait = 0;
+	}
+
+	rd = FTSIM_rd32(s, REG_CMD_READ) & FIFO_MASK;
+	wr = FTSIM_rd32(s, REG_CMD_WRITE) & FIFO_MASK;
+	if(s->cp_time < t && rd == wr) { s->cp_time = t; }
+
+	while(rd != wr && s->cp_time <= t)
+	{
+		uint32_t avail = (wr - rd) & FIFO_MASK;
+		uint32_t used = s->data_cmd ? cp_data(s, rd, avail) : cp_command(s, rd, avail);
+
+		if(s->fault)
+		{
+			FTSIM_wr32(s, REG_CMD_READ, 0xFFF);
+			return;
+		}
+		if(!used)
+		{
+			if(s->cp_time < t) { s->cp_time = t; }		// waiting for the rest of the command
+			break;
+		}
+
+		rd = (rd + used) & FIFO_MASK;
+		if(s->cp_time > t)
+		{
+			s->cp_next = rd;
+			s->cp_wait = 1;
+			return;
+		}
+		FTSIM_wr32(s, REG_CMD_READ, rd);
+	}
+}
+
+/*
+    Function: FTSIM_run
+    ARGS:     s: model
+
+    Description: Runs the co-processor and the display frames up to s->now,
+                 in time order, so a swap requested before a frame shows on
+                 that frame. Called at every chip select, so register reads
+                 see the state at that time.
+*/
+void FTSIM_run(FTSIM_t *s)
+{
+	while(s->now >= s->frame_next)
+	{
+		cp_run(s, s->frame_next);
+		sim_frame(s);
+		s->frame_next += s->cost.frame;
+	}
+	cp_run(s, s->now);
+	FTSIM_wr32(s, REG_CLOCK, (uint32_t)((s->now / s->cost.host_hz) * 48000000ULL + (s->now % s->cost.host_hz) * 48000000ULL / s->cost.host_hz));
+}
+
+void FTSIM_idle(FTSIM_t *s, uint32_t cycles)
+{
+	s->now += cycles;
+	FTSIM_run(s);
+}
+
+/*** SPI ***************************************************************************/
+void FTSIM_select(const void *bus)
+{
+	FTSIM_t *s = FTSIM_of(bus);
+
+	if(!s) return;
+	s->now += s->cost.spi_select;
+	FTSIM_run(s);
+	s->pos = 0;
+	++s->stats.transactions;
+}
+
+uint8_t FTSIM_xfer(const void *bus, uint8_t data)
+{
+	FTSIM_t *s = FTSIM_of(bus);
+	uint8_t out = 0;
+
+	if(!s) return 0;
+	s->now += s->cost.spi_byte;
+	++s->stats.bytes;
+
+	if(s->pos < 3)
+	{
+		s->first[s->pos] = data;
+		if(s->pos == 0)
+		{
+			s->mode = ((data & 0xC0) == 0x80) ? MODE_WRITE : (((data & 0xC0) == 0x40) ? MODE_HOST : MODE_READ);
+			s->addr = (uint32_t)(data & 0x3F) << 16;
+		}
+		else if(s->pos == 1) { s->addr |= (uint32_t)data << 8; }
+		else                 { s->addr |= data; }
+	}
+	else if(s->mode == MODE_WRITE)
+	{
+		uint32_t a = s->addr++ & SIM_MASK;
+
+		s->mem[a] = data;
+		if(a == REG_CPURESET && (data & 1))
+		{
+			FTSIM_wr32(s, REG_CMD_READ, 0);
+			FTSIM_wr32(s, REG_CMD_WRITE, 0);
+			s->fault = 0;
+			s->data_cmd = 0;
+			s->cp_wait = 0;
+		}
+	}
+	else if(s->mode == MODE_READ && s->pos > 3)
+	{
+		out = s->mem[s->addr++ & SIM_MASK];
+	}
+
+	++s->pos;
+	return out;
+}
+
+void FTSIM_deselect(const void *bus)
+{
+	FTSIM_t *s = FTSIM_of(bus);
+
+	if(!s) return;
+	if(s->pos == 3 && (s->mode == MODE_HOST || (s->mode == MODE_READ && !s->first[0] && !s->first[1] && !s->first[2])))
+	{
+		s->host_cmd = (s->mode == MODE_HOST) ? s->first[0] : CMD_ACTIVE;
+		++s->stats.host_cmds;
+		if(s->host_cmd == CMD_PWRDOWN)
+		{
+			sim_powerup(s);						// registers and RAM are lost
+			s->mem[REG_ID] = 0;
+			s->down = 1;
+		}
+		else if(s->host_cmd == CMD_ACTIVE && s->down)
+		{
+			s->mem[REG_ID] = 0x7C;
+			s->down = 0;
+		}
+		if(s->on_host) { s->on_host(s, s->host_cmd); }
+	}
+}
+
+void FTSIM_pdn(const void *bus, uint8_t level)
+{
+	FTSIM_t *s = FTSIM_of(bus);
+
+	if(s && !level) { sim_powerup(s); }
+}
@@ -0,0 +1,104 @@
+#ifndef FTSIM_H
+#define FTSIM_H
+
+/* FT800 model (host)
+ * Decodes SPI transactions into memory accesses and host commands, runs the
+ * co-processor FIFO (display list words, DLSTART/SWAP, memory and result
+ * commands, inline data), the display frame counter and REG_CLOCK. Time is
+ * counted in host cycles with a configurable cost model, so a PC can measure
+ * how long a workload would keep the bus and the co-processor busy.
+ *
+ * The library talks to the model when it is built with FT_SIM defined
+ * (see spi.h), e.g.
+ *   gcc -DFT_SIM -I. -Itests -Itools ... tools/ftsim.c tests/stm32_mock.c ft800.c
+ *
+ * The matrix commands compose exactly with 16.16 sine/cosine values;
+ * CMD_SETMATRIX and CMD_GETMATRIX truncate to the 8.8 transform format.
+ * CMD_LOADIMAGE fills the output with a byte pattern (it doesn't decode the
+ * JPEG). CMD_INFLATE needs zlib: build with -DFTSIM_ZLIB ... -lz, without it
+ * an inflate stops the co-processor like a corrupt stream would.
+ */
+
+#include <stdint.h>
+
+#define FTSIM_MEM_SIZE      (4UL*1024*1024)     /* 22 bit address space */
+#define FTSIM_BUSES         4                   /* models that can be attached at once */
+
+typedef struct
+{
+	uint32_t spi_byte;			/* host cycles per SPI byte */
+	uint32_t spi_select;		/* host cycles per transaction (chip select, call overhead) */
+	uint32_t cp_word;			/* co-processor cycles (in host cycles) per FIFO word */
+	uint32_t cp_widget;			/* extra co-processor cycles per widget (text, button, ...) */
+	uint32_t cp_byte;			/* extra co-processor cycles per inline data byte */
+	uint32_t frame;				/* host cycles per display frame */
+	uint32_t host_hz;			/* host cycles per second (REG_CLOCK counts 48 MHz ticks) */
+} FTSIM_Cost_t;
+
+typedef struct
+{
+	uint64_t transactions;		/* SPI transactions */
+	uint64_t bytes;				/* SPI bytes */
+	uint64_t host_cmds;			/* host commands (ACTIVE, STANDBY, ...) */
+	uint64_t words;				/* FIFO words executed */
+	uint64_t commands;			/* co-processor commands executed */
+	uint64_t dl_words;			/* display list words written through the FIFO */
+	uint64_t swaps;				/* display lists made visible */
+	uint64_t cp_busy;			/* co-processor busy cycles */
+} FTSIM_Stats_t;
+
+typedef struct FTSIM
+{
+	uint8_t *mem;				/* FT800 address space (FTSIM_MEM_SIZE bytes) */
+	uint32_t *shown;			/* display list on screen (copied from RAM_DL on swap) */
+	FTSIM_Cost_t cost;
+	FTSIM_Stats_t stats;
+	uint64_t now;				/* host cycles */
+	uint64_t cp_time;			/* co-processor is busy until this time */
+	uint64_t frame_next;		/* time of the next display frame */
+	uint8_t  fault;				/* co-processor stopped (REG_CMD_READ = 0xFFF) */
+	uint8_t  cp_wait;			/* a command is executing until cp_time */
+	uint32_t cp_next;			/* REG_CMD_READ after it */
+	uint8_t  host_cmd;			/* last host command */
+	uint8_t  down;				/* PWRDOWN: memory cleared, REG_ID reads 0 until CMD_ACTIVE */
+
+	/* SPI transaction being decoded */
+	uint32_t pos;
+	uint32_t addr;
+	uint8_t  mode;
+	uint8_t  first[3];
+
+	/* inline data of the command being executed */
+	uint32_t data_cmd;			/* 0: none */
+	uint32_t data_ptr;
+	uint32_t data_left;
+	uint32_t data_len;			/* bytes consumed so far */
+	uint8_t  jpeg_ff;			/* LOADIMAGE: last byte was 0xFF */
+	uint8_t  jpeg_sof;			/* LOADIMAGE: SOF header bytes still to collect */
+	uint8_t  jpeg_hdr[8];		/* LOADIMAGE: SOF length, precision, height, width, components */
+	uint32_t jpeg_opts;
+	void    *zlib;				/* INFLATE: decompressor state (FTSIM_ZLIB) */
+
+	double   matrix[6];			/* co-processor matrix a..f, 16.16 units, exact */
+
+	void (*on_command)(struct FTSIM *s, uint32_t cmd, const uint32_t *args);	/* called before a command runs */
+	void (*on_host)(struct FTSIM *s, uint8_t cmd);	/* called after a host command */
+	void *user;
+} FTSIM_t;
+
+void FTSIM_init(FTSIM_t *s);						/* power up, default cost model */
+void FTSIM_free(FTSIM_t *s);
+void FTSIM_attach(FTSIM_t *s, const void *bus);	/* route an SPI bus to s (NULL: all buses not attached otherwise) */
+void FTSIM_idle(FTSIM_t *s, uint32_t cycles);		/* host time passes without bus traffic */
+void FTSIM_run(FTSIM_t *s);						/* co-processor and display catch up with s->now */
+uint32_t FTSIM_rd32(const FTSIM_t *s, uint32_t addr);
+void FTSIM_wr32(FTSIM_t *s, uint32_t addr, uint32_t data);
+FTSIM_t* FTSIM_of(const void *bus);				/* model attached to a bus */
+
+/* SPI side, called by spi.h with FT_SIM defined */
+void FTSIM_select(const void *bus);
+uint8_t FTSIM_xfer(const void *bus, uint8_t data);
+void FTSIM_deselect(const void *bus);
+void FTSIM_pdn(const void *bus, uint8_t level);
+
+#endif
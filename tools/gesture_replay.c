@@ -0,0 +1,70 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    gesture_replay.c
+  * @brief   Gesture replay (host tool)
+  *          Runs recorded touch samples through the gesture recognizer of
+  *          gesture.c and prints the events, to tune the GESTURE_x limits
+  *          without hardware.
+  *
+  *          Build: gcc -O2 -o gesture_replay gesture_replay.c ../gesture.c
+  *          Usage: gesture_replay [samples.csv]   (default: stdin)
+  *
+  *          One sample per line: ms,touched,x,y (e.g. logged from
+  *          TOUCH_State_t once per frame). Lines starting with # are skipped.
+  *          tests/gestures.csv holds recorded streams to start from.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../gesture.h"
+
+static const char *names[] = { "none", "down", "tap", "long", "drag", "swipe", "up" };
+
+int main(int argc, char **argv)
+{
+	FILE *in = stdin;
+	GESTURE_t g;
+	char line[128];
+	unsigned long n = 0, count[7] = { 0 };
+
+	if(argc > 1)
+	{
+		in = fopen(argv[1], "r");
+		if(!in) { perror(argv[1]); return 1; }
+	}
+
+	GESTURE_init(&g);
+
+	while(fgets(line, sizeof(line), in))
+	{
+		unsigned long ms;
+		int touched, x, y;
+		uint8_t ev;
+
+		if(line[0] == '#') continue;
+		if(sscanf(line, "%lu,%d,%d,%d", &ms, &touched, &x, &y) != 4) continue;
+
+		++n;
+		ev = GESTURE_update(&g, (uint8_t)(touched != 0), (int16_t)x, (int16_t)y, (uint32_t)ms);
+		if(ev == GESTURE_NONE) continue;
+
+		++count[ev];
+		printf("%8lu %-5s x=%4d y=%4d", ms, names[ev], g.x, g.y);
+		if(ev == GESTURE_DRAG)      printf(" dx=%4d dy=%4d", g.dx, g.dy);
+		if(ev == GESTURE_SWIPE_END) printf(" vx=%5ld vy=%5ld px/s", (long)g.vx, (long)g.vy);
+		if(ev == GESTURE_TAP || ev == GESTURE_UP || ev == GESTURE_SWIPE_END) printf(" held=%lu ms", (unsigned long)(g.t - g.t0));
+		printf("\n");
+	}
+	if(in != stdin) fclose(in);
+
+	printf("%lu samples: %lu taps, %lu long, %lu drags, %lu swipes\n", n,
+	       count[GESTURE_TAP], count[GESTURE_LONG], count[GESTURE_DRAG], count[GESTURE_SWIPE_END]);
+	return 0;
+}
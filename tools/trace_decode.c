@@ -0,0 +1,488 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    trace_decode.c
+  * @brief   SPI trace decoder (host tool)
+  *          Decodes a dump made with TRACE_dump() into readable HOST_MEM_x
+  *          and cmd() calls. With -r the transactions are also replayed
+  *          into the FT800 model (ftsim.c) at their recorded times, and the
+  *          model's view (co-processor state, display list on screen) is
+  *          printed at the end.
+  *
+  *          Build: gcc -O2 -o trace_decode trace_decode.c ftsim.c
+  *                 add -DTRACE_ZLIB -DFTSIM_ZLIB ... -lz to follow CMD_INFLATE data
+  *          Usage: trace_decode [-r] <dump.bin> [cpu clock in MHz, default 168]
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../ft800.h"
+#include "../trace.h"
+#include "ftsim.h"
+
+#ifdef TRACE_ZLIB
+#include <zlib.h>
+#endif
+
+typedef struct
+{
+	uint32_t value;
+	const char *name;
+} Name_t;
+
+#define N(x) { x, #x }
+
+static const Name_t host_cmds[] =
+{
+	N(CMD_ACTIVE), N(CMD_STANDBY), N(CMD_SLEEP), N(CMD_PWRDOWN),
+	N(CMD_CLKINT), N(CMD_CLKEXT), N(CMD_CLK48M), N(CMD_CLK36M), N(CMD_CORERST),
+	{ 0, NULL }
+};
+
+static const Name_t regs[] =
+{
+	N(REG_ID), N(REG_FRAMES), N(REG_CLOCK), N(REG_FREQUENCY), N(REG_CPURESET),
+	N(REG_HCYCLE), N(REG_HOFFSET), N(REG_HSIZE), N(REG_HSYNC0), N(REG_HSYNC1),
+	N(REG_VCYCLE), N(REG_VOFFSET), N(REG_VSIZE), N(REG_VSYNC0), N(REG_VSYNC1),
+	N(REG_DLSWAP), N(REG_ROTATE), N(REG_OUTBITS), N(REG_DITHER), N(REG_SWIZZLE),
+	N(REG_CSPREAD), N(REG_PCLK_POL), N(REG_PCLK), N(REG_TAG_X), N(REG_TAG_Y), N(REG_TAG),
+	N(REG_VOL_PB), N(REG_VOL_SOUND), N(REG_SOUND), N(REG_PLAY), N(REG_GPIO_DIR), N(REG_GPIO),
+	N(REG_INT_FLAGS), N(REG_INT_EN), N(REG_INT_MASK), N(REG_PLAYBACK_START),
+	N(REG_PLAYBACK_LENGTH), N(REG_PLAYBACK_READPTR), N(REG_PLAYBACK_FREQ),
+	N(REG_PLAYBACK_FORMAT), N(REG_PLAYBACK_LOOP), N(REG_PLAYBACK_PLAY),
+	N(REG_PWM_HZ), N(REG_PWM_DUTY), N(REG_MACRO_0), N(REG_MACRO_1),
+	N(REG_CMD_READ), N(REG_CMD_WRITE), N(REG_CMD_DL),
+	N(REG_TOUCH_MODE), N(REG_TOUCH_ADC_MODE), N(REG_TOUCH_CHARGE), N(REG_TOUCH_SETTLE),
+	N(REG_TOUCH_OVERSAMPLE), N(REG_TOUCH_RZTHRESH), N(REG_TOUCH_RAW_XY), N(REG_TOUCH_RZ),
+	N(REG_TOUCH_SCREEN_XY), N(REG_TOUCH_TAG_XY), N(REG_TOUCH_TAG),
+	N(REG_TOUCH_TRANSFORM_A), N(REG_TOUCH_TRANSFORM_B), N(REG_TOUCH_TRANSFORM_C),
+	N(REG_TOUCH_TRANSFORM_D), N(REG_TOUCH_TRANSFORM_E), N(REG_TOUCH_TRANSFORM_F),
+	N(REG_TRACKER), N(REG_SNAPSHOT), N(REG_SNAPY),
+	{ 0, NULL }
+};
+
+/* what follows the arguments of a command */
+#define TAIL_NONE       0
+#define TAIL_STRING     1		/* NUL-terminated string */
+#define TAIL_MEMWRITE   2		/* last argument bytes of data */
+#define TAIL_JPEG       3		/* JPEG file, ends with FF D9 */
+#define TAIL_ZLIB       4		/* zlib stream */
+
+/* co-processor commands, their arguments come from FT_cmd_args() of ft800.h */
+static const Name_t cmds[] =
+{
+	N(CMD_APPEND), N(CMD_BGCOLOR), N(CMD_BITMAP_TRANSFORM), N(CMD_BUTTON),
+	N(CMD_CALIBRATE), N(CMD_CLOCK), N(CMD_COLDSTART), N(CMD_CRC), N(CMD_DIAL),
+	N(CMD_DLSTART), N(CMD_EXECUTE), N(CMD_FGCOLOR), N(CMD_GAUGE), N(CMD_GETMATRIX),
+	N(CMD_GETPOINT), N(CMD_GETPROPS), N(CMD_GETPTR), N(CMD_GRADCOLOR),
+	N(CMD_GRADIENT), N(CMD_HAMMERAUX), N(CMD_IDCT), N(CMD_INFLATE),
+	N(CMD_INTERRUPT), N(CMD_KEYS), N(CMD_LOADIDENTITY), N(CMD_LOADIMAGE),
+	N(CMD_LOGO), N(CMD_MARCH), N(CMD_MEMCPY), N(CMD_MEMCRC), N(CMD_MEMSET),
+	N(CMD_MEMWRITE), N(CMD_MEMZERO), N(CMD_NUMBER), N(CMD_PROGRESS),
+	N(CMD_REGREAD), N(CMD_ROTATE), N(CMD_SCALE), N(CMD_SCREENSAVER),
+	N(CMD_SCROLLBAR), N(CMD_SETFONT), N(CMD_SETMATRIX), N(CMD_SKETCH),
+	N(CMD_SLIDER), N(CMD_SNAPSHOT), N(CMD_SPINNER), N(CMD_STOP), N(CMD_SWAP),
+	N(CMD_TEXT), N(CMD_TOGGLE), N(CMD_TOUCH_TRANSFORM), N(CMD_TRACK),
+	N(CMD_TRANSLATE),
+	{ 0, NULL }
+};
+
+/* TAIL_x of a command: FT_ARGS_STRING, or the kind of its FT_ARGS_DATA */
+static uint8_t cmd_tail_of(uint32_t c)
+{
+	uint8_t flags = FT_cmd_args(c);
+
+	if(flags & FT_ARGS_STRING) return TAIL_STRING;
+	if(!(flags & FT_ARGS_DATA)) return TAIL_NONE;
+	if(c == CMD_MEMWRITE)       return TAIL_MEMWRITE;
+	if(c == CMD_LOADIMAGE)      return TAIL_JPEG;
+	return TAIL_ZLIB;
+}
+
+/* parser state of the FIFO data, kept across transactions */
+static uint8_t  cmd_args;			/* argument words still expected by the last command */
+static uint8_t  cmd_tail;			/* TAIL_x of the last command, once its arguments are done */
+static uint32_t cmd_data;			/* TAIL_MEMWRITE: data bytes still expected (padded to words) */
+static uint32_t cmd_data_len;		/* inline data bytes skipped so far */
+static uint8_t  cmd_jpeg_ff;		/* TAIL_JPEG: last byte was FF */
+#ifdef TRACE_ZLIB
+static z_stream cmd_zlib;
+#endif
+
+/* display list instructions by opcode (bits 31:24) */
+static const char *dl_ops[] =
+{
+	"DISPLAY", "BITMAP_SOURCE", "CLEAR_COLOR_RGB", "TAG", "COLOR_RGB", "BITMAP_HANDLE",
+	"CELL", "BITMAP_LAYOUT", "BITMAP_SIZE", "ALPHA_FUNC", "STENCIL_FUNC", "BLEND_FUNC",
+	"STENCIL_OP", "POINT_SIZE", "LINE_WIDTH", "CLEAR_COLOR_A", "COLOR_A", "CLEAR_STENCIL",
+	"CLEAR_TAG", "STENCIL_MASK", "TAG_MASK", "BITMAP_TRANSFORM_A", "BITMAP_TRANSFORM_B",
+	"BITMAP_TRANSFORM_C", "BITMAP_TRANSFORM_D", "BITMAP_TRANSFORM_E", "BITMAP_TRANSFORM_F",
+	"SCISSOR_XY", "SCISSOR_SIZE", "CALL", "JUMP", "BEGIN", "COLOR_MASK", "END",
+	"SAVE_CONTEXT", "RESTORE_CONTEXT", "RETURN", "MACRO", "CLEAR"
+};
+
+static const char *lookup(const Name_t *table, uint32_t value)
+{
+	for(; table->name; ++table)
+	{
+		if(table->value == value) return table->name;
+	}
+	return NULL;
+}
+
+static uint32_t le(const uint8_t *p, uint32_t len)
+{
+	uint32_t v = 0;
+	while(len--) v = (v<<8) | p[len];
+	return v;
+}
+
+static void print_addr(uint32_t addr)
+{
+	const char *name = lookup(regs, addr);
+
+	if(name)                                     printf("%s", name);
+	else if(addr >= RAM_CMD && addr < RAM_CMD+4096) printf("RAM_CMD+%u", (unsigned)(addr-RAM_CMD));
+	else if(addr >= RAM_DL && addr < RAM_DL+8192)   printf("RAM_DL+%u", (unsigned)(addr-RAM_DL));
+	else if(addr >= RAM_PAL && addr < RAM_REG)      printf("RAM_PAL+%u", (unsigned)(addr-RAM_PAL));
+	else                                         printf("0x%06X", (unsigned)addr);
+}
+
+static void print_dl_word(uint32_t w)
+{
+	if((w>>30) == 1)                     printf("    cmd(VERTEX2F(%d,%d))\n", (int)((w>>15)&0x7FFF), (int)(w&0x7FFF));
+	else if((w>>30) == 2)                printf("    cmd(VERTEX2II(%u,%u,%u,%u))\n", (unsigned)((w>>21)&511), (unsigned)((w>>12)&511), (unsigned)((w>>7)&31), (unsigned)(w&127));
+	else if(w && (w>>24) < sizeof(dl_ops)/sizeof(dl_ops[0]))
+	                                     printf("    cmd(%s 0x%06X)\n", dl_ops[w>>24], (unsigned)(w&0xFFFFFF));
+	else if(!w)                          printf("    cmd(DISPLAY)\n");
+	else                                 printf("    cmd(0x%08X)\n", (unsigned)w);
+}
+
+/* inline data of MEMWRITE / LOADIMAGE / INFLATE, returns the bytes used (whole words) */
+static uint32_t skip_data(const uint8_t *p, uint32_t len)
+{
+	uint32_t n = 0;
+
+	if(cmd_tail == TAIL_MEMWRITE)
+	{
+		n = (cmd_data < len) ? cmd_data : len;
+		cmd_data -= n;
+		if(!cmd_data) cmd_tail = TAIL_NONE;
+	}
+	else if(cmd_tail == TAIL_JPEG)
+	{
+		while(n < len && cmd_tail)
+		{
+			if(cmd_jpeg_ff && p[n] == 0xD9) cmd_tail = TAIL_NONE;
+			cmd_jpeg_ff = (p[n] == 0xFF);
+			++n;
+		}
+	}
+	else if(cmd_tail == TAIL_ZLIB)
+	{
+#ifdef TRACE_ZLIB
+		uint8_t out[4096];
+		int ret;
+
+		cmd_zlib.next_in = (uint8_t*)p;
+		cmd_zlib.avail_in = len;
+		do
+		{
+			cmd_zlib.next_out = out;
+			cmd_zlib.avail_out = sizeof(out);
+			ret = inflate(&cmd_zlib, Z_NO_FLUSH);
+		} while(ret == Z_OK && cmd_zlib.avail_in);
+
+		n = len - cmd_zlib.avail_in;
+		if(ret != Z_OK)
+		{
+			if(ret != Z_STREAM_END) printf("      (corrupt zlib data)\n");
+			inflateEnd(&cmd_zlib);
+			cmd_tail = TAIL_NONE;
+		}
+#else
+		/* the end of a deflate stream can't be found without inflating it:
+		   treat the rest of this transaction as data */
+		n = len;
+		cmd_tail = TAIL_NONE;
+		printf("      (end of zlib data unknown, build with -DTRACE_ZLIB)\n");
+#endif
+	}
+
+	if(!cmd_tail) n = (n + 3) & ~3UL;		// data is padded to whole words
+	if(n > len) n = len;
+	cmd_data_len += n;
+	if(!cmd_tail) printf("      data %u bytes\n", (unsigned)cmd_data_len);
+	return n;
+}
+
+/* co-processor words: commands with their arguments, display list instructions or raw data */
+static void print_cmd_words(const uint8_t *p, uint32_t len)
+{
+	uint32_t i = 0;
+
+	while(i+4 <= len)
+	{
+		uint32_t w = le(p+i, 4);
+		const char *name;
+
+		if(cmd_args)
+		{
+			printf("      arg 0x%08X (%d, %d)\n", (unsigned)w, (int16_t)(w&0xFFFF), (int16_t)(w>>16));
+			i += 4;
+			if(!--cmd_args && cmd_tail == TAIL_MEMWRITE) cmd_data = (w + 3) & ~3UL;
+			if(!cmd_args && cmd_tail == TAIL_MEMWRITE && !cmd_data) cmd_tail = TAIL_NONE;
+			continue;
+		}
+		if(cmd_tail == TAIL_STRING)
+		{
+			uint8_t j;
+			printf("      str \"");
+			for(j=0; j<4 && p[i+j]; ++j) putchar(p[i+j]);
+			printf("\"\n");
+			if(j < 4) cmd_tail = TAIL_NONE;
+			i += 4;
+			continue;
+		}
+		if(cmd_tail)
+		{
+			i += skip_data(p+i, len-i);
+			continue;
+		}
+
+		i += 4;
+		name = lookup(cmds, w);
+		if(name)
+		{
+			printf("    cmd(%s)\n", name);
+			cmd_args = FT_cmd_args(w) & FT_ARGS_COUNT;
+			cmd_tail = cmd_tail_of(w);
+			cmd_data = 0;
+			cmd_data_len = 0;
+			cmd_jpeg_ff = 0;
+#ifdef TRACE_ZLIB
+			if(cmd_tail == TAIL_ZLIB)
+			{
+				memset(&cmd_zlib, 0, sizeof(cmd_zlib));
+				inflateInit(&cmd_zlib);
+			}
+#endif
+		}
+		else print_dl_word(w);
+	}
+}
+
+static void decode(const uint8_t *p, uint32_t len, uint8_t truncated)
+{
+	uint32_t addr;
+	const char *name;
+
+	if(len == 3 && p[0] == 0 && p[1] == 0 && p[2] == 0)
+	{
+		printf("HOST_CMD_ACTIVE()\n");
+		return;
+	}
+	if(len < 3)
+	{
+		printf("?? short transaction (%u bytes)\n", (unsigned)len);
+		return;
+	}
+
+	addr = ((uint32_t)(p[0]&0x3F)<<16) | ((uint32_t)p[1]<<8) | p[2];
+
+	switch(p[0] & 0xC0)
+	{
+		case 0x40:
+			name = lookup(host_cmds, p[0] & 0x7F);
+			if(name) printf("HOST_CMD_WRITE(%s)\n", name);
+			else     printf("HOST_CMD_WRITE(0x%02X)\n", p[0] & 0x3F);
+			break;
+
+		case 0x80:
+			p += 3; len -= 3;
+			if(len == 1 || len == 2 || len == 4)
+			{
+				printf("HOST_MEM_WR%u(", (unsigned)(len*8));
+				print_addr(addr);
+				printf(", 0x%X)\n", (unsigned)le(p, len));
+			}
+			else
+			{
+				printf("HOST_MEM_WR_STR(");
+				print_addr(addr);
+				printf(", %u bytes%s)\n", (unsigned)len, truncated ? ", truncated" : "");
+			}
+			if(addr >= RAM_CMD && addr < RAM_CMD+4096) print_cmd_words(p, len);
+			break;
+
+		case 0x00:
+			p += 4; len = (len > 4) ? len-4 : 0;
+			if(len == 1 || len == 2 || len == 4)
+			{
+				printf("HOST_MEM_RD%u(", (unsigned)(len*8));
+				print_addr(addr);
+				printf(") = 0x%X\n", (unsigned)le(p, len));
+			}
+			else
+			{
+				printf("HOST_MEM_READ_STR(");
+				print_addr(addr);
+				printf(", %u bytes%s)\n", (unsigned)len, truncated ? ", truncated" : "");
+			}
+			break;
+
+		default:
+			printf("?? invalid transaction 0x%02X\n", p[0]);
+			break;
+	}
+}
+
+/*** Replay ************************************************************************/
+static FTSIM_t sim;
+static unsigned long replay_truncated;
+
+static void replay_start(const uint8_t *buf, long size, double mhz)
+{
+	long pos = 0;
+	double k = mhz / 168.0;			// the cost model is in cycles of a 168 MHz host
+
+	FTSIM_init(&sim);
+	FTSIM_attach(&sim, NULL);
+	sim.cost.spi_byte = 0;			// time comes from the timestamps
+	sim.cost.spi_select = 0;
+	sim.cost.cp_word = (uint32_t)(sim.cost.cp_word * k);
+	sim.cost.cp_widget = (uint32_t)(sim.cost.cp_widget * k);
+	sim.cost.cp_byte = (uint32_t)(sim.cost.cp_byte * k);
+	sim.cost.frame = (uint32_t)(sim.cost.frame * k);
+	sim.frame_next = sim.cost.frame;
+
+	/* a dump usually starts in the middle of a session: start the model's
+	   FIFO at the first RAM_CMD write of the dump */
+	while(pos + TRACE_HEADER <= size)
+	{
+		const uint8_t *p = buf + pos + TRACE_HEADER;
+		uint32_t len = le(buf+pos+5, 2) & ~TRACE_TRUNCATED;
+		uint32_t addr = ((uint32_t)(p[0]&0x3F)<<16) | ((uint32_t)p[1]<<8) | p[2];
+
+		if(len > 3 && (p[0] & 0xC0) == 0x80 && addr >= RAM_CMD && addr < RAM_CMD+4096)
+		{
+			FTSIM_wr32(&sim, REG_CMD_READ, addr - RAM_CMD);
+			FTSIM_wr32(&sim, REG_CMD_WRITE, addr - RAM_CMD);
+			break;
+		}
+		pos += TRACE_HEADER + len;
+	}
+}
+
+static void replay(uint64_t t, const uint8_t *p, uint32_t len, uint8_t truncated)
+{
+	uint32_t i;
+
+	if(t > sim.now) sim.now = t;
+	FTSIM_select(NULL);
+	for(i=0; i<len; ++i) FTSIM_xfer(NULL, p[i]);
+	FTSIM_deselect(NULL);
+	if(truncated) ++replay_truncated;
+}
+
+static void replay_report(void)
+{
+	uint32_t rd, wr, i;
+
+	FTSIM_idle(&sim, sim.cost.frame);		// let the co-processor finish and the last swap happen
+
+	rd = FTSIM_rd32(&sim, REG_CMD_READ);
+	wr = FTSIM_rd32(&sim, REG_CMD_WRITE);
+
+	printf("\nreplay: %llu commands, %llu display list words, %llu swaps, co-processor busy %.1f%%\n",
+	       (unsigned long long)sim.stats.commands, (unsigned long long)sim.stats.dl_words,
+	       (unsigned long long)sim.stats.swaps, sim.now ? 100.0*sim.stats.cp_busy/sim.now : 0.0);
+	if(sim.fault)         printf("replay: co-processor fault (REG_CMD_READ = 0xFFF)\n");
+	else if(rd != wr)     printf("replay: %u FIFO bytes not executed (incomplete command)\n", (unsigned)((wr-rd) & 4095));
+	if(replay_truncated)  printf("replay: %lu truncated transactions, the model may be off\n", replay_truncated);
+
+	printf("display list on screen:\n");
+	for(i=0; i<FT_DL_SIZE/4; ++i)
+	{
+		print_dl_word(sim.shown[i]);
+		if(!sim.shown[i]) break;			// DISPLAY
+	}
+	FTSIM_free(&sim);
+}
+
+int main(int argc, char **argv)
+{
+	FILE *f;
+	uint8_t *buf;
+	long size, pos = 0;
+	double mhz = 168.0;
+	uint32_t first = 0, prev = 0;
+	uint64_t t = 0;
+	unsigned long count = 0, bytes = 0;
+	uint8_t replay_on = 0;
+
+	if(argc > 1 && !strcmp(argv[1], "-r"))
+	{
+		replay_on = 1;
+		--argc;
+		++argv;
+	}
+	if(argc < 2)
+	{
+		fprintf(stderr, "usage: trace_decode [-r] <dump.bin> [cpu MHz]\n");
+		return 1;
+	}
+	if(argc > 2) mhz = atof(argv[2]);
+
+	f = fopen(argv[1], "rb");
+	if(!f) { perror(argv[1]); return 1; }
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	buf = malloc(size ? size : 1);
+	if(!buf || fread(buf, 1, size, f) != (size_t)size) { fprintf(stderr, "read error\n"); return 1; }
+	fclose(f);
+
+	if(replay_on) replay_start(buf, size, mhz);
+
+	while(pos + TRACE_HEADER <= size)
+	{
+		uint32_t ts, len;
+		uint16_t raw;
+
+		if(buf[pos] != TRACE_SYNC)
+		{
+			fprintf(stderr, "lost sync at offset %ld\n", pos);
+			break;
+		}
+
+		ts  = le(buf+pos+1, 4);
+		raw = (uint16_t)le(buf+pos+5, 2);
+		len = raw & ~TRACE_TRUNCATED;
+		if(pos + TRACE_HEADER + (long)len > size) break;
+
+		if(!count) first = prev = ts;
+		t += (uint32_t)(ts-prev);
+		printf("%10.2f us (+%8.2f) ", (uint32_t)(ts-first)/mhz, (uint32_t)(ts-prev)/mhz);
+		decode(buf+pos+TRACE_HEADER, len, (raw & TRACE_TRUNCATED) != 0);
+		if(replay_on) replay(t, buf+pos+TRACE_HEADER, len, (raw & TRACE_TRUNCATED) != 0);
+
+		prev = ts;
+		++count;
+		bytes += len;
+		pos += TRACE_HEADER + len;
+	}
+
+	printf("%lu transactions, %lu bytes\n", count, bytes);
+	if(replay_on) replay_report();
+	free(buf);
+	return 0;
+}
@@ -0,0 +1,109 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    touch.c
+  * @brief   Touch calibration and input
+  *          This file contains functions to save and restore the touch
+  *          calibration matrix and to read the touch state in one SPI
+  *          transaction per frame.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include "stm32f4xx.h"
+#include "ft800.h"
+#include "touch.h"
+
+static uint32_t touch_check(const TOUCH_Calib_t *c)
+{
+	uint32_t sum = c->magic;
+	uint8_t i;
+
+	for(i=0; i<6; ++i) { sum = ((sum << 5) | (sum >> 27)) ^ c->transform[i]; }
+	return ~sum;
+}
+
+/*** Calibration *******************************************************************/
+void TOUCH_save(TOUCH_Calib_t *c)
+{
+	HOST_MEM_READ_STR(REG_TOUCH_TRANSFORM_A, (uint8_t*)c->transform, sizeof(c->transform));
+	c->magic = TOUCH_MAGIC;
+	c->check = touch_check(c);
+}
+
+/*
+    Function: TOUCH_restore
+    ARGS:     c: calibration saved with TOUCH_save / TOUCH_calibrate
+
+    Description: Writes REG_TOUCH_TRANSFORM_A..F in one burst. Returns 0 and
+                 leaves the registers alone if the block is empty or corrupt,
+                 the caller should then run TOUCH_calibrate.
+*/
+uint8_t TOUCH_restore(const TOUCH_Calib_t *c)
+{
+	if(c->magic != TOUCH_MAGIC || c->check != touch_check(c)) return 0;
+
+	HOST_MEM_WR_STR(REG_TOUCH_TRANSFORM_A, (uint8_t*)c->transform, sizeof(c->transform));
+	return 1;
+}
+
+void TOUCH_calibrate(TOUCH_Calib_t *c)
+{
+	int16_t w = HOST_MEM_RD16(REG_HSIZE);
+	int16_t h = HOST_MEM_RD16(REG_VSIZE);
+
+	cmd(CMD_DLSTART);
+	cmd(CLEAR_COLOR_RGB(0,0,0));
+	cmd(CLEAR(1,1,1));
+	cmd(COLOR_RGB(255,255,255));
+	cmd_text(w/2, h/2, 27, OPT_CENTER, "Tap the dots");
+	cmd_calibrate();
+
+	TOUCH_save(c);
+}
+
+/*** Touch State *******************************************************************/
+/*
+    Function: TOUCH_read
+    ARGS:     s:     touch state
+              track: also read REG_TRACKER (for cmd_track controls)
+
+    Description: REG_TOUCH_RZ, REG_TOUCH_SCREEN_XY, REG_TOUCH_TAG_XY and
+                 REG_TOUCH_TAG are adjacent, so they are read in a single
+                 transaction. REG_TRACKER is in a different register block
+                 and costs a second transaction, so it is only read on request.
+*/
+void TOUCH_read(TOUCH_State_t *s, uint8_t track)
+{
+	uint8_t b[16];
+	uint32_t xy;
+
+	HOST_MEM_READ_STR(REG_TOUCH_RZ, b, 16);
+
+	xy = b[4] | (b[5]<<8) | ((uint32_t)b[6]<<16) | ((uint32_t)b[7]<<24);
+	s->rz = b[0] | (b[1]<<8);
+	s->touched = (xy != TOUCH_NONE);
+	s->x = (int16_t)(xy >> 16);
+	s->y = (int16_t)xy;
+	s->tag_y = (int16_t)(b[8] | (b[9]<<8));
+	s->tag_x = (int16_t)(b[10] | (b[11]<<8));
+	s->tag = b[12];
+
+	if(track)
+	{
+		uint32_t t = HOST_MEM_RD32(REG_TRACKER);
+
+		s->track_tag = (uint8_t)t;
+		s->track = (uint16_t)(t >> 16);
+	}
+}
+
+uint8_t TOUCH_update(TOUCH_State_t *s, GESTURE_t *g, uint32_t ms)
+{
+	TOUCH_read(s, 0);
+	s->event = GESTURE_update(g, s->touched, s->x, s->y, ms);
+	return s->event;
+}
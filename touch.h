@@ -0,0 +1,42 @@
+#ifndef TOUCH_H
+#define TOUCH_H
+
+/* Touch calibration and input
+ * The six REG_TOUCH_TRANSFORM_x words are saved into a checksummed block the
+ * application can keep in flash/EEPROM, and restored with one burst write at
+ * startup instead of running CMD_CALIBRATE again. Touch state is read with
+ * one multi-register transaction per frame and fed to the gesture recognizer.
+ */
+
+#include "gesture.h"
+
+#define TOUCH_MAGIC         0x4C414354UL    /* "TCAL" */
+#define TOUCH_NONE          0x80008000UL    /* REG_TOUCH_SCREEN_XY when not touched */
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t transform[6];		/* REG_TOUCH_TRANSFORM_A..F */
+	uint32_t check;
+} TOUCH_Calib_t;
+
+typedef struct
+{
+	uint8_t  touched;
+	int16_t  x, y;				/* REG_TOUCH_SCREEN_XY */
+	int16_t  tag_x, tag_y;		/* REG_TOUCH_TAG_XY */
+	uint8_t  tag;				/* REG_TOUCH_TAG */
+	uint16_t rz;				/* REG_TOUCH_RZ: resistance, 32767 when not touched */
+	uint8_t  track_tag;			/* REG_TRACKER (TOUCH_read with track = 1) */
+	uint16_t track;
+	uint8_t  event;				/* last GESTURE_x event of TOUCH_update */
+} TOUCH_State_t;
+
+void TOUCH_save(TOUCH_Calib_t *c);										/* read the current calibration */
+uint8_t TOUCH_restore(const TOUCH_Calib_t *c);							/* write back a saved calibration, 0 if it is invalid */
+void TOUCH_calibrate(TOUCH_Calib_t *c);									/* run CMD_CALIBRATE and save the result */
+
+void TOUCH_read(TOUCH_State_t *s, uint8_t track);						/* read the touch registers (and REG_TRACKER) */
+uint8_t TOUCH_update(TOUCH_State_t *s, GESTURE_t *g, uint32_t ms);		/* TOUCH_read + GESTURE_update, returns the event */
+
+#endif
@@ -0,0 +1,157 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    trace.c
+  * @brief   SPI trace recorder
+  *          This file contains a ring buffer that records every SPI
+  *          transaction sent to the FT800, for offline decoding.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include "stm32f4xx.h"
+#include "cycles.h"
+#include "trace.h"
+
+static uint8_t  trace_buf[TRACE_SIZE];
+static uint32_t trace_head;			/* next byte to write */
+static uint32_t trace_tail;			/* first byte of the oldest record */
+static uint32_t trace_used;			/* bytes in use */
+
+static uint8_t  trace_enabled;
+static uint8_t  trace_active;		/* a transaction is being recorded */
+static uint8_t  trace_read;			/* current transaction is a memory read */
+static uint32_t trace_rec;			/* header position of the current record */
+static uint16_t trace_len;			/* data bytes of the current record */
+static uint16_t trace_flags;
+
+/*** Ring Buffer *******************************************************************/
+static uint16_t trace_reclen(uint32_t pos)
+{
+	uint16_t len = trace_buf[(pos+5) % TRACE_SIZE] | ((uint16_t)trace_buf[(pos+6) % TRACE_SIZE] << 8);
+	return len & ~TRACE_TRUNCATED;
+}
+
+static void trace_put(uint8_t data)
+{
+	/* overwrite the oldest record(s) when the buffer is full */
+	if(trace_used == TRACE_SIZE)
+	{
+		uint32_t size = TRACE_HEADER + trace_reclen(trace_tail);
+		trace_tail = (trace_tail + size) % TRACE_SIZE;
+		trace_used -= size;
+	}
+
+	trace_buf[trace_head] = data;
+	trace_head = (trace_head + 1) % TRACE_SIZE;
+	++trace_used;
+}
+
+/*** Control ***********************************************************************/
+void TRACE_init(void)
+{
+	CYCLES_init();
+	TRACE_clear();
+	TRACE_enable(1);
+}
+
+void TRACE_enable(uint8_t enable)
+{
+	trace_enabled = enable;
+}
+
+void TRACE_clear(void)
+{
+	trace_head = 0;
+	trace_tail = 0;
+	trace_used = 0;
+	trace_active = 0;
+}
+
+/*
+    Function: TRACE_dump
+    ARGS:     out: output buffer
+              max: size of the output buffer
+
+    Description: Copies whole records, oldest first, into out. Returns the
+                 number of bytes copied. Should not be called while the FT800
+                 is selected.
+*/
+uint32_t TRACE_dump(uint8_t *out, uint32_t max)
+{
+	uint32_t pos = trace_tail;
+	uint32_t left = trace_used;
+	uint32_t n = 0;
+
+	while(left)
+	{
+		uint32_t size = TRACE_HEADER + trace_reclen(pos);
+		uint32_t i;
+
+		if(n + size > max) break;
+
+		for(i=0; i<size; ++i)
+		{
+			out[n++] = trace_buf[pos];
+			pos = (pos + 1) % TRACE_SIZE;
+		}
+		left -= size;
+	}
+	return n;
+}
+
+/*** Hooks *************************************************************************/
+void TRACE_begin(void)
+{
+	uint32_t ts;
+
+	if(!trace_enabled) return;
+
+	ts = CYCLES_now();
+	trace_rec = trace_head;
+	trace_len = 0;
+	trace_flags = 0;
+	trace_active = 1;
+
+	trace_put(TRACE_SYNC);
+	trace_put((uint8_t)ts);
+	trace_put((uint8_t)(ts>>8));
+	trace_put((uint8_t)(ts>>16));
+	trace_put((uint8_t)(ts>>24));
+	trace_put(0);						// length, patched in TRACE_end()
+	trace_put(0);
+}
+
+void TRACE_byte(uint8_t out, uint8_t in)
+{
+	if(!trace_active) return;
+
+	if(trace_len == 0)
+	{
+		trace_read = ((out & 0xC0) == 0x00);
+	}
+
+	if(trace_len >= TRACE_MAX_DATA)
+	{
+		trace_flags = TRACE_TRUNCATED;
+		return;
+	}
+
+	/* address + dummy byte are MOSI, the rest of a read is MISO */
+	trace_put((trace_read && trace_len >= 4) ? in : out);
+	++trace_len;
+}
+
+void TRACE_end(void)
+{
+	uint16_t len = trace_len | trace_flags;
+
+	if(!trace_active) return;
+
+	trace_buf[(trace_rec+5) % TRACE_SIZE] = (uint8_t)len;
+	trace_buf[(trace_rec+6) % TRACE_SIZE] = (uint8_t)(len>>8);
+	trace_active = 0;
+}
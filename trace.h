@@ -0,0 +1,35 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/* SPI trace recorder
+ *
+ * Every FT800 transaction (FT_spi_select .. FT_spi_deselect) is stored as one record:
+ *   byte 0     TRACE_SYNC
+ *   byte 1-4   timestamp (cycle counter, see cycles.h, little-endian)
+ *   byte 5-6   number of data bytes (little-endian, bit 15: record truncated)
+ *   byte 7-    data: MOSI bytes, for memory reads the bytes after the dummy byte are MISO
+ *
+ * The recorder is compiled into spi.c only if FT_TRACE is defined.
+ * tools/trace_decode.c turns a dump into readable HOST_MEM_x / cmd calls and
+ * can replay it into the FT800 model (tools/ftsim.c).
+ */
+
+#ifndef TRACE_SIZE
+#define TRACE_SIZE          4096            /* ring buffer size in bytes */
+#endif
+
+#define TRACE_SYNC          0xA5
+#define TRACE_HEADER        7
+#define TRACE_TRUNCATED     0x8000
+#define TRACE_MAX_DATA      (TRACE_SIZE/2 - TRACE_HEADER)   /* longer transactions are truncated */
+
+void TRACE_init(void);                          /* start cycle counter, clear and enable the recorder */
+void TRACE_enable(uint8_t enable);              /* pause / resume recording */
+void TRACE_clear(void);                         /* drop all records */
+uint32_t TRACE_dump(uint8_t *out, uint32_t max);    /* copy whole records (oldest first), returns bytes copied */
+
+void TRACE_begin(void);                         /* hook: FT800 selected */
+void TRACE_byte(uint8_t out, uint8_t in);       /* hook: byte exchanged */
+void TRACE_end(void);                           /* hook: FT800 deselected */
+
+#endif
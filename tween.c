@@ -0,0 +1,199 @@
+/**
+  ******************************************************************************
+  * C Library for FT800 EVE module
+  ******************************************************************************
+  * @author  Akos Pasztor    (http://akospasztor.com)
+  * @file    tween.c
+  * @brief   Tween engine
+  *          This file contains a frame clock driven animation engine with
+  *          fixed-point easing curves. Tweens are kept in parallel arrays
+  *          that are compacted when a tween ends, so an update is one pass
+  *          over the running tweens only.
+  ******************************************************************************
+  * Copyright (c) 2014 Akos Pasztor. All rights reserved.
+  ******************************************************************************
+**/
+
+#include "stm32f4xx.h"
+#include "ft800.h"
+#include "tween.h"
+
+#define T_ONE	65536L
+
+static int32_t *target[TWEEN_MAX];
+static int32_t from[TWEEN_MAX];
+static int32_t to[TWEEN_MAX];
+static uint32_t start[TWEEN_MAX];
+static uint32_t duration[TWEEN_MAX];
+static uint32_t rate[TWEEN_MAX];		/* 2^32 / duration, progress without a division */
+static uint8_t ease[TWEEN_MAX];
+static uint16_t count;
+static uint32_t tween_clock;
+
+/*** Helpers ***********************************************************************/
+static int32_t tween_find(const int32_t *value)
+{
+	uint16_t i;
+
+	for(i=0; i<count; ++i)
+	{
+		if(target[i] == value) return i;
+	}
+	return -1;
+}
+
+static void tween_remove(uint16_t i)
+{
+	--count;
+	target[i] = target[count];
+	from[i] = from[count];
+	to[i] = to[count];
+	start[i] = start[count];
+	duration[i] = duration[count];
+	rate[i] = rate[count];
+	ease[i] = ease[count];
+}
+
+static inline int32_t tween_lerp(int32_t a, int32_t b, int32_t e)
+{
+	return a + (int32_t)(((int64_t)(b - a) * e) >> 16);
+}
+
+static int32_t tween_value(uint16_t i, int32_t e)
+{
+	if(ease[i] & TWEEN_RGB)
+	{
+		int32_t r = tween_lerp((from[i]>>16) & 0xFF, (to[i]>>16) & 0xFF, e);
+		int32_t g = tween_lerp((from[i]>>8) & 0xFF, (to[i]>>8) & 0xFF, e);
+		int32_t b = tween_lerp(from[i] & 0xFF, to[i] & 0xFF, e);
+		return (r<<16) | (g<<8) | b;
+	}
+	return tween_lerp(from[i], to[i], e);
+}
+
+/*** Easing ************************************************************************/
+static inline int32_t fx_mul(int32_t x, int32_t y)
+{
+	return (int32_t)(((int64_t)x * y) >> 16);
+}
+
+int32_t TWEEN_ease(uint8_t curve, int32_t t)
+{
+	int32_t u = T_ONE - t;
+
+	if(t <= 0) return 0;
+	if(t >= T_ONE) return T_ONE;
+
+	switch(curve & TWEEN_EASE_MASK)
+	{
+		case TWEEN_IN_QUAD:      return fx_mul(t, t);
+		case TWEEN_OUT_QUAD:     return T_ONE - fx_mul(u, u);
+		case TWEEN_IN_OUT_QUAD:  return (t < T_ONE/2) ? 2*fx_mul(t, t) : T_ONE - 2*fx_mul(u, u);
+		case TWEEN_IN_CUBIC:     return fx_mul(fx_mul(t, t), t);
+		case TWEEN_OUT_CUBIC:    return T_ONE - fx_mul(fx_mul(u, u), u);
+		case TWEEN_IN_OUT_CUBIC: return (t < T_ONE/2) ? 4*fx_mul(fx_mul(t, t), t) : T_ONE - 4*fx_mul(fx_mul(u, u), u);
+		case TWEEN_SMOOTH:       return fx_mul(fx_mul(t, t), 3*T_ONE - 2*t);
+		default:                 return t;
+	}
+}
+
+/*** Control ***********************************************************************/
+void TWEEN_init(uint32_t now)
+{
+	count = 0;
+	tween_clock = now;
+}
+
+/*
+    Function: TWEEN_start
+    ARGS:     value:    animated property
+              to:       end value
+              delay:    clock ticks before the tween starts
+              duration: clock ticks of the animation
+              ease:     easing curve, optionally or-ed with TWEEN_RGB
+
+    Description: Animates *value from its current value, starting at the time
+                 of the last TWEEN_step. A running tween of the same property
+                 is replaced, so retargeting mid-animation is smooth.
+                 Returns 0 if TWEEN_MAX tweens are already running.
+*/
+uint8_t TWEEN_start(int32_t *value, int32_t end, uint32_t delay, uint32_t ticks, uint8_t curve)
+{
+	int32_t i = tween_find(value);
+
+	if(i < 0)
+	{
+		if(count >= TWEEN_MAX) return 0;
+		i = count++;
+	}
+
+	target[i] = value;
+	from[i] = *value;
+	to[i] = end;
+	start[i] = tween_clock + delay;
+	duration[i] = ticks;
+	rate[i] = ticks ? 0xFFFFFFFFUL / ticks : 0;
+	ease[i] = curve;
+	return 1;
+}
+
+void TWEEN_stop(int32_t *value, uint8_t finish)
+{
+	int32_t i = tween_find(value);
+
+	if(i < 0) return;
+	if(finish) *value = to[i];
+	tween_remove(i);
+}
+
+uint8_t TWEEN_busy(const int32_t *value)
+{
+	return (tween_find(value) >= 0) ? 1 : 0;
+}
+
+uint16_t TWEEN_active(void)
+{
+	return count;
+}
+
+/*
+    Function: TWEEN_step
+    ARGS:     now: current clock value
+
+    Description: Writes the current value of every running tween into its
+                 property and removes the finished ones. Returns 1 if any
+                 property changed, i.e. the display list has to be rebuilt.
+*/
+uint8_t TWEEN_step(uint32_t now)
+{
+	uint8_t changed = 0;
+	uint16_t i = 0;
+
+	tween_clock = now;
+
+	while(i < count)
+	{
+		int32_t elapsed = (int32_t)(now - start[i]);
+		int32_t v;
+
+		if(elapsed < 0) { ++i; continue; }			// delayed
+
+		if((uint32_t)elapsed >= duration[i])
+		{
+			v = to[i];
+			if(*target[i] != v) { *target[i] = v; changed = 1; }
+			tween_remove(i);
+			continue;
+		}
+
+		v = tween_value(i, TWEEN_ease(ease[i], (int32_t)(((uint64_t)elapsed * rate[i]) >> 16)));
+		if(*target[i] != v) { *target[i] = v; changed = 1; }
+		++i;
+	}
+	return changed;
+}
+
+uint8_t TWEEN_update(void)
+{
+	return TWEEN_step(HOST_MEM_RD32(REG_FRAMES));
+}
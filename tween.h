@@ -0,0 +1,40 @@
+#ifndef TWEEN_H
+#define TWEEN_H
+
+/* Tween engine
+ * Animates int32_t properties (positions, slider values, alpha, colours)
+ * from their current value to a target over a number of clock ticks.
+ * The clock is REG_FRAMES (TWEEN_update) or any counter passed to
+ * TWEEN_step, e.g. REG_CLOCK or a millisecond tick.
+ */
+
+#ifndef TWEEN_MAX
+#define TWEEN_MAX           256     /* concurrent tweens */
+#endif
+
+/* easing curves */
+#define TWEEN_LINEAR        0
+#define TWEEN_IN_QUAD       1
+#define TWEEN_OUT_QUAD      2
+#define TWEEN_IN_OUT_QUAD   3
+#define TWEEN_IN_CUBIC      4
+#define TWEEN_OUT_CUBIC     5
+#define TWEEN_IN_OUT_CUBIC  6
+#define TWEEN_SMOOTH        7       /* smoothstep */
+#define TWEEN_EASE_MASK     0x0F
+
+/* flags, or-ed to the easing curve */
+#define TWEEN_RGB           0x10    /* value is 0xRRGGBB, channels are interpolated separately */
+
+void TWEEN_init(uint32_t now);																/* remove all tweens, set the clock */
+uint8_t TWEEN_start(int32_t *value, int32_t to, uint32_t delay, uint32_t duration, uint8_t ease);	/* animate *value to 'to', replaces a running tween of *value */
+void TWEEN_stop(int32_t *value, uint8_t finish);											/* remove the tween of *value, optionally jumping to its end */
+uint8_t TWEEN_busy(const int32_t *value);													/* *value is being animated */
+uint16_t TWEEN_active(void);																/* number of running tweens */
+
+uint8_t TWEEN_step(uint32_t now);															/* advance all tweens to 'now', returns 1 if any value changed */
+uint8_t TWEEN_update(void);																	/* TWEEN_step with REG_FRAMES as the clock */
+
+int32_t TWEEN_ease(uint8_t ease, int32_t t);												/* easing curve, t and result in 16.16 (0..65536) */
+
+#endif